@@ -0,0 +1,88 @@
+// benchmark/bench_corpus.c
+//
+// Archive building blocks shared by the benchmarks (see bench_corpus.h).
+
+#include "bench_corpus.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+const unsigned char rar4_signature[RAR4_SIGNATURE_SIZE] = {0x52, 0x61, 0x72, 0x21, 0x1A, 0x07, 0x00};
+const unsigned char rar4_end_block[RAR4_END_BLOCK_SIZE] = {0xC4, 0x3D, 0x7B, 0x00, 0x40, 0x07, 0x00};
+
+static uint32_t crc_table[256];
+
+void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+}
+
+uint32_t crc_update(uint32_t crc, const unsigned char* p, size_t len) {
+    crc = ~crc;
+    while (len--) crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void put_le16(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+void put_le32(unsigned char* p, uint32_t v) {
+    put_le16(p, v & 0xFFFF);
+    put_le16(p + 2, v >> 16);
+}
+
+int write_all(int fd, const void* buf, size_t len) {
+    const unsigned char* p = (const unsigned char*)buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+void rar4_seal_block(unsigned char* out, const unsigned char* block, size_t len) {
+    put_le16(out, crc_update(0, block, len) & 0xFFFF);
+    memmove(out + 2, block, len);
+}
+
+void rar4_main_header(unsigned char* out, int solid) {
+    // HEAD_TYPE HEAD_FLAGS HEAD_SIZE RESERVED(6)
+    unsigned char block[RAR4_MAIN_HEADER_SIZE - 2];
+    memset(block, 0, sizeof(block));
+    block[0] = 0x73;
+    put_le16(block + 1, solid ? 0x0008 : 0);            // MHD_SOLID
+    put_le16(block + 3, RAR4_MAIN_HEADER_SIZE);
+    rar4_seal_block(out, block, sizeof(block));
+}
+
+void rar4_file_header(unsigned char* out, const char* name, size_t name_len,
+                      uint32_t size, uint32_t data_crc) {
+    size_t head_size = RAR4_FILE_HEADER_SIZE(name_len);
+
+    // Built in place after the two HEAD_CRC bytes, then sealed over itself
+    unsigned char* block = out + 2;
+    memset(block, 0, 30);
+    block[0] = 0x74;
+    put_le16(block + 1, 0x8000);
+    put_le16(block + 3, (uint32_t)head_size);
+    put_le32(block + 5, size);                          // PACK_SIZE
+    put_le32(block + 9, size);                          // UNP_SIZE
+    block[13] = 3;                                      // HOST_OS: Unix
+    put_le32(block + 14, data_crc);
+    put_le32(block + 18, 0x5A210000);                   // FTIME (DOS)
+    block[22] = 20;                                     // UNP_VER
+    block[23] = 0x30;                                   // METHOD: store
+    put_le16(block + 24, (uint32_t)name_len);
+    put_le32(block + 26, 0100644);
+    memcpy(block + 30, name, name_len);
+    rar4_seal_block(out, block, head_size - 2);
+}
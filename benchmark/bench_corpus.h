@@ -0,0 +1,57 @@
+// benchmark/bench_corpus.h
+//
+// Building blocks for the stored (uncompressed) test archives the benchmarks
+// generate: CRC32, little-endian fields and RAR4 headers. Entry data is
+// written by the caller, so each generator picks its own contents.
+// rar_filter_test builds its archive with it too.
+
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the RAR4 signature, main header and end-of-archive block
+#define RAR4_SIGNATURE_SIZE 7
+#define RAR4_MAIN_HEADER_SIZE 13
+#define RAR4_END_BLOCK_SIZE 7
+
+// Size of a RAR4 file header for a name of `name_len` bytes
+#define RAR4_FILE_HEADER_SIZE(name_len) (32 + (size_t)(name_len))
+
+extern const unsigned char rar4_signature[RAR4_SIGNATURE_SIZE];
+extern const unsigned char rar4_end_block[RAR4_END_BLOCK_SIZE];
+
+// Fills the CRC32 table; call once before crc_update
+void crc_init(void);
+uint32_t crc_update(uint32_t crc, const unsigned char* p, size_t len);
+
+void put_le16(unsigned char* p, uint32_t v);
+void put_le32(unsigned char* p, uint32_t v);
+
+// Writes all of `buf`, retrying short writes; returns 0 or -1
+int write_all(int fd, const void* buf, size_t len);
+
+// RAR4 block: HEAD_CRC (low 16 bits of the CRC32 of the rest), then `block`,
+// which holds the header from HEAD_TYPE on. `out` receives len + 2 bytes.
+void rar4_seal_block(unsigned char* out, const unsigned char* block, size_t len);
+
+// Writes a sealed main header (MHD_SOLID if `solid`) of
+// RAR4_MAIN_HEADER_SIZE bytes to `out`
+void rar4_main_header(unsigned char* out, int solid);
+
+// Writes a sealed header for a stored file of `size` bytes whose data has
+// CRC32 `data_crc`; `out` receives RAR4_FILE_HEADER_SIZE(name_len) bytes.
+// Sizes must fit in 32 bits.
+void rar4_file_header(unsigned char* out, const char* name, size_t name_len,
+                      uint32_t size, uint32_t data_crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // BENCH_CORPUS_H
@@ -0,0 +1,249 @@
+// benchmark/rar_extract_bench.c
+//
+// Measures the per-entry cost of extraction.
+//
+// Each archive is extracted into a fresh directory with both write modes:
+//   faithful  - RAR_WRITE_FAITHFUL, everything through archive_write_disk
+//   fast      - RAR_WRITE_FAST, regular files through our own descriptors
+//
+// With many small entries the time is dominated by per-entry work (path
+// building, directory creation, file creation and metadata), which is what
+// this benchmark is for. Deleting the output is not timed.
+//
+// On glibc the benchmark also counts heap allocations (malloc, calloc and
+// realloc calls by this library, libarchive and libc) made during each
+// extraction and reports them per entry.
+//
+// Build (from the repository root):
+//   cc -O2 -Isrc -o rar_extract_bench benchmark/rar_extract_bench.c benchmark/bench_corpus.c src/rar_native.c -larchive -lpthread
+//   or cmake -S benchmark -B build/bench && cmake --build build/bench
+//
+// Usage:
+//   rar_extract_bench [--iterations N] [--dest DIR] [--entries N] [--entry-size BYTES] [archive.rar...]
+//
+// Without archives it generates a stored RAR4 archive under --dest of
+// --entries files (default 100000) of --entry-size bytes (default 0) in one
+// directory, measures it and deletes it.
+
+#define _XOPEN_SOURCE 700
+
+#include "rar_native.h"
+#include "bench_corpus.h"
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// Allocation counter
+// ---------------------------------------------------------------------------
+
+#if defined(__GLIBC__)
+// glibc lets a program replace malloc; these count the calls and forward
+// to glibc's own allocator, so memalign and friends stay compatible
+#define HAVE_ALLOC_COUNT 1
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+static int64_t alloc_count;
+
+void* malloc(size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+static int64_t allocations(void) {
+    return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+}
+#else
+#define HAVE_ALLOC_COUNT 0
+
+static int64_t allocations(void) {
+    return 0;
+}
+#endif
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int remove_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+static void remove_tree(const char* path) {
+    nftw(path, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+}
+
+// Writes `entries` stored files named data/NNNNNN.bin whose data is left
+// sparse (all zeros)
+static int generate_archive(const char* path, long entries, uint32_t entry_size) {
+    unsigned char block[RAR4_FILE_HEADER_SIZE(32)];
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    static const unsigned char zeros[4096];
+    uint32_t data_crc = 0;
+    for (uint32_t left = entry_size; left > 0;) {
+        size_t n = left < sizeof(zeros) ? left : sizeof(zeros);
+        data_crc = crc_update(data_crc, zeros, n);
+        left -= (uint32_t)n;
+    }
+
+    int failed = write_all(fd, rar4_signature, RAR4_SIGNATURE_SIZE);
+    rar4_main_header(block, 0);
+    failed = failed || write_all(fd, block, RAR4_MAIN_HEADER_SIZE);
+    for (long i = 0; i < entries && !failed; i++) {
+        char name[32];
+        int name_len = snprintf(name, sizeof(name), "data/%06ld.bin", i);
+        rar4_file_header(block, name, (size_t)name_len, entry_size, data_crc);
+        failed = write_all(fd, block, RAR4_FILE_HEADER_SIZE(name_len)) ||
+                 lseek(fd, (off_t)entry_size, SEEK_CUR) < 0;
+    }
+    failed = failed || write_all(fd, rar4_end_block, RAR4_END_BLOCK_SIZE);
+    if (close(fd) != 0) failed = 1;
+    if (failed) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+static int64_t entry_count;
+
+static void count_entry(const char* filename) {
+    (void)filename;
+    entry_count++;
+}
+
+static void bench_archive(const char* path, const char* dest_root, int iterations) {
+    static const char* modes[] = {"faithful", "fast"};
+
+    entry_count = 0;
+    if (rar_list(path, NULL, count_entry, NULL) != RAR_SUCCESS) {
+        printf("%s: cannot list archive\n", path);
+        return;
+    }
+    printf("%s (%lld entries), %d iteration(s) per mode\n", path, (long long)entry_count, iterations);
+
+    for (int m = 0; m < 2; m++) {
+        rar_options options;
+        rar_options_init(&options);
+        options.write_mode = m == 0 ? RAR_WRITE_FAITHFUL : RAR_WRITE_FAST;
+
+        double seconds = 0;
+        int64_t allocs = 0;
+        int failed = 0;
+        for (int i = 0; i < iterations && !failed; i++) {
+            char dest[4096];
+            snprintf(dest, sizeof(dest), "%s/rar_extract_bench.XXXXXX", dest_root);
+            if (!mkdtemp(dest)) {
+                perror(dest);
+                return;
+            }
+
+            int64_t allocs_before = allocations();
+            double start = now_seconds();
+            int r = rar_extract_ex(path, dest, NULL, &options, NULL);
+            seconds += now_seconds() - start;
+            allocs += allocations() - allocs_before;
+
+            if (r != RAR_SUCCESS) {
+                printf("  %-9s failed: %s\n", modes[m], rar_get_error_message(r));
+                failed = 1;
+            }
+            remove_tree(dest);
+        }
+        if (failed) continue;
+
+        double ms = seconds * 1000.0 / iterations;
+        double per_entry_us = entry_count > 0 ? seconds * 1e6 / iterations / (double)entry_count : 0;
+        double entries_per_s = seconds > 0 ? (double)entry_count * iterations / seconds : 0;
+        printf("  %-9s %10.3f ms  %8.2f us/entry  %12.0f entries/s", modes[m], ms, per_entry_us, entries_per_s);
+        if (HAVE_ALLOC_COUNT && entry_count > 0) {
+            printf("  %8.2f allocs/entry", (double)allocs / iterations / (double)entry_count);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = 3;
+    const char* dest_root = "/tmp";
+    long entries = 100000;
+    long entry_size = 0;
+    int first = 1;
+
+    while (first + 1 < argc) {
+        if (strcmp(argv[first], "--iterations") == 0) {
+            iterations = atoi(argv[first + 1]);
+            if (iterations < 1) iterations = 1;
+        } else if (strcmp(argv[first], "--dest") == 0) {
+            dest_root = argv[first + 1];
+        } else if (strcmp(argv[first], "--entries") == 0) {
+            entries = atol(argv[first + 1]);
+        } else if (strcmp(argv[first], "--entry-size") == 0) {
+            entry_size = atol(argv[first + 1]);
+        } else {
+            break;
+        }
+        first += 2;
+    }
+    if ((first < argc && argv[first][0] == '-') || entries < 1 || entry_size < 0 ||
+        (unsigned long)entry_size > 0xFFFFFFFFu) {
+        fprintf(stderr,
+                "usage: %s [--iterations N] [--dest DIR] [--entries N] [--entry-size BYTES] "
+                "[archive.rar...]\n",
+                argv[0]);
+        return 2;
+    }
+
+    if (first < argc) {
+        for (int i = first; i < argc; i++) bench_archive(argv[i], dest_root, iterations);
+        return 0;
+    }
+
+    char dir[4096];
+    char path[sizeof(dir) + 16];
+    snprintf(dir, sizeof(dir), "%s/rar_extract_bench.XXXXXX", dest_root);
+    if (!mkdtemp(dir)) {
+        perror(dir);
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s/generated.rar", dir);
+
+    crc_init();
+    int status = generate_archive(path, entries, (uint32_t)entry_size) == 0 ? 0 : 1;
+    if (status == 0) bench_archive(path, dest_root, iterations);
+    remove_tree(dir);
+    return status;
+}
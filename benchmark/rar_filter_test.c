@@ -0,0 +1,197 @@
+// benchmark/rar_filter_test.c
+//
+// Checks which entries rar_extract_ex writes for a table of rar_filter
+// settings. The archive is a stored RAR4 file built with bench_corpus, so
+// the test needs no fixtures; it exits non-zero if any case fails.
+//
+// Build (from the repository root):
+//   cc -O2 -Isrc -o rar_filter_test benchmark/rar_filter_test.c benchmark/bench_corpus.c src/rar_native.c -larchive -lpthread
+//   or cmake -S benchmark -B build/bench && cmake --build build/bench && ctest --test-dir build/bench
+
+#include "rar_native.h"
+#include "bench_corpus.h"
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Entries of the test archive. Each one holds its own name, so its size is
+// the name's length.
+static const char* const entries[] = {
+    "photos/a.jpg", "photos/sub/b.jpg", "photos2/c.jpg", "top.jpg",
+    "docs/readme.txt", "docs/]x.txt", "docs/[a.txt", "notes.txt",
+};
+#define ENTRY_COUNT (sizeof(entries) / sizeof(entries[0]))
+
+typedef struct {
+    const char* name;
+    const char* include[2];  // Unused slots are NULL
+    const char* exclude[2];
+    const char* prefix;
+    uint64_t max_size;
+    const char* expected[ENTRY_COUNT + 1];  // NULL-terminated
+} filter_case;
+
+static const filter_case cases[] = {
+    {"no filter", {NULL}, {NULL}, NULL, 0,
+     {"photos/a.jpg", "photos/sub/b.jpg", "photos2/c.jpg", "top.jpg",
+      "docs/readme.txt", "docs/]x.txt", "docs/[a.txt", "notes.txt"}},
+    // Without a '/' only the last component is matched
+    {"base name", {"*.jpg"}, {NULL}, NULL, 0,
+     {"photos/a.jpg", "photos/sub/b.jpg", "photos2/c.jpg", "top.jpg"}},
+    // "*" stays within one component
+    {"star stops at separator", {"*/*.jpg"}, {NULL}, NULL, 0,
+     {"photos/a.jpg", "photos2/c.jpg"}},
+    {"deep matches no directory", {"**/*.jpg"}, {NULL}, NULL, 0,
+     {"photos/a.jpg", "photos/sub/b.jpg", "photos2/c.jpg", "top.jpg"}},
+    {"deep inside pattern", {"photos/**/*.jpg"}, {NULL}, NULL, 0,
+     {"photos/a.jpg", "photos/sub/b.jpg"}},
+    {"question mark", {"photos?/*"}, {NULL}, NULL, 0, {"photos2/c.jpg"}},
+    // A ']' right after '[' belongs to the set
+    {"bracket first in set", {"[]]*"}, {NULL}, NULL, 0, {"docs/]x.txt"}},
+    {"negated set", {"[!n]*.txt"}, {NULL}, NULL, 0,
+     {"docs/readme.txt", "docs/]x.txt", "docs/[a.txt"}},
+    {"range", {"[m-z]*"}, {NULL}, NULL, 0,
+     {"docs/readme.txt", "top.jpg", "notes.txt"}},
+    // An unclosed '[' is a literal character
+    {"unclosed bracket", {"[a.txt"}, {NULL}, NULL, 0, {"docs/[a.txt"}},
+    {"escaped bracket", {"docs/\\[*"}, {NULL}, NULL, 0, {"docs/[a.txt"}},
+    {"two includes", {"top.*", "notes.*"}, {NULL}, NULL, 0,
+     {"top.jpg", "notes.txt"}},
+    {"exclude", {"*.txt"}, {"docs/*"}, NULL, 0, {"notes.txt"}},
+    // A prefix ends on a component boundary
+    {"prefix", {NULL}, {NULL}, "photos", 0,
+     {"photos/a.jpg", "photos/sub/b.jpg"}},
+    {"prefix with separator", {NULL}, {NULL}, "photos/", 0,
+     {"photos/a.jpg", "photos/sub/b.jpg"}},
+    {"prefix and exclude", {NULL}, {"b.jpg"}, "photos", 0, {"photos/a.jpg"}},
+    {"max size", {NULL}, {NULL}, NULL, 9, {"top.jpg", "notes.txt"}},
+};
+
+static int write_archive(const char* path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    unsigned char header[RAR4_FILE_HEADER_SIZE(64)];
+    int failed = write_all(fd, rar4_signature, RAR4_SIGNATURE_SIZE);
+    rar4_main_header(header, 0);
+    failed = failed || write_all(fd, header, RAR4_MAIN_HEADER_SIZE);
+    for (size_t i = 0; i < ENTRY_COUNT && !failed; i++) {
+        const unsigned char* data = (const unsigned char*)entries[i];
+        size_t len = strlen(entries[i]);
+        rar4_file_header(header, entries[i], len, (uint32_t)len, crc_update(0, data, len));
+        failed = write_all(fd, header, RAR4_FILE_HEADER_SIZE(len)) || write_all(fd, data, len);
+    }
+    failed = failed || write_all(fd, rar4_end_block, RAR4_END_BLOCK_SIZE);
+    return close(fd) == 0 && !failed ? 0 : -1;
+}
+
+static unsigned entry_bit(const char* name) {
+    for (size_t i = 0; i < ENTRY_COUNT; i++) {
+        if (strcmp(entries[i], name) == 0) return 1u << i;
+    }
+    return 0;
+}
+
+// Files collect_file finds below the destination, one bit per entry;
+// anything that is not an entry sets collect_stray
+static size_t collect_root_len;
+static unsigned collect_found;
+static int collect_stray;
+
+static int collect_file(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)ftw;
+    if (type != FTW_F) return 0;
+    unsigned bit = entry_bit(path + collect_root_len + 1);
+    if (bit == 0) {
+        printf("    unexpected file %s\n", path);
+        collect_stray = 1;
+    }
+    collect_found |= bit;
+    return 0;
+}
+
+static int remove_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+static void print_entries(const char* label, unsigned mask) {
+    printf("    %s:", label);
+    for (size_t i = 0; i < ENTRY_COUNT; i++) {
+        if (mask & (1u << i)) printf(" %s", entries[i]);
+    }
+    printf("\n");
+}
+
+static int run_case(const filter_case* c, const char* archive, const char* dest) {
+    rar_filter filter;
+    memset(&filter, 0, sizeof(filter));
+    while (filter.include_count < 2 && c->include[filter.include_count]) filter.include_count++;
+    while (filter.exclude_count < 2 && c->exclude[filter.exclude_count]) filter.exclude_count++;
+    filter.include = filter.include_count ? c->include : NULL;
+    filter.exclude = filter.exclude_count ? c->exclude : NULL;
+    filter.prefix = c->prefix;
+    filter.max_size = c->max_size;
+
+    rar_options options;
+    rar_options_init(&options);
+    options.filter = &filter;
+
+    int r = rar_extract_ex(archive, dest, NULL, &options, NULL);
+    if (r != RAR_SUCCESS) {
+        printf("FAIL %s: %s\n", c->name, rar_get_error_message(r));
+        return 1;
+    }
+
+    unsigned expected = 0;
+    for (const char* const* name = c->expected; *name; name++) expected |= entry_bit(*name);
+
+    collect_root_len = strlen(dest);
+    collect_found = 0;
+    collect_stray = 0;
+    nftw(dest, collect_file, 16, FTW_PHYS);
+    nftw(dest, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+    if (collect_found != expected || collect_stray) {
+        printf("FAIL %s\n", c->name);
+        print_entries("expected", expected);
+        print_entries("written ", collect_found);
+        return 1;
+    }
+    printf("ok   %s\n", c->name);
+    return 0;
+}
+
+int main(void) {
+    char root[] = "/tmp/rar_filter_test.XXXXXX";
+    if (!mkdtemp(root)) {
+        perror(root);
+        return 2;
+    }
+    char archive[64];
+    char dest[64];
+    snprintf(archive, sizeof(archive), "%s/filter.rar", root);
+    snprintf(dest, sizeof(dest), "%s/out", root);
+
+    crc_init();
+    int failures = 0;
+    if (write_archive(archive) != 0) {
+        perror(archive);
+        failures = 1;
+    } else {
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+            failures += run_case(&cases[i], archive, dest);
+        }
+    }
+
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    printf("%d failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
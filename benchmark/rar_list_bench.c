@@ -0,0 +1,290 @@
+// benchmark/rar_list_bench.c
+//
+// Measures how many bytes a header-only listing pulls from the archive.
+//
+// Four readers list the same archive:
+//   stream    - libarchive over a read-only callback (no skip/seek), which
+//               has to read through every entry's data
+//   filename  - archive_read_open_filename, the reader rar_list used before
+//   rar_list  - this library's reader (mapped input, skip/seek callbacks)
+//   rar_read  - rar_list_ex with RAR_IO_READ (buffered reads, skip/seek)
+//
+// Bytes read come from rchar in /proc/self/io and bytes mapped in from page
+// faults, so the I/O columns are only filled in on Linux.
+//
+// Build (from the repository root):
+//   cc -O2 -Isrc -o rar_list_bench benchmark/rar_list_bench.c benchmark/bench_corpus.c src/rar_native.c -larchive -lpthread
+//   or cmake -S benchmark -B build/bench && cmake --build build/bench
+//
+// Usage:
+//   rar_list_bench [--iterations N] archive.rar...
+//   rar_list_bench --generate out.rar ENTRIES ENTRY_SIZE
+//
+// --generate writes a stored (uncompressed) RAR4 archive whose entry data is
+// left sparse, which makes multi-GB test archives cheap to create.
+
+#include "rar_native.h"
+#include "bench_corpus.h"
+
+#include <archive.h>
+#include <archive_entry.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define STREAM_BUFFER_SIZE 65536
+
+// ---------------------------------------------------------------------------
+// Counters
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int64_t rchar;          // Bytes returned by read-family syscalls, -1 if unknown
+    int64_t faults;         // Minor + major page faults
+    double seconds;
+} io_sample;
+
+static int64_t read_rchar(void) {
+    FILE* f = fopen("/proc/self/io", "r");
+    if (!f) return -1;
+
+    char line[128];
+    long long value = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "rchar: %lld", &value) == 1) break;
+    }
+    fclose(f);
+    return value;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void sample(io_sample* s) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    s->rchar = read_rchar();
+    s->faults = (int64_t)ru.ru_minflt + (int64_t)ru.ru_majflt;
+    s->seconds = now_seconds();
+}
+
+// ---------------------------------------------------------------------------
+// Readers
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int fd;
+    unsigned char buf[STREAM_BUFFER_SIZE];
+} stream_client;
+
+static la_ssize_t stream_read(struct archive* a, void* client_data, const void** buff) {
+    stream_client* c = (stream_client*)client_data;
+    ssize_t n;
+    do {
+        n = read(c->fd, c->buf, sizeof(c->buf));
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        archive_set_error(a, errno, "Read error");
+        return -1;
+    }
+    *buff = c->buf;
+    return n;
+}
+
+static int stream_close(struct archive* a, void* client_data) {
+    (void)a;
+    stream_client* c = (stream_client*)client_data;
+    close(c->fd);
+    free(c);
+    return ARCHIVE_OK;
+}
+
+// Lists through libarchive directly; returns the entry count or -1
+static int64_t list_with_libarchive(const char* path, int use_filename) {
+    struct archive* a = archive_read_new();
+    struct archive_entry* entry;
+    int r;
+
+    archive_read_support_format_rar(a);
+    archive_read_support_format_rar5(a);
+
+    if (use_filename) {
+        r = archive_read_open_filename(a, path, STREAM_BUFFER_SIZE);
+    } else {
+        stream_client* c = malloc(sizeof(stream_client));
+        if (!c) {
+            archive_read_free(a);
+            return -1;
+        }
+        c->fd = open(path, O_RDONLY);
+        if (c->fd < 0) {
+            free(c);
+            archive_read_free(a);
+            return -1;
+        }
+        r = archive_read_open(a, c, NULL, stream_read, stream_close);
+    }
+    if (r != ARCHIVE_OK) {
+        archive_read_free(a);
+        return -1;
+    }
+
+    int64_t count = 0;
+    while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
+        archive_read_data_skip(a);
+        count++;
+    }
+    archive_read_free(a);
+    return r == ARCHIVE_EOF ? count : -1;
+}
+
+static int64_t rar_list_count;
+
+static void count_entry(const char* filename) {
+    (void)filename;
+    rar_list_count++;
+}
+
+static int64_t list_with_rar_native(const char* path, int io_mode) {
+    rar_options options;
+    rar_options_init(&options);
+    options.io_mode = io_mode;
+
+    rar_list_count = 0;
+    int r = rar_list_ex(path, NULL, &options, count_entry, NULL);
+    return r == RAR_SUCCESS ? rar_list_count : -1;
+}
+
+// ---------------------------------------------------------------------------
+// Archive generator
+// ---------------------------------------------------------------------------
+
+static int generate_archive(const char* path, long entries, uint64_t entry_size) {
+    unsigned char block[RAR4_FILE_HEADER_SIZE(32)];
+
+    if (entry_size > 0xFFFFFFFFu) {
+        fprintf(stderr, "entry size must fit in 32 bits\n");
+        return 1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    // Entry data is all zeros; its CRC is the same for every entry
+    static unsigned char zeros[STREAM_BUFFER_SIZE];
+    uint32_t data_crc = 0;
+    for (uint64_t left = entry_size; left > 0;) {
+        size_t n = left < sizeof(zeros) ? (size_t)left : sizeof(zeros);
+        data_crc = crc_update(data_crc, zeros, n);
+        left -= n;
+    }
+
+    int failed = write_all(fd, rar4_signature, RAR4_SIGNATURE_SIZE);
+    rar4_main_header(block, 0);
+    failed = failed || write_all(fd, block, RAR4_MAIN_HEADER_SIZE);
+
+    for (long i = 0; i < entries && !failed; i++) {
+        char name[32];
+        int name_len = snprintf(name, sizeof(name), "data/%06ld.bin", i);
+
+        rar4_file_header(block, name, (size_t)name_len, (uint32_t)entry_size, data_crc);
+        failed = write_all(fd, block, RAR4_FILE_HEADER_SIZE(name_len)) ||
+                 lseek(fd, (off_t)entry_size, SEEK_CUR) < 0;
+    }
+
+    failed = failed || write_all(fd, rar4_end_block, RAR4_END_BLOCK_SIZE);
+    if (close(fd) != 0) failed = 1;
+    if (failed) {
+        perror(path);
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Driver
+// ---------------------------------------------------------------------------
+
+static void print_row(const char* reader, int64_t entries, const io_sample* a, const io_sample* b,
+                      int iterations, long page_size) {
+    double ms = (b->seconds - a->seconds) * 1000.0 / iterations;
+    double faulted = (double)(b->faults - a->faults) * (double)page_size / iterations;
+
+    if (a->rchar >= 0 && b->rchar >= 0) {
+        double read_bytes = (double)(b->rchar - a->rchar) / iterations;
+        printf("  %-10s %8lld entries  %14.0f bytes read  %14.0f bytes faulted  %9.3f ms\n",
+               reader, (long long)entries, read_bytes, faulted, ms);
+    } else {
+        printf("  %-10s %8lld entries  %14s bytes read  %14.0f bytes faulted  %9.3f ms\n",
+               reader, (long long)entries, "n/a", faulted, ms);
+    }
+}
+
+static void bench_archive(const char* path, int iterations) {
+    static const char* readers[] = {"stream", "filename", "rar_list", "rar_read"};
+    long page_size = sysconf(_SC_PAGESIZE);
+    struct stat st;
+
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return;
+    }
+    printf("%s (%lld bytes), %d iteration(s) per reader\n", path, (long long)st.st_size, iterations);
+
+    for (int r = 0; r < 4; r++) {
+        io_sample before, after;
+        int64_t entries = 0;
+
+        sample(&before);
+        for (int i = 0; i < iterations && entries >= 0; i++) {
+            entries = r >= 2 ? list_with_rar_native(path, r == 2 ? RAR_IO_AUTO : RAR_IO_READ)
+                             : list_with_libarchive(path, r == 1);
+        }
+        sample(&after);
+
+        if (entries < 0) {
+            printf("  %-10s failed\n", readers[r]);
+            continue;
+        }
+        print_row(readers[r], entries, &before, &after, iterations, page_size);
+    }
+}
+
+int main(int argc, char** argv) {
+    int iterations = 5;
+    int first = 1;
+
+    crc_init();
+
+    if (argc == 5 && strcmp(argv[1], "--generate") == 0) {
+        return generate_archive(argv[2], atol(argv[3]), strtoull(argv[4], NULL, 10));
+    }
+    if (argc > 2 && strcmp(argv[1], "--iterations") == 0) {
+        iterations = atoi(argv[2]);
+        if (iterations < 1) iterations = 1;
+        first = 3;
+    }
+    if (first >= argc) {
+        fprintf(stderr,
+                "usage: %s [--iterations N] archive.rar...\n"
+                "       %s --generate out.rar ENTRIES ENTRY_SIZE\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+
+    for (int i = first; i < argc; i++) bench_archive(argv[i], iterations);
+    return 0;
+}
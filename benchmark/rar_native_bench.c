@@ -0,0 +1,602 @@
+// benchmark/rar_native_bench.c
+//
+// Throughput benchmark for rar_native.c, with JSON output for regression
+// tracking.
+//
+// Every archive is measured with three operations:
+//   list     - rar_list_ex, headers only
+//   extract  - rar_extract_ex into a fresh directory (removal not timed)
+//   memory   - rar_open, then rar_extract_entry_to_buffer for every entry
+//
+// Each operation runs in a forked child so that its peak RSS is its own.
+// Reported per operation: seconds (mean and best of the iterations), MB/s
+// of unpacked data, entries/s, peak RSS, read/write syscall counts and
+// bytes from /proc/self/io (Linux only, -1 elsewhere) and page faults.
+//
+// The fixed corpus written by --generate holds stored (uncompressed)
+// archives with deterministic contents:
+//   small4.rar / small5.rar   20000 entries of 1 KiB, RAR4 / RAR5
+//   huge4.rar  / huge5.rar    3 entries of 64 MiB, RAR4 / RAR5
+//   solid4.rar / solid5.rar   2000 entries of 4 KiB, RAR4 / RAR5, marked
+//                             solid in the main header
+// The solid archives take every solid code path of this library (no
+// parallel extraction, no jumping to an entry); their entries are stored,
+// so libarchive needs no solid dictionary for them.
+// Compressed and encrypted archives cannot be written without a RAR
+// encoder; pass them as extra arguments (with --password) to include them.
+//
+// Build with CMake (see benchmark/CMakeLists.txt), or from the repository
+// root:
+//   cc -O2 -Isrc -o rar_native_bench benchmark/rar_native_bench.c benchmark/bench_corpus.c src/rar_native.c -larchive -lpthread
+//
+// Usage:
+//   rar_native_bench --generate DIR
+//   rar_native_bench [--iterations N] [--dest DIR] [--password PW] [--json]
+//                    [--output FILE] [--corpus DIR] [archive.rar...]
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE     // wait4 on glibc
+#define _DARWIN_C_SOURCE    // wait4 on macOS
+
+#include "rar_native.h"
+#include "bench_corpus.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CHUNK_SIZE (1024 * 1024)
+#define MAX_ARCHIVES 64
+
+// ---------------------------------------------------------------------------
+// Corpus generator
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char* name;
+    int version;            // 4 or 5
+    int solid;
+    long entries;
+    uint64_t entry_size;
+} corpus_archive;
+
+static const corpus_archive corpus[] = {
+    {"small4.rar", 4, 0, 20000, 1024},
+    {"small5.rar", 5, 0, 20000, 1024},
+    {"huge4.rar", 4, 0, 3, 64 * 1024 * 1024},
+    {"huge5.rar", 5, 0, 3, 64 * 1024 * 1024},
+    {"solid4.rar", 4, 1, 2000, 4096},
+    {"solid5.rar", 5, 1, 2000, 4096},
+};
+
+#define CORPUS_COUNT (sizeof(corpus) / sizeof(corpus[0]))
+
+// Appends a RAR5 vint; returns its length
+static size_t put_vint(unsigned char* p, uint64_t v) {
+    size_t n = 0;
+    do {
+        unsigned char b = (unsigned char)(v & 0x7F);
+        v >>= 7;
+        p[n++] = v ? (unsigned char)(b | 0x80) : b;
+    } while (v);
+    return n;
+}
+
+// Deterministic entry contents: xorshift64 seeded by the entry index
+static void fill_data(unsigned char* p, size_t len, uint64_t* state) {
+    for (size_t i = 0; i < len; i += 8) {
+        uint64_t x = *state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        *state = x;
+        for (size_t k = 0; k < 8 && i + k < len; k++) p[i + k] = (unsigned char)(x >> (8 * k));
+    }
+}
+
+// Writes one entry's data and returns its CRC32 through `crc`
+static int write_entry_data(int fd, long index, uint64_t size, unsigned char* chunk, uint32_t* crc) {
+    uint64_t state = 0x9E3779B97F4A7C15ull ^ (uint64_t)(index + 1);
+    *crc = 0;
+    while (size > 0) {
+        size_t n = size < CHUNK_SIZE ? (size_t)size : CHUNK_SIZE;
+        fill_data(chunk, n, &state);
+        *crc = crc_update(*crc, chunk, n);
+        if (write_all(fd, chunk, n) != 0) return -1;
+        size -= n;
+    }
+    return 0;
+}
+
+// RAR5 block: CRC32, header size vint, then the header
+static size_t seal_rar5_block(unsigned char* out, const unsigned char* header, size_t len) {
+    size_t n = put_vint(out + 4, len);
+    memcpy(out + 4 + n, header, len);
+    put_le32(out, crc_update(0, out + 4, n + len));
+    return 4 + n + len;
+}
+
+static int generate_rar4(int fd, const corpus_archive* c, unsigned char* chunk) {
+    unsigned char out[RAR4_FILE_HEADER_SIZE(32)];
+
+    if (write_all(fd, rar4_signature, RAR4_SIGNATURE_SIZE) != 0) return -1;
+    rar4_main_header(out, c->solid);
+    if (write_all(fd, out, RAR4_MAIN_HEADER_SIZE) != 0) return -1;
+
+    for (long i = 0; i < c->entries; i++) {
+        char name[32];
+        int name_len = snprintf(name, sizeof(name), "data/%06ld.bin", i);
+        size_t head_size = RAR4_FILE_HEADER_SIZE(name_len);
+
+        // The header holds the data CRC, so it is written after the data
+        off_t head_at = lseek(fd, (off_t)head_size, SEEK_CUR) - (off_t)head_size;
+        uint32_t data_crc;
+        if (head_at < 0 || write_entry_data(fd, i, c->entry_size, chunk, &data_crc) != 0) return -1;
+
+        rar4_file_header(out, name, (size_t)name_len, (uint32_t)c->entry_size, data_crc);
+        if (pwrite(fd, out, head_size, head_at) != (ssize_t)head_size) return -1;
+    }
+    return write_all(fd, rar4_end_block, RAR4_END_BLOCK_SIZE);
+}
+
+static int generate_rar5(int fd, const corpus_archive* c, unsigned char* chunk) {
+    static const unsigned char signature[] = {0x52, 0x61, 0x72, 0x21, 0x1A, 0x07, 0x01, 0x00};
+    unsigned char header[96], out[112];
+    size_t n, len;
+
+    if (write_all(fd, signature, sizeof(signature)) != 0) return -1;
+
+    // Main header: type 1, no header flags, archive flags
+    len = put_vint(header, 1);
+    len += put_vint(header + len, 0);
+    len += put_vint(header + len, c->solid ? 0x0004 : 0);
+    n = seal_rar5_block(out, header, len);
+    if (write_all(fd, out, n) != 0) return -1;
+
+    for (long i = 0; i < c->entries; i++) {
+        char name[32];
+        int name_len = snprintf(name, sizeof(name), "data/%06ld.bin", i);
+        unsigned char* crc_at;
+
+        // File header: type 2, data area present, data size, file flags
+        // (mtime and CRC32 present), unpacked size, attributes, mtime, CRC,
+        // compression info (store, solid after the first), host OS, name
+        len = put_vint(header, 2);
+        len += put_vint(header + len, 0x0002);
+        len += put_vint(header + len, c->entry_size);
+        len += put_vint(header + len, 0x0002 | 0x0004);
+        len += put_vint(header + len, c->entry_size);
+        len += put_vint(header + len, 0100644);
+        put_le32(header + len, 1500000000);
+        len += 4;
+        crc_at = header + len;
+        len += 4;
+        len += put_vint(header + len, 0);
+        len += put_vint(header + len, 1);               // Unix
+        len += put_vint(header + len, (uint64_t)name_len);
+        memcpy(header + len, name, (size_t)name_len);
+        len += (size_t)name_len;
+
+        size_t head_size = 4 + put_vint(out, len) + len;
+        off_t head_at = lseek(fd, (off_t)head_size, SEEK_CUR) - (off_t)head_size;
+        uint32_t data_crc;
+        if (head_at < 0 || write_entry_data(fd, i, c->entry_size, chunk, &data_crc) != 0) return -1;
+
+        put_le32(crc_at, data_crc);
+        n = seal_rar5_block(out, header, len);
+        if (pwrite(fd, out, n, head_at) != (ssize_t)n) return -1;
+    }
+
+    // End of archive: type 5, no header flags, no end flags
+    len = put_vint(header, 5);
+    len += put_vint(header + len, 0);
+    len += put_vint(header + len, 0);
+    n = seal_rar5_block(out, header, len);
+    return write_all(fd, out, n);
+}
+
+static int generate_corpus(const char* dir) {
+    unsigned char* chunk = malloc(CHUNK_SIZE);
+    if (!chunk) return 1;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        perror(dir);
+        free(chunk);
+        return 1;
+    }
+
+    for (size_t i = 0; i < CORPUS_COUNT; i++) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", dir, corpus[i].name);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int failed = fd < 0;
+        if (!failed) {
+            failed = (corpus[i].version == 4 ? generate_rar4(fd, &corpus[i], chunk)
+                                             : generate_rar5(fd, &corpus[i], chunk)) != 0;
+            if (close(fd) != 0) failed = 1;
+        }
+        if (failed) {
+            perror(path);
+            free(chunk);
+            return 1;
+        }
+        fprintf(stderr, "wrote %s\n", path);
+    }
+    free(chunk);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Counters
+// ---------------------------------------------------------------------------
+
+// Totals from /proc/self/io, -1 where unavailable
+typedef struct {
+    int64_t rchar;
+    int64_t wchar;
+    int64_t syscr;
+    int64_t syscw;
+} io_counters;
+
+static void read_io(io_counters* io) {
+    io->rchar = io->wchar = io->syscr = io->syscw = -1;
+    FILE* f = fopen("/proc/self/io", "r");
+    if (!f) return;
+
+    char line[128];
+    long long v;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "rchar: %lld", &v) == 1) io->rchar = v;
+        else if (sscanf(line, "wchar: %lld", &v) == 1) io->wchar = v;
+        else if (sscanf(line, "syscr: %lld", &v) == 1) io->syscr = v;
+        else if (sscanf(line, "syscw: %lld", &v) == 1) io->syscw = v;
+    }
+    fclose(f);
+}
+
+static int64_t io_delta(int64_t before, int64_t after) {
+    return before >= 0 && after >= 0 ? after - before : -1;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int64_t page_faults(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (int64_t)ru.ru_minflt + (int64_t)ru.ru_majflt;
+}
+
+// ---------------------------------------------------------------------------
+// Operations
+// ---------------------------------------------------------------------------
+
+#define OP_LIST    0
+#define OP_EXTRACT 1
+#define OP_MEMORY  2
+
+static const char* op_names[] = {"list", "extract", "memory"};
+
+typedef struct {
+    const char* password;
+    const char* dest_root;
+    int iterations;
+    int json;
+} bench_config;
+
+// Outcome of one operation, sent from the child through a pipe
+typedef struct {
+    int code;               // RAR_* code of the first failure
+    int64_t entries;
+    int64_t bytes;          // Unpacked bytes handled per iteration
+    double seconds;         // Sum over the iterations
+    double best_seconds;
+    int64_t rchar, wchar, syscr, syscw, faults;     // Per iteration
+    long peak_rss_kb;       // Filled in by the parent
+} op_result;
+
+static int remove_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+static void remove_tree(const char* path) {
+    nftw(path, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+}
+
+static int64_t listed;
+
+static void count_entry(const char* filename) {
+    (void)filename;
+    listed++;
+}
+
+// Helper: Entry count and unpacked size of an archive, from its index
+static int archive_totals(const char* path, const bench_config* cfg, int64_t* entries, int64_t* bytes) {
+    rar_archive_t* archive;
+    int r = rar_open(path, cfg->password, &archive, NULL);
+    if (r != RAR_SUCCESS) return r;
+    *entries = rar_entry_count(archive);
+    *bytes = 0;
+    for (int64_t i = 0; i < *entries; i++) {
+        rar_entry_info info;
+        rar_stat(archive, i, &info);
+        *bytes += (int64_t)info.size;
+    }
+    rar_close(archive);
+    return RAR_SUCCESS;
+}
+
+// Runs `op` once; `dest` is an empty directory for OP_EXTRACT
+static int run_once(int op, const char* path, const char* dest, const bench_config* cfg) {
+    rar_options options;
+    rar_options_init(&options);
+
+    if (op == OP_LIST) return rar_list_ex(path, cfg->password, &options, count_entry, NULL);
+    if (op == OP_EXTRACT) return rar_extract_ex(path, dest, cfg->password, &options, NULL);
+
+    rar_archive_t* archive = NULL;
+    int r = rar_open_ex(path, cfg->password, &options, &archive, NULL);
+    int64_t count = rar_entry_count(archive);
+    for (int64_t i = 0; i < count && r == RAR_SUCCESS; i++) {
+        void* data = NULL;
+        size_t len = 0;
+        r = rar_extract_entry_to_buffer(archive, i, &data, &len);
+        rar_buffer_free(data);
+    }
+    rar_close(archive);
+    return r;
+}
+
+// Runs the iterations of `op` in this process and fills `res`, which
+// holds the archive's totals on entry
+static void measure(int op, const char* path, const bench_config* cfg, op_result* res) {
+    io_counters before, after;
+    int64_t faults = page_faults();
+
+    if (op == OP_LIST) res->bytes = 0;
+
+    // Creating and removing output directories is not counted
+    int64_t faults_skipped = 0;
+    io_counters skipped = {0, 0, 0, 0};
+    read_io(&before);
+    for (int i = 0; i < cfg->iterations && res->code == RAR_SUCCESS; i++) {
+        char dest[4096] = "";
+        if (op == OP_EXTRACT) {
+            snprintf(dest, sizeof(dest), "%s/rar_native_bench.XXXXXX", cfg->dest_root);
+            if (!mkdtemp(dest)) {
+                res->code = RAR_CREATE_ERROR;
+                break;
+            }
+        }
+
+        listed = 0;
+        double start = now_seconds();
+        res->code = run_once(op, path, dest, cfg);
+        double seconds = now_seconds() - start;
+        res->seconds += seconds;
+        if (i == 0 || seconds < res->best_seconds) res->best_seconds = seconds;
+        if (op == OP_LIST) res->entries = listed;
+
+        if (op == OP_EXTRACT) {
+            io_counters a, b;
+            int64_t f = page_faults();
+            read_io(&a);
+            remove_tree(dest);
+            read_io(&b);
+            faults_skipped += page_faults() - f;
+            skipped.rchar += b.rchar - a.rchar;
+            skipped.wchar += b.wchar - a.wchar;
+            skipped.syscr += b.syscr - a.syscr;
+            skipped.syscw += b.syscw - a.syscw;
+        }
+    }
+    read_io(&after);
+    after.rchar -= skipped.rchar;
+    after.wchar -= skipped.wchar;
+    after.syscr -= skipped.syscr;
+    after.syscw -= skipped.syscw;
+    faults += faults_skipped;
+
+    int n = cfg->iterations;
+    res->faults = (page_faults() - faults) / n;
+    res->rchar = io_delta(before.rchar, after.rchar);
+    res->wchar = io_delta(before.wchar, after.wchar);
+    res->syscr = io_delta(before.syscr, after.syscr);
+    res->syscw = io_delta(before.syscw, after.syscw);
+    if (res->rchar >= 0) res->rchar /= n;
+    if (res->wchar >= 0) res->wchar /= n;
+    if (res->syscr >= 0) res->syscr /= n;
+    if (res->syscw >= 0) res->syscw /= n;
+}
+
+// Runs `op` in a child process so its peak RSS is measured alone. `res`
+// holds the archive's totals on entry.
+static int measure_in_child(int op, const char* path, const bench_config* cfg, op_result* res) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        measure(op, path, cfg, res);
+        _exit(write_all(fds[1], res, sizeof(*res)) == 0 ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t n;
+    do {
+        n = read(fds[0], res, sizeof(*res));
+    } while (n < 0 && errno == EINTR);
+    close(fds[0]);
+
+    int status;
+    struct rusage ru;
+    memset(&ru, 0, sizeof(ru));
+    while (wait4(pid, &status, 0, &ru) < 0 && errno == EINTR) {
+    }
+    if (n != (ssize_t)sizeof(*res)) return -1;
+
+    // ru_maxrss is KiB on Linux and bytes on macOS
+#ifdef __APPLE__
+    res->peak_rss_kb = ru.ru_maxrss / 1024;
+#else
+    res->peak_rss_kb = ru.ru_maxrss;
+#endif
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+static void json_string(const char* s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') printf("\\%c", c);
+        else if (c < 0x20) printf("\\u%04x", c);
+        else putchar(c);
+    }
+    putchar('"');
+}
+
+static void print_result(const char* path, int64_t size, int op, const op_result* r, const bench_config* cfg, int first) {
+    double mean = r->seconds / cfg->iterations;
+    double mb_per_s = mean > 0 ? (double)r->bytes / mean / 1e6 : 0;
+    double entries_per_s = mean > 0 ? (double)r->entries / mean : 0;
+
+    if (!cfg->json) {
+        if (r->code != RAR_SUCCESS) {
+            printf("  %-8s failed: %s\n", op_names[op], rar_get_error_message(r->code));
+            return;
+        }
+        printf("  %-8s %9.3f ms  %9.1f MB/s  %11.0f entries/s  %7ld KiB peak  %8lld reads  %8lld writes\n",
+               op_names[op], mean * 1000.0, mb_per_s, entries_per_s, r->peak_rss_kb,
+               (long long)r->syscr, (long long)r->syscw);
+        return;
+    }
+
+    printf("%s\n    {\"archive\": ", first ? "" : ",");
+    json_string(path);
+    printf(", \"archive_bytes\": %lld, \"operation\": \"%s\", \"status\": ", (long long)size, op_names[op]);
+    json_string(r->code == RAR_SUCCESS ? "ok" : rar_get_error_message(r->code));
+    printf(", \"entries\": %lld, \"unpacked_bytes\": %lld, \"seconds\": %.6f, \"best_seconds\": %.6f, "
+           "\"mb_per_s\": %.3f, \"entries_per_s\": %.1f, \"peak_rss_kb\": %ld, "
+           "\"read_syscalls\": %lld, \"write_syscalls\": %lld, \"bytes_read\": %lld, \"bytes_written\": %lld, "
+           "\"page_faults\": %lld}",
+           (long long)r->entries, (long long)r->bytes, mean, r->best_seconds, mb_per_s, entries_per_s,
+           r->peak_rss_kb, (long long)r->syscr, (long long)r->syscw, (long long)r->rchar, (long long)r->wchar,
+           (long long)r->faults);
+}
+
+int main(int argc, char** argv) {
+    bench_config cfg = {NULL, "/tmp", 3, 0};
+    const char* corpus_dir = NULL;
+    const char* output = NULL;
+    const char* archives[MAX_ARCHIVES];
+    int archive_count = 0;
+
+    crc_init();
+
+    if (argc == 3 && strcmp(argv[1], "--generate") == 0) return generate_corpus(argv[2]);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            cfg.json = 1;
+        } else if (i + 1 < argc && strcmp(argv[i], "--iterations") == 0) {
+            cfg.iterations = atoi(argv[++i]);
+            if (cfg.iterations < 1) cfg.iterations = 1;
+        } else if (i + 1 < argc && strcmp(argv[i], "--dest") == 0) {
+            cfg.dest_root = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--password") == 0) {
+            cfg.password = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--corpus") == 0) {
+            corpus_dir = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "--output") == 0) {
+            output = argv[++i];
+        } else if (argv[i][0] == '-') {
+            archive_count = -1;
+            break;
+        } else if (archive_count < MAX_ARCHIVES) {
+            archives[archive_count++] = argv[i];
+        }
+    }
+    if (archive_count < 0 || (archive_count == 0 && !corpus_dir)) {
+        fprintf(stderr,
+                "usage: %s --generate DIR\n"
+                "       %s [--iterations N] [--dest DIR] [--password PW] [--json]\n"
+                "          [--output FILE] [--corpus DIR] [archive.rar...]\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+    if (output && !freopen(output, "w", stdout)) {
+        perror(output);
+        return 2;
+    }
+
+    // Corpus archives first, in their fixed order
+    static char corpus_paths[CORPUS_COUNT][4096];
+    const char* paths[MAX_ARCHIVES + CORPUS_COUNT];
+    int path_count = 0;
+    if (corpus_dir) {
+        for (size_t i = 0; i < CORPUS_COUNT; i++) {
+            snprintf(corpus_paths[i], sizeof(corpus_paths[i]), "%s/%s", corpus_dir, corpus[i].name);
+            paths[path_count++] = corpus_paths[i];
+        }
+    }
+    for (int i = 0; i < archive_count; i++) paths[path_count++] = archives[i];
+
+    if (cfg.json) printf("{\n  \"iterations\": %d,\n  \"results\": [", cfg.iterations);
+    int first = 1;
+    int failures = 0;
+    for (int i = 0; i < path_count; i++) {
+        struct stat st;
+        if (stat(paths[i], &st) != 0) {
+            fprintf(stderr, "%s: %s\n", paths[i], strerror(errno));
+            failures++;
+            continue;
+        }
+        if (!cfg.json) {
+            printf("%s (%lld bytes), %d iteration(s)\n", paths[i], (long long)st.st_size, cfg.iterations);
+        }
+        // Counted here, so the index is not part of any operation's peak
+        int64_t entries = 0, bytes = 0;
+        int totals = archive_totals(paths[i], &cfg, &entries, &bytes);
+        for (int op = OP_LIST; op <= OP_MEMORY; op++) {
+            op_result res;
+            memset(&res, 0, sizeof(res));
+            res.code = totals;
+            res.entries = entries;
+            res.bytes = bytes;
+            if (res.code == RAR_SUCCESS && measure_in_child(op, paths[i], &cfg, &res) != 0) {
+                memset(&res, 0, sizeof(res));
+                res.code = RAR_UNKNOWN_ERROR;
+            }
+            if (res.code != RAR_SUCCESS) failures++;
+            print_result(paths[i], (int64_t)st.st_size, op, &res, &cfg, first);
+            first = 0;
+        }
+    }
+    if (cfg.json) printf("\n  ]\n}\n");
+    return failures ? 1 : 0;
+}
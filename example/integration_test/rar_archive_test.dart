@@ -0,0 +1,124 @@
+// example/integration_test/rar_archive_test.dart
+//
+// Integration tests for RarArchive on the native (FFI) platforms.
+// The archive is generated here, so the tests need no RAR tool.
+//
+// Run with:
+//   flutter test integration_test/rar_archive_test.dart --device-id=linux
+
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:integration_test/integration_test.dart';
+import 'package:rar/rar.dart';
+
+final List<int> _crcTable = List<int>.generate(256, (i) {
+  var c = i;
+  for (var k = 0; k < 8; k++) {
+    c = (c & 1) != 0 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+  }
+  return c;
+});
+
+int _crc32(List<int> bytes) {
+  var crc = 0xFFFFFFFF;
+  for (final b in bytes) {
+    crc = _crcTable[(crc ^ b) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+// A RAR4 block; `header` starts at HEAD_TYPE and gets its CRC16 prepended
+List<int> _block(List<int> header) {
+  final crc = _crc32(header) & 0xFFFF;
+  return [crc & 0xFF, crc >> 8, ...header];
+}
+
+// RAR4 archive storing `entries` files of `size` zero bytes each
+Uint8List _storedArchive(int entries, int size) {
+  final out = BytesBuilder(copy: false);
+  out.add(const [0x52, 0x61, 0x72, 0x21, 0x1A, 0x07, 0x00]);
+  out.add(_block([0x73, 0, 0, 13, 0, 0, 0, 0, 0, 0, 0]));
+
+  final data = Uint8List(size);
+  final dataCrc = _crc32(data);
+  for (var i = 0; i < entries; i++) {
+    final name = 'data/$i.bin'.codeUnits;
+    final header = ByteData(30 + name.length)
+      ..setUint8(0, 0x74)
+      ..setUint16(1, 0x8000, Endian.little)
+      ..setUint16(3, 32 + name.length, Endian.little)
+      ..setUint32(5, size, Endian.little) // PACK_SIZE
+      ..setUint32(9, size, Endian.little) // UNP_SIZE
+      ..setUint8(13, 3) // HOST_OS: Unix
+      ..setUint32(14, dataCrc, Endian.little)
+      ..setUint32(18, 0x5A210000, Endian.little) // FTIME (DOS)
+      ..setUint8(22, 20) // UNP_VER
+      ..setUint8(23, 0x30) // METHOD: store
+      ..setUint16(24, name.length, Endian.little)
+      ..setUint32(26, 420, Endian.little); // 0644
+    final bytes = header.buffer.asUint8List();
+    bytes.setRange(30, 30 + name.length, name);
+    out.add(_block(bytes));
+    out.add(data);
+  }
+
+  out.add(const [0xC4, 0x3D, 0x7B, 0x00, 0x40, 0x07, 0x00]);
+  return out.takeBytes();
+}
+
+void main() {
+  IntegrationTestWidgetsFlutterBinding.ensureInitialized();
+
+  const entrySize = 1 << 20;
+  late Directory testDir;
+  late RarArchive archive;
+
+  setUpAll(() async {
+    testDir = await Directory.systemTemp.createTemp('rar_archive_test');
+    final path = '${testDir.path}/stored.rar';
+    await File(path).writeAsBytes(_storedArchive(4, entrySize));
+    archive = await RarArchive.open(path);
+  });
+
+  tearDownAll(() async {
+    archive.close();
+    await testDir.delete(recursive: true);
+  });
+
+  group('RarArchive.streamEntry', () {
+    testWidgets('delivers the whole entry', (tester) async {
+      var total = 0;
+      await for (final chunk in archive.streamEntry(0, chunkSize: 1 << 16)) {
+        total += chunk.length;
+      }
+      expect(total, entrySize);
+    });
+
+    testWidgets('allows reads while streams are paused', (tester) async {
+      // More streams than the pool has workers, each blocked on its
+      // listener while the loop body reads another entry
+      Future<int> streamWithReads(int index) async {
+        var total = 0;
+        await for (final chunk in archive.streamEntry(
+          index % 4,
+          chunkSize: 1 << 16,
+          chunksInFlight: 1,
+        )) {
+          total += chunk.length;
+          final other = await archive.readEntry((index + 1) % 4);
+          expect(other.length, entrySize);
+        }
+        return total;
+      }
+
+      // The shared worker pool has at most 4 workers
+      const streams = 5;
+      final totals = await Future.wait([
+        for (var i = 0; i < streams; i++) streamWithReads(i),
+      ]).timeout(const Duration(minutes: 1));
+      expect(totals, everyElement(entrySize));
+    });
+  });
+}
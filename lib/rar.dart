@@ -4,6 +4,7 @@
 // Provides a unified API for handling RAR files across all platforms:
 // - Android (via JUnRar)
 // - iOS/macOS (via UnrarKit)
+// - Linux/Windows (via libarchive on a native executor)
 // - Web (via WebAssembly with libarchive.js)
 
 import 'rar_platform_interface.dart';
@@ -15,12 +16,32 @@ export 'rar_platform_interface.dart';
 // Export web-specific implementation for direct use in web apps.
 export 'src/rar_web_stub.dart' if (dart.library.js_interop) 'src/rar_web.dart';
 
+// Export the handle-based archive API of the FFI layer. On web the stub's
+// RarArchive.open and RarIndexCache.open fail with an UnsupportedError.
+export 'src/rar_ffi.dart'
+    if (dart.library.js_interop) 'src/rar_ffi_stub.dart'
+    show
+        RarArchive,
+        RarEntry,
+        RarException,
+        RarFilter,
+        RarIndexCache,
+        RarOperation,
+        RarOptions,
+        RarProgress,
+        RarStats;
+
+// Export the channel implementation for jobs with progress events on desktop.
+export 'src/rar_method_channel.dart' show RarJob, RarMethodChannel;
+
 /// A Flutter plugin for handling RAR archive files.
 ///
 /// Supports:
 /// - Extracting RAR files (v4 and v5 formats)
 /// - Listing RAR archive contents
 /// - Password-protected archives
+/// - Multi-volume archives (`name.part1.rar`, or `name.rar` with `name.r00`)
+///   on FFI platforms; pass any volume and the others are found by name
 ///
 /// Example usage:
 /// ```dart
@@ -77,6 +98,49 @@ class Rar {
     );
   }
 
+  /// Read a RAR file's signature and main header without listing it.
+  ///
+  /// [rarFilePath] - Path to the RAR file
+  ///
+  /// Returns a map with 'success', 'message', 'rarVersion', the archive
+  /// flags 'solid', 'encryptedHeaders', 'multiVolume', 'recoveryRecord'
+  /// and 'locked', plus 'volumeIndex', 'entryCount' and 'fileSize'. See
+  /// [RarPlatform.probeRar] for details.
+  ///
+  /// Only the first few KB of the file are read, so this is much cheaper
+  /// than [listRarContents] when sorting through many files.
+  ///
+  /// Platform support:
+  /// - FFI platforms: native header probe
+  /// - Other platforms: not supported ('success' is false)
+  static Future<Map<String, dynamic>> probeRar({required String rarFilePath}) {
+    return RarPlatform.instance.probeRar(rarFilePath: rarFilePath);
+  }
+
+  /// Check a RAR file without extracting it.
+  ///
+  /// [rarFilePath] - Path to the RAR file
+  /// [password] - Optional password for encrypted archives
+  ///
+  /// Every entry is decompressed and compared with its stored CRC32, and
+  /// nothing is written to disk. Returns a map with 'success', 'message',
+  /// 'entriesTested' and 'failures' (the damaged entries). See
+  /// [RarPlatform.testRar] for details.
+  ///
+  /// Platform support:
+  /// - FFI platforms: native test, spread over all CPU cores for non-solid
+  ///   archives
+  /// - Other platforms: not supported ('success' is false)
+  static Future<Map<String, dynamic>> testRar({
+    required String rarFilePath,
+    String? password,
+  }) {
+    return RarPlatform.instance.testRar(
+      rarFilePath: rarFilePath,
+      password: password,
+    );
+  }
+
   /// Create a RAR archive from files or directories.
   ///
   /// **Note: RAR creation is NOT supported on any platform** due to RAR's
@@ -128,4 +192,49 @@ class Rar {
       password: password,
     );
   }
+
+  /// Extract several RAR files, each to its own destination directory.
+  ///
+  /// [rarFilePaths] - Paths to the RAR files
+  /// [destinationPaths] - Destination for each file, matched by index
+  /// [password] - Optional password used for every archive
+  ///
+  /// Returns one map per archive, in order, shaped like the result of
+  /// [extractRarFile].
+  ///
+  /// Platform support:
+  /// - FFI platforms: one native call that runs the archives on a thread pool
+  /// - Other platforms: the archives are extracted one after another
+  static Future<List<Map<String, dynamic>>> extractMany({
+    required List<String> rarFilePaths,
+    required List<String> destinationPaths,
+    String? password,
+  }) {
+    return RarPlatform.instance.extractMany(
+      rarFilePaths: rarFilePaths,
+      destinationPaths: destinationPaths,
+      password: password,
+    );
+  }
+
+  /// List the contents of several RAR files.
+  ///
+  /// [rarFilePaths] - Paths to the RAR files
+  /// [password] - Optional password used for every archive
+  ///
+  /// Returns one map per archive, in order, with the 'success', 'message'
+  /// and 'files' keys of [listRarContents].
+  ///
+  /// Platform support:
+  /// - FFI platforms: one native call that runs the archives on a thread pool
+  /// - Other platforms: the archives are listed one after another
+  static Future<List<Map<String, dynamic>>> listMany({
+    required List<String> rarFilePaths,
+    String? password,
+  }) {
+    return RarPlatform.instance.listMany(
+      rarFilePaths: rarFilePaths,
+      password: password,
+    );
+  }
 }
@@ -36,7 +36,9 @@ abstract class RarPlatform extends PlatformInterface {
 
   /// The default instance of [RarPlatform] to use.
   ///
-  /// Defaults to [RarMethodChannel] for iOS/macOS and [RarFfi] for Android.
+  /// Defaults to [RarFfi] for Android and [RarMethodChannel] elsewhere. On
+  /// Linux and Windows the method channel reaches the desktop plugin's
+  /// executor and forwards probing, testing and batches to [RarFfi].
   static RarPlatform get instance => _instance;
 
   /// Platform-specific implementations should set this with their own
@@ -80,6 +82,54 @@ abstract class RarPlatform extends PlatformInterface {
     throw UnimplementedError('listRarContents() has not been implemented.');
   }
 
+  /// Read a RAR file's signature and main header without listing it.
+  ///
+  /// [rarFilePath] - Path to the RAR file
+  ///
+  /// Returns a map with:
+  /// - 'success': bool - Whether the file is a readable RAR archive
+  /// - 'message': String - Status message or error description
+  /// - 'rarVersion': String - 'RAR4', 'RAR5' or 'Unknown'
+  /// - 'solid', 'encryptedHeaders', 'multiVolume', 'recoveryRecord',
+  ///   'locked': bool - Archive flags from the main header
+  /// - 'volumeIndex': int? - Position in a volume set, null if unknown
+  /// - 'entryCount': int? - Number of entries, null if not cheap to tell
+  /// - 'fileSize': int - Size of the file in bytes
+  ///
+  /// The default implementation reports that probing is unsupported.
+  Future<Map<String, dynamic>> probeRar({required String rarFilePath}) async {
+    return {
+      'success': false,
+      'message': 'Archive probing is not supported on this platform',
+    };
+  }
+
+  /// Decompress every entry of a RAR file and check its checksum without
+  /// writing anything.
+  ///
+  /// [rarFilePath] - Path to the RAR file
+  /// [password] - Optional password for encrypted archives
+  ///
+  /// Returns a map with:
+  /// - 'success': bool - Whether every entry is intact
+  /// - 'message': String - Status message or error description
+  /// - 'entriesTested': int - Entries decompressed
+  /// - 'failures': `List<Map<String, dynamic>>` - Damaged entries, each
+  ///   with 'index', 'name', 'code' and 'message'
+  ///
+  /// The default implementation reports that testing is unsupported.
+  Future<Map<String, dynamic>> testRar({
+    required String rarFilePath,
+    String? password,
+  }) async {
+    return {
+      'success': false,
+      'message': 'Archive testing is not supported on this platform',
+      'entriesTested': 0,
+      'failures': <Map<String, dynamic>>[],
+    };
+  }
+
   /// Create a RAR archive from files or directories.
   ///
   /// Note: RAR creation is not supported on most platforms due to licensing
@@ -102,4 +152,51 @@ abstract class RarPlatform extends PlatformInterface {
   }) {
     throw UnimplementedError('createRarArchive() has not been implemented.');
   }
+
+  /// Extract several RAR files, each to its own destination directory.
+  ///
+  /// [rarFilePaths] - Paths to the RAR files
+  /// [destinationPaths] - Destination for each file, matched by index
+  /// [password] - Optional password used for every archive
+  ///
+  /// Returns one map per archive, in order, with the same keys as
+  /// [extractRarFile]. The default implementation extracts the archives one
+  /// after another through [extractRarFile].
+  Future<List<Map<String, dynamic>>> extractMany({
+    required List<String> rarFilePaths,
+    required List<String> destinationPaths,
+    String? password,
+  }) async {
+    if (rarFilePaths.length != destinationPaths.length) {
+      throw ArgumentError(
+        'rarFilePaths and destinationPaths must have the same length',
+      );
+    }
+    return [
+      for (var i = 0; i < rarFilePaths.length; i++)
+        await extractRarFile(
+          rarFilePath: rarFilePaths[i],
+          destinationPath: destinationPaths[i],
+          password: password,
+        ),
+    ];
+  }
+
+  /// List the contents of several RAR files.
+  ///
+  /// [rarFilePaths] - Paths to the RAR files
+  /// [password] - Optional password used for every archive
+  ///
+  /// Returns one map per archive, in order, with the 'success', 'message'
+  /// and 'files' keys of [listRarContents]. The default implementation
+  /// lists the archives one after another through [listRarContents].
+  Future<List<Map<String, dynamic>>> listMany({
+    required List<String> rarFilePaths,
+    String? password,
+  }) async {
+    return [
+      for (final rarFilePath in rarFilePaths)
+        await listRarContents(rarFilePath: rarFilePath, password: password),
+    ];
+  }
 }
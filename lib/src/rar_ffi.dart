@@ -3,14 +3,18 @@
 // FFI implementation for RAR operations.
 // Used on Android and Desktop platforms.
 
+import 'dart:async';
+import 'dart:convert';
 import 'dart:developer' as dev;
 import 'dart:ffi';
 import 'dart:io';
 import 'dart:isolate';
+import 'dart:typed_data';
 
 import 'package:ffi/ffi.dart';
 
 import '../rar_platform_interface.dart';
+import 'rar_worker_pool.dart';
 
 // FFI typedefs
 typedef RarExtractC =
@@ -51,36 +55,1997 @@ typedef RarGetErrorMessageDart = Pointer<Utf8> Function(int errorCode);
 typedef RarListCallbackC = Void Function(Pointer<Utf8> filename);
 typedef RarErrorCallbackC = Void Function(Pointer<Utf8> error);
 
+typedef RarExtractExC =
+    Int32 Function(
+      Pointer<Utf8> rarPath,
+      Pointer<Utf8> destPath,
+      Pointer<Utf8> password,
+      Pointer<RarOptionsNative> options,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractExDart =
+    int Function(
+      Pointer<Utf8> rarPath,
+      Pointer<Utf8> destPath,
+      Pointer<Utf8> password,
+      Pointer<RarOptionsNative> options,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarProgressCallbackC =
+    Void Function(
+      Int64 entriesDone,
+      Int64 entriesTotal,
+      Int64 bytesIn,
+      Int64 bytesOut,
+      Int64 bytesTotal,
+      Int64 entryIndex,
+      Pointer<Utf8> entryName,
+      Pointer<Void> userData,
+    );
+
+typedef RarOpenC =
+    Int32 Function(
+      Pointer<Utf8> rarPath,
+      Pointer<Utf8> password,
+      Pointer<Pointer<Void>> outArchive,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarOpenDart =
+    int Function(
+      Pointer<Utf8> rarPath,
+      Pointer<Utf8> password,
+      Pointer<Pointer<Void>> outArchive,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarOpenExC =
+    Int32 Function(
+      Pointer<Utf8> rarPath,
+      Pointer<Utf8> password,
+      Pointer<RarOptionsNative> options,
+      Pointer<Pointer<Void>> outArchive,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarOpenExDart =
+    int Function(
+      Pointer<Utf8> rarPath,
+      Pointer<Utf8> password,
+      Pointer<RarOptionsNative> options,
+      Pointer<Pointer<Void>> outArchive,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarCloseC = Void Function(Pointer<Void> archive);
+typedef RarCloseDart = void Function(Pointer<Void> archive);
+
+typedef RarEntryCountC = Int64 Function(Pointer<Void> archive);
+typedef RarEntryCountDart = int Function(Pointer<Void> archive);
+
+typedef RarArchiveStatsC =
+    Void Function(Pointer<Void> archive, Pointer<RarStatsNative> stats);
+typedef RarArchiveStatsDart =
+    void Function(Pointer<Void> archive, Pointer<RarStatsNative> stats);
+
+typedef RarStatC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Int64 index,
+      Pointer<RarEntryInfoNative> info,
+    );
+
+typedef RarStatDart =
+    int Function(
+      Pointer<Void> archive,
+      int index,
+      Pointer<RarEntryInfoNative> info,
+    );
+
+typedef RarListBatchC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Int64 start,
+      Pointer<RarEntryInfoNative> out,
+      Size maxEntries,
+      Pointer<Size> outCount,
+    );
+
+typedef RarListBatchDart =
+    int Function(
+      Pointer<Void> archive,
+      int start,
+      Pointer<RarEntryInfoNative> out,
+      int maxEntries,
+      Pointer<Size> outCount,
+    );
+
+typedef RarFindEntryC =
+    Int64 Function(Pointer<Void> archive, Pointer<Utf8> name);
+typedef RarFindEntryDart =
+    int Function(Pointer<Void> archive, Pointer<Utf8> name);
+
+typedef RarExtractAllC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Pointer<Utf8> destPath,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractAllDart =
+    int Function(
+      Pointer<Void> archive,
+      Pointer<Utf8> destPath,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractAllExC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Pointer<Utf8> destPath,
+      Pointer<RarOptionsNative> options,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractAllExDart =
+    int Function(
+      Pointer<Void> archive,
+      Pointer<Utf8> destPath,
+      Pointer<RarOptionsNative> options,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractEntryC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Int64 index,
+      Pointer<Utf8> destPath,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractEntryDart =
+    int Function(
+      Pointer<Void> archive,
+      int index,
+      Pointer<Utf8> destPath,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractEntryExC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Int64 index,
+      Pointer<Utf8> destPath,
+      Pointer<RarOptionsNative> options,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractEntryExDart =
+    int Function(
+      Pointer<Void> archive,
+      int index,
+      Pointer<Utf8> destPath,
+      Pointer<RarOptionsNative> options,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarExtractEntryToBufferC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Int64 index,
+      Pointer<Pointer<Uint8>> outData,
+      Pointer<Size> outLen,
+    );
+
+typedef RarExtractEntryToBufferDart =
+    int Function(
+      Pointer<Void> archive,
+      int index,
+      Pointer<Pointer<Uint8>> outData,
+      Pointer<Size> outLen,
+    );
+
+typedef RarExtractEntryToMemoryC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Int64 index,
+      Pointer<Uint8> buffer,
+      Size capacity,
+      Pointer<Size> outLen,
+    );
+
+typedef RarExtractEntryToMemoryDart =
+    int Function(
+      Pointer<Void> archive,
+      int index,
+      Pointer<Uint8> buffer,
+      int capacity,
+      Pointer<Size> outLen,
+    );
+
+typedef RarReadAtC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Int64 index,
+      Uint64 offset,
+      Pointer<Uint8> buffer,
+      Size len,
+      Pointer<Size> outRead,
+    );
+
+typedef RarReadAtDart =
+    int Function(
+      Pointer<Void> archive,
+      int index,
+      int offset,
+      Pointer<Uint8> buffer,
+      int len,
+      Pointer<Size> outRead,
+    );
+
+typedef RarBufferFreeC = Void Function(Pointer<Void> data);
+
+typedef RarProbeC =
+    Int32 Function(Pointer<Utf8> rarPath, Pointer<RarProbeInfoNative> info);
+typedef RarProbeDart =
+    int Function(Pointer<Utf8> rarPath, Pointer<RarProbeInfoNative> info);
+
+typedef RarTestC =
+    Int32 Function(
+      Pointer<Utf8> rarPath,
+      Pointer<Utf8> password,
+      Int32 numThreads,
+      Pointer<RarOptionsNative> options,
+      Pointer<RarTestReportNative> report,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+typedef RarTestDart =
+    int Function(
+      Pointer<Utf8> rarPath,
+      Pointer<Utf8> password,
+      int numThreads,
+      Pointer<RarOptionsNative> options,
+      Pointer<RarTestReportNative> report,
+      Pointer<NativeFunction<RarErrorCallbackC>> errorCb,
+    );
+
+typedef RarTestReportFreeC = Void Function(Pointer<RarTestReportNative> report);
+typedef RarTestReportFreeDart =
+    void Function(Pointer<RarTestReportNative> report);
+
+typedef RarBatchCallbackC =
+    Void Function(Size jobCount, Size failedCount, Pointer<Void> userData);
+
+typedef RarBatchSubmitC =
+    Int32 Function(
+      Pointer<RarJobNative> jobs,
+      Size count,
+      Int32 numThreads,
+      Pointer<RarOptionsNative> options,
+      Pointer<RarJobResultNative> results,
+      Pointer<NativeFunction<RarBatchCallbackC>> doneCb,
+      Pointer<Void> userData,
+    );
+
+typedef RarBatchSubmitDart =
+    int Function(
+      Pointer<RarJobNative> jobs,
+      int count,
+      int numThreads,
+      Pointer<RarOptionsNative> options,
+      Pointer<RarJobResultNative> results,
+      Pointer<NativeFunction<RarBatchCallbackC>> doneCb,
+      Pointer<Void> userData,
+    );
+
+typedef RarBatchResultsFreeC =
+    Void Function(Pointer<RarJobResultNative> results, Size count);
+typedef RarBatchResultsFreeDart =
+    void Function(Pointer<RarJobResultNative> results, int count);
+
+typedef RarCancelTokenNewC = Pointer<Void> Function();
+typedef RarCancelTokenNewDart = Pointer<Void> Function();
+typedef RarCancelC = Void Function(Pointer<Void> token);
+typedef RarCancelDart = void Function(Pointer<Void> token);
+typedef RarFlowNewC = Pointer<Void> Function(Int64 credits);
+typedef RarFlowNewDart = Pointer<Void> Function(int credits);
+typedef RarFlowAcquireC = Int32 Function(Pointer<Void> flow);
+typedef RarFlowAcquireDart = int Function(Pointer<Void> flow);
+typedef RarFlowReleaseC = Void Function(Pointer<Void> flow, Int64 credits);
+typedef RarFlowReleaseDart = void Function(Pointer<Void> flow, int credits);
+
+typedef RarIndexCacheOpenC =
+    Int32 Function(
+      Pointer<Utf8> dir,
+      Uint64 maxBytes,
+      Pointer<Pointer<Void>> outCache,
+    );
+typedef RarIndexCacheOpenDart =
+    int Function(
+      Pointer<Utf8> dir,
+      int maxBytes,
+      Pointer<Pointer<Void>> outCache,
+    );
+typedef RarIndexCacheSetLimitC =
+    Void Function(Pointer<Void> cache, Uint64 maxBytes);
+typedef RarIndexCacheSetLimitDart =
+    void Function(Pointer<Void> cache, int maxBytes);
+typedef RarIndexCacheInvalidateC =
+    Int32 Function(Pointer<Void> cache, Pointer<Utf8> rarPath);
+typedef RarIndexCacheInvalidateDart =
+    int Function(Pointer<Void> cache, Pointer<Utf8> rarPath);
+
+typedef RarDataCallbackC =
+    Int32 Function(
+      Pointer<Void> data,
+      Size size,
+      Int64 offset,
+      Pointer<Void> userData,
+    );
+
+typedef RarStreamEntryC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Int64 index,
+      Pointer<NativeFunction<RarDataCallbackC>> dataCb,
+      Pointer<Void> userData,
+      Size chunkHint,
+    );
+
+typedef RarStreamEntryDart =
+    int Function(
+      Pointer<Void> archive,
+      int index,
+      Pointer<NativeFunction<RarDataCallbackC>> dataCb,
+      Pointer<Void> userData,
+      int chunkHint,
+    );
+
+typedef RarEntryNamesC =
+    Int32 Function(
+      Pointer<Void> archive,
+      Pointer<Pointer<Utf8>> outNames,
+      Pointer<Size> outLen,
+    );
+typedef RarEntryNamesDart =
+    int Function(
+      Pointer<Void> archive,
+      Pointer<Pointer<Utf8>> outNames,
+      Pointer<Size> outLen,
+    );
+
+/// Native layout of `rar_entry_info` (see src/rar_native.h).
+final class RarEntryInfoNative extends Struct {
+  external Pointer<Utf8> name;
+
+  @Uint64()
+  external int size;
+
+  @Uint64()
+  external int packedSize;
+
+  @Int64()
+  external int mtime;
+
+  @Int64()
+  external int headerOffset;
+
+  @Int64()
+  external int dataOffset;
+
+  @Uint32()
+  external int crc32;
+
+  @Uint32()
+  external int mode;
+
+  @Uint32()
+  external int flags;
+}
+
+/// Native layout of `rar_probe_info` (see src/rar_native.h).
+final class RarProbeInfoNative extends Struct {
+  @Int32()
+  external int version;
+
+  @Uint32()
+  external int flags;
+
+  @Int64()
+  external int volumeIndex;
+
+  @Int64()
+  external int entryCount;
+
+  @Int64()
+  external int fileSize;
+}
+
+/// Native layout of `rar_options` (see src/rar_native.h).
+final class RarOptionsNative extends Struct {
+  @Int32()
+  external int ioMode;
+
+  @Size()
+  external int readBlockSize;
+
+  @Size()
+  external int writeBufferSize;
+
+  external Pointer<NativeFunction<RarProgressCallbackC>> progressCb;
+
+  external Pointer<Void> progressUserData;
+
+  @Uint32()
+  external int progressIntervalMs;
+
+  external Pointer<Void> cancelToken;
+
+  @Uint32()
+  external int pipelineBlocks;
+
+  @Int32()
+  external int writeMode;
+
+  external Pointer<Void> indexCache;
+
+  external Pointer<RarStatsNative> stats;
+
+  @Uint64()
+  external int entryCacheBytes;
+
+  @Uint32()
+  external int prefetchEntries;
+
+  external Pointer<RarFilterNative> filter;
+
+  @Uint32()
+  external int extractThreads;
+}
+
+/// Native layout of `rar_filter` (see src/rar_native.h).
+final class RarFilterNative extends Struct {
+  external Pointer<Pointer<Utf8>> include;
+
+  @Size()
+  external int includeCount;
+
+  external Pointer<Pointer<Utf8>> exclude;
+
+  @Size()
+  external int excludeCount;
+
+  external Pointer<Utf8> prefix;
+
+  @Uint64()
+  external int minSize;
+
+  @Uint64()
+  external int maxSize;
+}
+
+/// Native layout of `rar_stats` (see src/rar_native.h).
+final class RarStatsNative extends Struct {
+  @Int64()
+  external int headerNs;
+
+  @Int64()
+  external int readNs;
+
+  @Int64()
+  external int createNs;
+
+  @Int64()
+  external int writeNs;
+
+  @Int64()
+  external int finishNs;
+
+  @Int64()
+  external int mkdirNs;
+
+  @Int64()
+  external int headers;
+
+  @Int64()
+  external int entriesWritten;
+
+  @Int64()
+  external int bytesDecoded;
+
+  @Int64()
+  external int bytesWritten;
+
+  @Int64()
+  external int cacheHits;
+
+  @Int64()
+  external int cacheMisses;
+}
+
+/// Native layout of `rar_test_failure` (see src/rar_native.h).
+final class RarTestFailureNative extends Struct {
+  @Int64()
+  external int index;
+
+  @Int32()
+  external int code;
+
+  external Pointer<Utf8> name;
+
+  external Pointer<Utf8> message;
+}
+
+/// Native layout of `rar_test_report` (see src/rar_native.h).
+final class RarTestReportNative extends Struct {
+  @Int64()
+  external int entriesTested;
+
+  @Size()
+  external int failureCount;
+
+  external Pointer<RarTestFailureNative> failures;
+}
+
+/// Native layout of `rar_job` (see src/rar_native.h).
+final class RarJobNative extends Struct {
+  @Int32()
+  external int type;
+
+  external Pointer<Utf8> rarPath;
+
+  external Pointer<Utf8> destPath;
+
+  external Pointer<Utf8> password;
+}
+
+/// Native layout of `rar_job_result` (see src/rar_native.h).
+final class RarJobResultNative extends Struct {
+  @Int32()
+  external int code;
+
+  @Int64()
+  external int entryCount;
+
+  external Pointer<Utf8> names;
+
+  @Size()
+  external int namesLen;
+}
+
 // Global library reference
 DynamicLibrary? _lib;
 
-DynamicLibrary get _library {
-  if (_lib != null) return _lib!;
+DynamicLibrary get _library {
+  if (_lib != null) return _lib!;
+
+  if (Platform.isAndroid) {
+    _lib = DynamicLibrary.open('librar_native.so');
+  } else if (Platform.isLinux) {
+    _lib = DynamicLibrary.open('librar_native.so');
+  } else if (Platform.isWindows) {
+    _lib = DynamicLibrary.open('rar_native.dll');
+  } else if (Platform.isMacOS) {
+    try {
+      _lib = DynamicLibrary.open('librar_native.dylib');
+    } catch (e) {
+      _lib = DynamicLibrary.process();
+    }
+  } else {
+    throw UnsupportedError('Unknown platform: ${Platform.operatingSystem}');
+  }
+  return _lib!;
+}
+
+/// Resolved native entry points, looked up once per isolate.
+class _RarBindings {
+  _RarBindings(DynamicLibrary lib)
+    : extract = lib.lookupFunction<RarExtractC, RarExtractDart>('rar_extract'),
+      extractEx = lib.lookupFunction<RarExtractExC, RarExtractExDart>(
+        'rar_extract_ex',
+      ),
+      list = lib.lookupFunction<RarListC, RarListDart>('rar_list'),
+      probe = lib.lookupFunction<RarProbeC, RarProbeDart>('rar_probe'),
+      test = lib.lookupFunction<RarTestC, RarTestDart>('rar_test'),
+      testReportFree = lib
+          .lookupFunction<RarTestReportFreeC, RarTestReportFreeDart>(
+            'rar_test_report_free',
+          ),
+      getErrorMessage = lib
+          .lookupFunction<RarGetErrorMessageC, RarGetErrorMessageDart>(
+            'rar_get_error_message',
+          ),
+      open = lib.lookupFunction<RarOpenC, RarOpenDart>('rar_open'),
+      openEx = lib.lookupFunction<RarOpenExC, RarOpenExDart>('rar_open_ex'),
+      close = lib.lookupFunction<RarCloseC, RarCloseDart>('rar_close'),
+      entryCount = lib.lookupFunction<RarEntryCountC, RarEntryCountDart>(
+        'rar_entry_count',
+      ),
+      archiveStats = lib
+          .lookupFunction<RarArchiveStatsC, RarArchiveStatsDart>(
+            'rar_archive_stats',
+          ),
+      stat = lib.lookupFunction<RarStatC, RarStatDart>('rar_stat'),
+      listBatch = lib.lookupFunction<RarListBatchC, RarListBatchDart>(
+        'rar_list_batch',
+      ),
+      findEntry = lib.lookupFunction<RarFindEntryC, RarFindEntryDart>(
+        'rar_find_entry',
+      ),
+      entryNames = lib.lookupFunction<RarEntryNamesC, RarEntryNamesDart>(
+        'rar_entry_names',
+      ),
+      extractAll = lib.lookupFunction<RarExtractAllC, RarExtractAllDart>(
+        'rar_extract_all',
+      ),
+      extractAllEx = lib.lookupFunction<RarExtractAllExC, RarExtractAllExDart>(
+        'rar_extract_all_ex',
+      ),
+      extractEntry = lib
+          .lookupFunction<RarExtractEntryC, RarExtractEntryDart>(
+            'rar_extract_entry',
+          ),
+      extractEntryEx = lib
+          .lookupFunction<RarExtractEntryExC, RarExtractEntryExDart>(
+            'rar_extract_entry_ex',
+          ),
+      extractEntryToBuffer = lib
+          .lookupFunction<
+            RarExtractEntryToBufferC,
+            RarExtractEntryToBufferDart
+          >('rar_extract_entry_to_buffer'),
+      extractEntryToMemory = lib
+          .lookupFunction<
+            RarExtractEntryToMemoryC,
+            RarExtractEntryToMemoryDart
+          >('rar_extract_entry_to_memory'),
+      streamEntry = lib.lookupFunction<RarStreamEntryC, RarStreamEntryDart>(
+        'rar_stream_entry',
+      ),
+      readAt = lib.lookupFunction<RarReadAtC, RarReadAtDart>('rar_read_at'),
+      batchSubmit = lib.lookupFunction<RarBatchSubmitC, RarBatchSubmitDart>(
+        'rar_batch_submit',
+      ),
+      batchResultsFree = lib
+          .lookupFunction<RarBatchResultsFreeC, RarBatchResultsFreeDart>(
+            'rar_batch_results_free',
+          ),
+      cancelTokenNew = lib
+          .lookupFunction<RarCancelTokenNewC, RarCancelTokenNewDart>(
+            'rar_cancel_token_new',
+          ),
+      cancel = lib.lookupFunction<RarCancelC, RarCancelDart>('rar_cancel'),
+      cancelTokenFree = lib.lookupFunction<RarCancelC, RarCancelDart>(
+        'rar_cancel_token_free',
+      ),
+      flowNew = lib.lookupFunction<RarFlowNewC, RarFlowNewDart>(
+        'rar_flow_new',
+      ),
+      flowAcquire = lib.lookupFunction<RarFlowAcquireC, RarFlowAcquireDart>(
+        'rar_flow_acquire',
+      ),
+      flowRelease = lib.lookupFunction<RarFlowReleaseC, RarFlowReleaseDart>(
+        'rar_flow_release',
+      ),
+      flowClose = lib.lookupFunction<RarCancelC, RarCancelDart>(
+        'rar_flow_close',
+      ),
+      flowFree = lib.lookupFunction<RarCancelC, RarCancelDart>('rar_flow_free'),
+      indexCacheOpen = lib
+          .lookupFunction<RarIndexCacheOpenC, RarIndexCacheOpenDart>(
+            'rar_index_cache_open',
+          ),
+      indexCacheSetLimit = lib
+          .lookupFunction<RarIndexCacheSetLimitC, RarIndexCacheSetLimitDart>(
+            'rar_index_cache_set_limit',
+          ),
+      indexCacheInvalidate = lib
+          .lookupFunction<
+            RarIndexCacheInvalidateC,
+            RarIndexCacheInvalidateDart
+          >('rar_index_cache_invalidate'),
+      indexCacheClose = lib.lookupFunction<RarCancelC, RarCancelDart>(
+        'rar_index_cache_close',
+      ),
+      closePointer = lib.lookup<NativeFunction<RarCloseC>>('rar_close'),
+      bufferFreePointer = lib.lookup<NativeFunction<RarBufferFreeC>>(
+        'rar_buffer_free',
+      );
+
+  final RarExtractDart extract;
+  final RarExtractExDart extractEx;
+  final RarListDart list;
+  final RarProbeDart probe;
+  final RarTestDart test;
+  final RarTestReportFreeDart testReportFree;
+  final RarGetErrorMessageDart getErrorMessage;
+  final RarOpenDart open;
+  final RarOpenExDart openEx;
+  final RarCloseDart close;
+  final RarEntryCountDart entryCount;
+  final RarArchiveStatsDart archiveStats;
+  final RarStatDart stat;
+  final RarListBatchDart listBatch;
+  final RarFindEntryDart findEntry;
+  final RarEntryNamesDart entryNames;
+  final RarExtractAllDart extractAll;
+  final RarExtractAllExDart extractAllEx;
+  final RarExtractEntryDart extractEntry;
+  final RarExtractEntryExDart extractEntryEx;
+  final RarExtractEntryToBufferDart extractEntryToBuffer;
+  final RarExtractEntryToMemoryDart extractEntryToMemory;
+  final RarStreamEntryDart streamEntry;
+  final RarReadAtDart readAt;
+  final RarBatchSubmitDart batchSubmit;
+  final RarBatchResultsFreeDart batchResultsFree;
+  final RarCancelTokenNewDart cancelTokenNew;
+  final RarCancelDart cancel;
+  final RarCancelDart cancelTokenFree;
+  final RarFlowNewDart flowNew;
+  final RarFlowAcquireDart flowAcquire;
+  final RarFlowReleaseDart flowRelease;
+  final RarCancelDart flowClose;
+  final RarCancelDart flowFree;
+  final RarIndexCacheOpenDart indexCacheOpen;
+  final RarIndexCacheSetLimitDart indexCacheSetLimit;
+  final RarIndexCacheInvalidateDart indexCacheInvalidate;
+  final RarCancelDart indexCacheClose;
+  final Pointer<NativeFunction<RarCloseC>> closePointer;
+  final Pointer<NativeFunction<RarBufferFreeC>> bufferFreePointer;
+
+  String errorMessage(int code) => getErrorMessage(code).toDartString();
+}
+
+// Lazily initialized separately in every isolate that touches it.
+final _RarBindings _bindings = _RarBindings(_library);
+
+// Background calls run on long-lived workers, which keep their own
+// _bindings resolved between calls.
+RarWorkerPool get _workers => RarWorkerPool.shared;
+
+/// Error raised by the handle-based [RarArchive] API.
+class RarException implements Exception {
+  const RarException(this.code, this.message);
+
+  /// `RAR_ENTRY_NOT_FOUND`: no entry with the requested index or name.
+  static const int entryNotFound = 10;
+
+  /// `RAR_BUFFER_TOO_SMALL`: a caller-supplied buffer cannot hold the entry.
+  static const int bufferTooSmall = 11;
+
+  /// `RAR_CANCELLED`: the operation was stopped by [RarOperation.cancel].
+  static const int cancelled = 12;
+
+  /// Native `RAR_*` error code.
+  final int code;
+
+  /// Human-readable description from `rar_get_error_message`.
+  final String message;
+
+  @override
+  String toString() => 'RarException($code): $message';
+}
+
+/// I/O tuning for [RarArchive.open].
+///
+/// Sizes of 0 let the native layer pick them from the archive size and the
+/// file system's preferred block size.
+class RarOptions {
+  const RarOptions({
+    this.ioMode = ioAuto,
+    this.readBlockSize = 0,
+    this.writeBufferSize = 0,
+    this.progressIntervalMs = 0,
+    this.pipelineBlocks = 0,
+    this.writeMode = writeFaithful,
+    this.indexCache,
+    this.collectStats = false,
+    this.entryCacheBytes = 0,
+    this.prefetchEntries = 0,
+    this.filter,
+    this.extractThreads = 0,
+  });
+
+  /// `RAR_IO_AUTO`: memory-map the archive when possible.
+  static const int ioAuto = 0;
+
+  /// `RAR_IO_READ`: always read through a buffer of [readBlockSize] bytes.
+  static const int ioRead = 1;
+
+  /// `RAR_WRITE_FAITHFUL`: restore times, permissions, ACLs, file flags and
+  /// owners.
+  static const int writeFaithful = 0;
+
+  /// `RAR_WRITE_FAST`: restore times and permissions only, and write regular
+  /// files directly into preallocated space.
+  static const int writeFast = 1;
+
+  /// One of [ioAuto] or [ioRead].
+  final int ioMode;
+
+  /// Bytes per archive read when not memory-mapped, 0 for automatic.
+  final int readBlockSize;
+
+  /// Bytes buffered per output file write, 0 for automatic.
+  final int writeBufferSize;
+
+  /// Minimum time between progress reports, 0 for the default (100 ms).
+  final int progressIntervalMs;
+
+  /// Blocks of [writeBufferSize] bytes queued between decompression and a
+  /// separate writer thread, 0 to decompress and write on one thread. Helps
+  /// on slow storage; memory use is bounded by the two sizes.
+  final int pipelineBlocks;
+
+  /// One of [writeFaithful] or [writeFast].
+  final int writeMode;
+
+  /// Saved entry indexes to open unchanged archives from, or null to parse
+  /// their headers every time.
+  final RarIndexCache? indexCache;
+
+  /// Time each phase of extraction into [RarOperation.stats].
+  final bool collectStats;
+
+  /// Bytes of decompressed entries a [RarArchive] keeps in memory for
+  /// [RarArchive.readEntry], [RarArchive.readEntryInto] and
+  /// [RarArchive.readAt], 0 for none. In solid archives, reading an entry
+  /// also leaves a checkpoint that later entries resume from instead of
+  /// decompressing the archive from the start. See [RarArchive.stats].
+  final int entryCacheBytes;
+
+  /// Entries a background thread decompresses into the entry cache ahead
+  /// of the last one read, at most, for reading entries in archive order.
+  /// The thread goes only as deep as the reading pace needs and uses at
+  /// most half of [entryCacheBytes], which must be set; 0 for none.
+  /// [RarArchive.streamEntry] is served from the cache too.
+  final int prefetchEntries;
+
+  /// Entries extraction skips without decompressing or creating anything,
+  /// or null to extract every entry. Applies to each extraction call;
+  /// [RarArchive.open] does not keep it.
+  final RarFilter? filter;
+
+  /// Worker threads [RarArchive.extractAll] uses for non-solid archives, 1
+  /// to extract on one thread, 0 for one per CPU core. Lower it when
+  /// several extractions run at once.
+  final int extractThreads;
+
+  void _writeTo(
+    RarOptionsNative native, {
+    int progressCallback = 0,
+    int cancelToken = 0,
+    int stats = 0,
+  }) {
+    native
+      ..ioMode = ioMode
+      ..readBlockSize = readBlockSize
+      ..writeBufferSize = writeBufferSize
+      ..progressCb = Pointer.fromAddress(progressCallback)
+      ..progressUserData = nullptr
+      ..progressIntervalMs = progressIntervalMs
+      ..cancelToken = Pointer.fromAddress(cancelToken)
+      ..pipelineBlocks = pipelineBlocks
+      ..writeMode = writeMode
+      ..indexCache = Pointer.fromAddress(indexCache?._address ?? 0)
+      ..stats = Pointer.fromAddress(stats)
+      ..entryCacheBytes = entryCacheBytes
+      ..prefetchEntries = prefetchEntries
+      ..filter = filter?._toNative() ?? nullptr
+      ..extractThreads = extractThreads;
+  }
+
+  // Frees what _writeTo allocated
+  static void _release(RarOptionsNative native) {
+    if (native.filter != nullptr) RarFilter._free(native.filter);
+    native.filter = nullptr;
+  }
+}
+
+/// Which entries extraction writes, see [RarOptions.filter].
+///
+/// An entry is extracted when it is below [prefix], its size is within
+/// [minSize] and [maxSize] (directories always are), it matches one of
+/// [include] (or [include] is empty) and none of [exclude]. In glob
+/// patterns `*` and `?` stay within one path component, `**` spans any
+/// number of them, `[a-z]` and `[!a-z]` are sets and `\` quotes the next
+/// character. Patterns without a `/` match the file name, so `*.jpg`
+/// matches `photos/a.jpg`; others match the whole path.
+class RarFilter {
+  const RarFilter({
+    this.include = const [],
+    this.exclude = const [],
+    this.prefix,
+    this.minSize = 0,
+    this.maxSize = 0,
+  });
+
+  /// Glob patterns an entry must match one of.
+  final List<String> include;
+
+  /// Glob patterns of entries to leave out.
+  final List<String> exclude;
+
+  /// Directory inside the archive to extract, e.g. `photos` for
+  /// `photos/...` (but not `photos2/...`), or null for the whole archive.
+  final String? prefix;
+
+  /// Smallest unpacked size of files to extract, in bytes.
+  final int minSize;
+
+  /// Largest unpacked size of files to extract, in bytes, 0 for no limit.
+  final int maxSize;
+
+  Pointer<RarFilterNative> _toNative() {
+    Pointer<Pointer<Utf8>> strings(List<String> patterns) {
+      if (patterns.isEmpty) return nullptr;
+      final list = calloc<Pointer<Utf8>>(patterns.length);
+      for (var i = 0; i < patterns.length; i++) {
+        list[i] = patterns[i].toNativeUtf8();
+      }
+      return list;
+    }
+
+    return calloc<RarFilterNative>()
+      ..ref.include = strings(include)
+      ..ref.includeCount = include.length
+      ..ref.exclude = strings(exclude)
+      ..ref.excludeCount = exclude.length
+      ..ref.prefix = prefix?.toNativeUtf8() ?? nullptr
+      ..ref.minSize = minSize
+      ..ref.maxSize = maxSize;
+  }
+
+  static void _free(Pointer<RarFilterNative> native) {
+    void strings(Pointer<Pointer<Utf8>> list, int count) {
+      if (list == nullptr) return;
+      for (var i = 0; i < count; i++) {
+        calloc.free(list[i]);
+      }
+      calloc.free(list);
+    }
+
+    final filter = native.ref;
+    strings(filter.include, filter.includeCount);
+    strings(filter.exclude, filter.excludeCount);
+    if (filter.prefix != nullptr) calloc.free(filter.prefix);
+    calloc.free(native);
+  }
+}
+
+/// A directory of entry indexes saved by [RarArchive.open], see
+/// [RarOptions.indexCache].
+///
+/// An archive whose size, modification time and first 4 KB are unchanged is
+/// opened from its saved index instead of its headers. Archives with
+/// encrypted headers are never saved. One cache can serve any number of
+/// concurrent opens; [close] it once none is running.
+class RarIndexCache {
+  RarIndexCache._(this.directory, this._address);
+
+  /// Directory holding the index files.
+  final String directory;
+
+  // Native rar_index_cache_t, 0 once closed
+  int _address;
+
+  /// Open [directory], creating it if needed. Beyond [maxBytes] of index
+  /// files (0 for no limit) the least recently used ones are removed.
+  static Future<RarIndexCache> open(String directory, {int maxBytes = 0}) {
+    return _workers.run(() {
+      final dirPtr = directory.toNativeUtf8();
+      final outCache = calloc<Pointer<Void>>();
+      try {
+        final result = _bindings.indexCacheOpen(dirPtr, maxBytes, outCache);
+        if (result != 0) {
+          throw RarException(result, _bindings.errorMessage(result));
+        }
+        return RarIndexCache._(directory, outCache.value.address);
+      } finally {
+        calloc.free(dirPtr);
+        calloc.free(outCache);
+      }
+    });
+  }
+
+  int get _checkedAddress {
+    if (_address == 0) throw StateError('RarIndexCache has been closed');
+    return _address;
+  }
+
+  /// Change the size limit (0 for none), removing index files to fit.
+  Future<void> setMaxBytes(int maxBytes) =>
+      _setMaxBytes(_checkedAddress, maxBytes);
+
+  // Worker tasks are built in static methods so they capture no instance
+  static Future<void> _setMaxBytes(int address, int maxBytes) {
+    return _workers.run(() {
+      _bindings.indexCacheSetLimit(Pointer.fromAddress(address), maxBytes);
+    });
+  }
+
+  /// Forget the saved index of the archive at [path].
+  Future<void> invalidate(String path) => _invalidate(_checkedAddress, path);
+
+  /// Forget every saved index.
+  Future<void> clear() => _invalidate(_checkedAddress, null);
+
+  static Future<void> _invalidate(int address, String? path) {
+    return _workers.run(() {
+      final pathPtr = path?.toNativeUtf8() ?? nullptr;
+      try {
+        final result = _bindings.indexCacheInvalidate(
+          Pointer.fromAddress(address),
+          pathPtr,
+        );
+        if (result != 0) {
+          throw RarException(result, _bindings.errorMessage(result));
+        }
+      } finally {
+        if (pathPtr != nullptr) calloc.free(pathPtr);
+      }
+    });
+  }
+
+  /// Release the native cache; the directory and its files stay. Later
+  /// opens with this cache parse headers as if there were none.
+  void close() {
+    if (_address == 0) return;
+    _bindings.indexCacheClose(Pointer.fromAddress(_address));
+    _address = 0;
+  }
+}
+
+/// Snapshot of a running extraction, see [RarOperation.progress].
+class RarProgress {
+  const RarProgress({
+    required this.entriesDone,
+    required this.entriesTotal,
+    required this.bytesIn,
+    required this.bytesOut,
+    required this.bytesTotal,
+    this.entryIndex,
+    this.entryName,
+  });
+
+  /// Entries written so far.
+  final int entriesDone;
+
+  /// Number of entries, or null when unknown (one-shot extraction does not
+  /// scan the archive up front).
+  final int? entriesTotal;
+
+  /// Packed bytes consumed from the archive.
+  final int bytesIn;
+
+  /// Unpacked bytes written.
+  final int bytesOut;
+
+  /// Unpacked size of everything being extracted, or null when unknown.
+  final int? bytesTotal;
+
+  /// Entry being extracted, or null for the final report.
+  final int? entryIndex;
+
+  /// Path of [entryIndex] inside the archive, when known.
+  final String? entryName;
+
+  /// Fraction of [bytesTotal] written so far, or null when unknown.
+  double? get fraction {
+    final total = bytesTotal;
+    if (total == null || total == 0) return null;
+    return bytesOut / total;
+  }
+
+  @override
+  String toString() =>
+      'RarProgress($entriesDone/${entriesTotal ?? '?'} entries, '
+      '$bytesOut/${bytesTotal ?? '?'} bytes)';
+}
+
+/// Where the time of an extraction went, see [RarOptions.collectStats].
+///
+/// Times are summed over every native thread taking part, so parallel and
+/// pipelined extraction can report more than the elapsed time. All zero
+/// when the native library was built with `RAR_NO_STATS`.
+class RarStats {
+  const RarStats({
+    required this.headerTime,
+    required this.readTime,
+    required this.createTime,
+    required this.writeTime,
+    required this.finishTime,
+    required this.mkdirTime,
+    required this.headers,
+    required this.entriesWritten,
+    required this.bytesDecoded,
+    required this.bytesWritten,
+    this.cacheHits = 0,
+    this.cacheMisses = 0,
+  });
+
+  RarStats._fromNative(RarStatsNative native)
+    : headerTime = Duration(microseconds: native.headerNs ~/ 1000),
+      readTime = Duration(microseconds: native.readNs ~/ 1000),
+      createTime = Duration(microseconds: native.createNs ~/ 1000),
+      writeTime = Duration(microseconds: native.writeNs ~/ 1000),
+      finishTime = Duration(microseconds: native.finishNs ~/ 1000),
+      mkdirTime = Duration(microseconds: native.mkdirNs ~/ 1000),
+      headers = native.headers,
+      entriesWritten = native.entriesWritten,
+      bytesDecoded = native.bytesDecoded,
+      bytesWritten = native.bytesWritten,
+      cacheHits = native.cacheHits,
+      cacheMisses = native.cacheMisses;
+
+  /// Reading headers, including skipping data that was not extracted.
+  final Duration headerTime;
+
+  /// Decompressing and checking CRCs.
+  final Duration readTime;
+
+  /// Creating output files.
+  final Duration createTime;
+
+  /// Writing output files.
+  final Duration writeTime;
+
+  /// Restoring times, permissions and other metadata.
+  final Duration finishTime;
+
+  /// Creating the parent directories of entries.
+  final Duration mkdirTime;
+
+  /// Headers read; parallel readers each read their own.
+  final int headers;
+
+  /// Entries extracted.
+  final int entriesWritten;
+
+  /// Unpacked bytes decompressed.
+  final int bytesDecoded;
+
+  /// Bytes written to extracted files.
+  final int bytesWritten;
+
+  /// Entry reads served by the entry cache, see
+  /// [RarOptions.entryCacheBytes].
+  final int cacheHits;
+
+  /// Entry reads the entry cache had to decompress.
+  final int cacheMisses;
+
+  @override
+  String toString() =>
+      'RarStats(headers $headerTime, read $readTime, create $createTime, '
+      'write $writeTime, finish $finishTime, mkdir $mkdirTime, '
+      '$entriesWritten entries, $bytesWritten bytes)';
+}
+
+/// A native operation running in the background.
+class RarOperation<T> {
+  RarOperation._(this.result, this.progress, this._cancelToken);
+
+  // Native rar_cancel_token, freed (and reset to nullptr) once done
+  Pointer<Void> _cancelToken;
+
+  /// Completes with the outcome of the operation.
+  final Future<T> result;
+
+  /// Progress reports, at most one per [RarOptions.progressIntervalMs] plus
+  /// a final one. The stream closes when [result] completes; reports sent
+  /// before anyone listens are dropped.
+  final Stream<RarProgress> progress;
+
+  /// Per-phase timings, set once [result] completes if the operation ran
+  /// with [RarOptions.collectStats].
+  RarStats? get stats => _stats;
+  RarStats? _stats;
+
+  /// Ask the operation to stop. It notices within one data block; [result]
+  /// then fails with a [RarException] whose code is
+  /// [RarException.cancelled] (or reports failure, for
+  /// [RarFfi.startExtractRarFile]). The file being written is removed,
+  /// completed files are kept. Does nothing once the operation is done.
+  void cancel() {
+    if (_cancelToken != nullptr) _bindings.cancel(_cancelToken);
+  }
+}
+
+// Starts [body] with a progress listener, a cancellation token and, with
+// [collectStats], a rar_stats block, and hands it their native addresses.
+// Reports are posted from native threads to this isolate.
+RarOperation<T> _startOperation<T>(
+  Future<T> Function(int progressCallback, int cancelToken, int stats) body, {
+  String? Function(int index)? nameOf,
+  bool collectStats = false,
+}) {
+  final controller = StreamController<RarProgress>.broadcast();
+  final callable = NativeCallable<RarProgressCallbackC>.listener((
+    int entriesDone,
+    int entriesTotal,
+    int bytesIn,
+    int bytesOut,
+    int bytesTotal,
+    int entryIndex,
+    Pointer<Utf8> entryName,
+    Pointer<Void> userData,
+  ) {
+    // entryName is gone by now; resolve the index instead
+    if (controller.isClosed) return;
+    controller.add(
+      RarProgress(
+        entriesDone: entriesDone,
+        entriesTotal: entriesTotal < 0 ? null : entriesTotal,
+        bytesIn: bytesIn,
+        bytesOut: bytesOut,
+        bytesTotal: bytesTotal < 0 ? null : bytesTotal,
+        entryIndex: entryIndex < 0 ? null : entryIndex,
+        entryName: entryIndex < 0 ? null : nameOf?.call(entryIndex),
+      ),
+    );
+  });
+
+  final token = _bindings.cancelTokenNew();
+  if (token == nullptr) {
+    callable.close();
+    controller.close();
+    throw RarException(4, _bindings.errorMessage(4));
+  }
+
+  // Zeroed by calloc, as rar_stats requires
+  final stats = collectStats ? calloc<RarStatsNative>() : nullptr;
+
+  late final RarOperation<T> operation;
+  // Reports are queued ahead of the isolate's result, so none are lost here
+  final result =
+      body(callable.nativeFunction.address, token.address, stats.address)
+          .whenComplete(() {
+            operation._cancelToken = nullptr;
+            _bindings.cancelTokenFree(token);
+            callable.close();
+            controller.close();
+            if (stats != nullptr) {
+              operation._stats = RarStats._fromNative(stats.ref);
+              calloc.free(stats);
+            }
+          });
+  operation = RarOperation._(result, controller.stream, token);
+  return operation;
+}
+
+/// Metadata for one entry of an opened [RarArchive].
+class RarEntry {
+  const RarEntry({
+    required this.index,
+    required this.name,
+    required this.size,
+    required this.packedSize,
+    required this.modified,
+    required this.crc32,
+    required this.mode,
+    required this.flags,
+  });
+
+  static const int flagDirectory = 0x0001;
+  static const int flagEncrypted = 0x0002;
+  static const int flagSolid = 0x0004;
+  static const int flagStored = 0x0008;
+  static const int flagSplitBefore = 0x0010;
+  static const int flagSplitAfter = 0x0020;
+  static const int flagHasCrc = 0x0040;
+
+  /// Position of the entry in the archive.
+  final int index;
+
+  /// Path of the entry inside the archive.
+  final String name;
+
+  /// Unpacked size in bytes.
+  final int size;
+
+  /// Packed size in bytes.
+  final int packedSize;
+
+  /// Modification time.
+  final DateTime modified;
+
+  /// CRC32 of the unpacked data (only meaningful if [hasCrc]).
+  final int crc32;
+
+  /// POSIX file type and permission bits.
+  final int mode;
+
+  /// Raw `RAR_ENTRY_*` flags.
+  final int flags;
+
+  bool get isDirectory => flags & flagDirectory != 0;
+  bool get isEncrypted => flags & flagEncrypted != 0;
+  bool get isStored => flags & flagStored != 0;
+  bool get hasCrc => flags & flagHasCrc != 0;
+
+  factory RarEntry._fromNative(int index, RarEntryInfoNative info) {
+    return RarEntry(
+      index: index,
+      name: info.name.toDartString(),
+      size: info.size,
+      packedSize: info.packedSize,
+      modified: DateTime.fromMillisecondsSinceEpoch(info.mtime * 1000),
+      crc32: info.crc32,
+      mode: info.mode,
+      flags: info.flags,
+    );
+  }
+}
+
+/// An opened RAR archive whose entry index is cached in native memory.
+///
+/// Headers are parsed once by [open]; [length], [entryAt], [entries] and
+/// [indexOf] read the cached index without touching the archive again.
+/// Call [close] when done. Pending extractions keep the handle alive until
+/// they finish, and a finalizer releases it if [close] is never called.
+class RarArchive implements Finalizable {
+  RarArchive._(this.path, this._handle, this.options) {
+    _finalizer.attach(this, _handle, detach: this);
+  }
+
+  static final NativeFinalizer _finalizer = NativeFinalizer(
+    _bindings.closePointer.cast(),
+  );
+
+  /// Path the archive was opened from.
+  final String path;
+
+  /// Options the archive was opened with.
+  final RarOptions options;
+
+  Pointer<Void> _handle;
+  int _pending = 0;
+  bool _closeRequested = false;
+
+  /// Open [path] and parse its headers into a native index.
+  ///
+  /// [options] apply to every later operation on the archive.
+  /// Throws a [RarException] if the archive cannot be opened.
+  static Future<RarArchive> open(
+    String path, {
+    String? password,
+    RarOptions options = const RarOptions(),
+  }) async {
+    final address = await _openInIsolate(path, password, options);
+    return RarArchive._(path, Pointer<Void>.fromAddress(address), options);
+  }
+
+  static Future<int> _openInIsolate(
+    String path,
+    String? password,
+    RarOptions options,
+  ) {
+    return _workers.run(() {
+      final rarPathPtr = path.toNativeUtf8();
+      final passwordPtr = password?.toNativeUtf8() ?? nullptr;
+      final optionsPtr = calloc<RarOptionsNative>();
+      final outArchive = calloc<Pointer<Void>>();
+      try {
+        options._writeTo(optionsPtr.ref);
+        final result = _bindings.openEx(
+          rarPathPtr,
+          passwordPtr,
+          optionsPtr,
+          outArchive,
+          nullptr,
+        );
+        if (result != 0) {
+          throw RarException(result, _bindings.errorMessage(result));
+        }
+        return outArchive.value.address;
+      } finally {
+        calloc.free(rarPathPtr);
+        if (passwordPtr != nullptr) calloc.free(passwordPtr);
+        RarOptions._release(optionsPtr.ref);
+        calloc.free(optionsPtr);
+        calloc.free(outArchive);
+      }
+    });
+  }
+
+  Pointer<Void> get _checkedHandle {
+    if (_handle == nullptr || _closeRequested) {
+      throw StateError('RarArchive has been closed');
+    }
+    return _handle;
+  }
 
-  if (Platform.isAndroid) {
-    _lib = DynamicLibrary.open('librar_native.so');
-  } else if (Platform.isLinux) {
-    _lib = DynamicLibrary.open('librar_native.so');
-  } else if (Platform.isWindows) {
-    _lib = DynamicLibrary.open('rar_native.dll');
-  } else if (Platform.isMacOS) {
+  /// Number of entries in the archive.
+  int get length => _bindings.entryCount(_checkedHandle);
+
+  /// Entry cache hits and misses so far, see [RarOptions.entryCacheBytes].
+  /// The timing fields are zero.
+  RarStats get stats {
+    final native = calloc<RarStatsNative>();
     try {
-      _lib = DynamicLibrary.open('librar_native.dylib');
+      _bindings.archiveStats(_checkedHandle, native);
+      return RarStats._fromNative(native.ref);
+    } finally {
+      calloc.free(native);
+    }
+  }
+
+  /// Metadata for the entry at [index].
+  RarEntry entryAt(int index) {
+    final info = calloc<RarEntryInfoNative>();
+    try {
+      final result = _bindings.stat(_checkedHandle, index, info);
+      if (result != 0) {
+        throw RarException(result, _bindings.errorMessage(result));
+      }
+      return RarEntry._fromNative(index, info.ref);
+    } finally {
+      calloc.free(info);
+    }
+  }
+
+  /// Metadata for every entry, in archive order.
+  List<RarEntry> get entries {
+    final entries = <RarEntry>[];
+    _readEntryPages(_checkedHandle, (info, index) {
+      entries.add(RarEntry._fromNative(index, info));
+    });
+    return entries;
+  }
+
+  /// Index of the entry named [name], or -1 if there is none.
+  int indexOf(String name) {
+    final namePtr = name.toNativeUtf8();
+    try {
+      return _bindings.findEntry(_checkedHandle, namePtr);
+    } finally {
+      calloc.free(namePtr);
+    }
+  }
+
+  /// Extract every entry to [destinationPath].
+  Future<void> extractAll(String destinationPath) {
+    return startExtractAll(destinationPath).result;
+  }
+
+  /// Extract every entry to [destinationPath], reporting progress.
+  RarOperation<void> startExtractAll(String destinationPath) {
+    return _startOperation(
+      (callback, cancelToken, stats) => _run(
+        (address) => _extractAllInIsolate(
+          address,
+          destinationPath,
+          options,
+          callback,
+          cancelToken,
+          stats,
+        ),
+      ),
+      nameOf: _nameOrNull,
+      collectStats: options.collectStats,
+    );
+  }
+
+  /// Extract only the entry at [index] to [destinationPath].
+  Future<void> extractEntry(int index, String destinationPath) {
+    return startExtractEntry(index, destinationPath).result;
+  }
+
+  /// Extract only the entry at [index] to [destinationPath], reporting
+  /// progress.
+  RarOperation<void> startExtractEntry(int index, String destinationPath) {
+    return _startOperation(
+      (callback, cancelToken, stats) => _run(
+        (address) => _extractEntryInIsolate(
+          address,
+          index,
+          destinationPath,
+          options,
+          callback,
+          cancelToken,
+          stats,
+        ),
+      ),
+      nameOf: _nameOrNull,
+      collectStats: options.collectStats,
+    );
+  }
+
+  // Entry name for a progress report, null once the handle is gone.
+  String? _nameOrNull(int index) {
+    if (_handle == nullptr) return null;
+    final info = calloc<RarEntryInfoNative>();
+    try {
+      if (_bindings.stat(_handle, index, info) != 0) return null;
+      return info.ref.name.toDartString();
+    } finally {
+      calloc.free(info);
+    }
+  }
+
+  /// Decompress the entry at [index] into memory without writing any files.
+  ///
+  /// The returned list is a view over the native buffer, which is released
+  /// by a finalizer once the list is no longer reachable.
+  Future<Uint8List> readEntry(int index) async {
+    final (dataAddress, length) = await _run(
+      (address) => _readEntryInIsolate(address, index),
+    );
+    return Pointer<Uint8>.fromAddress(
+      dataAddress,
+    ).asTypedList(length, finalizer: _bindings.bufferFreePointer.cast());
+  }
+
+  /// Decompress the entry named [name] into memory.
+  ///
+  /// Throws a [RarException] if the archive has no such entry.
+  Future<Uint8List> readEntryNamed(String name) {
+    final index = indexOf(name);
+    if (index < 0) {
+      return Future.error(
+        RarException(
+          RarException.entryNotFound,
+          _bindings.errorMessage(RarException.entryNotFound),
+        ),
+      );
+    }
+    return readEntry(index);
+  }
+
+  /// Decompress the entry at [index] into a caller-owned native [buffer]
+  /// of [capacity] bytes and return the number of bytes written.
+  ///
+  /// Throws a [RarException] with [RarException.bufferTooSmall] if
+  /// [capacity] is smaller than the entry's unpacked size.
+  Future<int> readEntryInto(int index, Pointer<Uint8> buffer, int capacity) {
+    final bufferAddress = buffer.address;
+    return _run(
+      (address) =>
+          _readEntryIntoInIsolate(address, index, bufferAddress, capacity),
+    );
+  }
+
+  /// Read up to [length] bytes of the entry at [index], starting [offset]
+  /// bytes into its data, into a caller-owned native [buffer].
+  ///
+  /// Returns the number of bytes read, which is less than [length] at the
+  /// end of the entry and 0 past it. Stored entries are read directly from
+  /// the archive; compressed ones are decompressed up to [offset], and
+  /// reading forward from where the previous read stopped is cheap.
+  Future<int> readAt(
+    int index,
+    int offset,
+    Pointer<Uint8> buffer,
+    int length,
+  ) {
+    final bufferAddress = buffer.address;
+    return _run(
+      (address) =>
+          _readAtInIsolate(address, index, offset, bufferAddress, length),
+    );
+  }
+
+  /// Read up to [length] bytes of the entry at [index] starting at
+  /// [offset]. See [readAt].
+  Future<Uint8List> readRange(int index, int offset, int length) async {
+    final buffer = calloc<Uint8>(length > 0 ? length : 1);
+    try {
+      final read = await readAt(index, offset, buffer, length);
+      return Uint8List.fromList(buffer.asTypedList(read));
+    } finally {
+      calloc.free(buffer);
+    }
+  }
+
+  /// Stream the decompressed data of the entry at [index].
+  ///
+  /// Decompression runs in a background isolate and chunks of roughly
+  /// [chunkSize] bytes are delivered as they are produced. The decoder runs
+  /// at most [chunksInFlight] chunks ahead of the listener and waits while
+  /// the subscription is paused (as `await for` does during its body), so a
+  /// slow consumer never has more than that many chunks in memory. Each
+  /// stream has a background isolate to itself, so other calls made while
+  /// it is paused still run. A paused stream keeps that isolate waiting, so
+  /// cancel streams that are no longer read: cancelling stops decompression,
+  /// and the future the cancel returns completes once the isolate is done
+  /// with the handle.
+  Stream<Uint8List> streamEntry(
+    int index, {
+    int chunkSize = 1 << 20,
+    int chunksInFlight = 4,
+  }) {
+    late final StreamController<Uint8List> controller;
+    // NULL before listening and once freed; the rar_flow_* calls allow it
+    Pointer<Void> flow = nullptr;
+    var owed = 0; // Credits of chunks delivered while paused
+    var cancelled = false;
+    Future<void>? done;
+
+    void onChunk(Uint8List chunk) {
+      controller.add(chunk);
+      if (controller.isPaused) {
+        owed++;
+      } else {
+        _bindings.flowRelease(flow, 1);
+      }
+    }
+
+    controller = StreamController<Uint8List>(
+      onListen: () {
+        flow = _bindings.flowNew(chunksInFlight > 0 ? chunksInFlight : 1);
+        if (flow == nullptr) {
+          const memoryError = 4; // RAR_MEMORY_ERROR
+          controller.addError(
+            RarException(memoryError, _bindings.errorMessage(memoryError)),
+          );
+          controller.close();
+          return;
+        }
+        final flowAddress = flow.address;
+        done = _run(
+          (address) => _streamEntryFromIsolate(
+            address,
+            index,
+            chunkSize,
+            flowAddress,
+            onChunk,
+          ),
+        )
+            .catchError((Object e) {
+              if (!cancelled) controller.addError(e);
+            })
+            .whenComplete(() {
+              _bindings.flowFree(flow);
+              flow = nullptr;
+              controller.close();
+            });
+      },
+      onResume: () {
+        if (owed > 0) _bindings.flowRelease(flow, owed);
+        owed = 0;
+      },
+      onCancel: () {
+        cancelled = true;
+        _bindings.flowClose(flow);
+        return done;
+      },
+    );
+    return controller.stream;
+  }
+
+  static Future<void> _streamEntryFromIsolate(
+    int address,
+    int index,
+    int chunkSize,
+    int flowAddress,
+    void Function(Uint8List chunk) onChunk,
+  ) async {
+    final receivePort = ReceivePort();
+    final sendPort = receivePort.sendPort;
+    // The worker reports the result on sendPort after the last chunk. It
+    // blocks in rar_flow_acquire while the listener is paused, possibly
+    // waiting on other calls, so it must not share its worker with them.
+    unawaited(
+      _workers
+          .run(
+            _streamEntryTask(sendPort, address, index, chunkSize, flowAddress),
+            exclusive: true,
+          )
+          .catchError((Object _) => sendPort.send(9)), // RAR_UNKNOWN_ERROR
+    );
+
+    await for (final message in receivePort) {
+      if (message is TransferableTypedData) {
+        onChunk(message.materialize().asUint8List());
+        continue;
+      }
+      receivePort.close();
+      final result = message as int;
+      if (result != 0) {
+        throw RarException(result, _bindings.errorMessage(result));
+      }
+    }
+  }
+
+  // Built outside the async caller so the closure captures only these values
+  static void Function() _streamEntryTask(
+    SendPort sendPort,
+    int address,
+    int index,
+    int chunkSize,
+    int flowAddress,
+  ) {
+    return () => _streamEntryIsolate(
+      [sendPort, address, index, chunkSize, flowAddress],
+    );
+  }
+
+  static void _streamEntryIsolate(List<dynamic> args) {
+    final sendPort = args[0] as SendPort;
+    final address = args[1] as int;
+    final index = args[2] as int;
+    final chunkSize = args[3] as int;
+    final flowAddress = args[4] as int;
+
+    var result = 9; // RAR_UNKNOWN_ERROR
+    try {
+      _isolateStreamPort = sendPort;
+      final dataCallback = Pointer.fromFunction<RarDataCallbackC>(
+        _isolateStreamCallback,
+        1, // Stop if the callback throws
+      );
+      result = _bindings.streamEntry(
+        Pointer<Void>.fromAddress(address),
+        index,
+        dataCallback,
+        Pointer<Void>.fromAddress(flowAddress),
+        chunkSize,
+      );
     } catch (e) {
-      _lib = DynamicLibrary.process();
+      dev.log('Error in isolate: $e');
+    } finally {
+      _isolateStreamPort = null;
+      sendPort.send(result);
     }
-  } else {
-    throw UnsupportedError('Unknown platform: ${Platform.operatingSystem}');
   }
-  return _lib!;
+
+  static Future<(int, int)> _readEntryInIsolate(int address, int index) {
+    return _workers.run(() {
+      final outData = calloc<Pointer<Uint8>>();
+      final outLen = calloc<Size>();
+      try {
+        final result = _bindings.extractEntryToBuffer(
+          Pointer<Void>.fromAddress(address),
+          index,
+          outData,
+          outLen,
+        );
+        if (result != 0) {
+          throw RarException(result, _bindings.errorMessage(result));
+        }
+        return (outData.value.address, outLen.value);
+      } finally {
+        calloc.free(outData);
+        calloc.free(outLen);
+      }
+    });
+  }
+
+  static Future<int> _readEntryIntoInIsolate(
+    int address,
+    int index,
+    int bufferAddress,
+    int capacity,
+  ) {
+    return _workers.run(() {
+      final outLen = calloc<Size>();
+      try {
+        final result = _bindings.extractEntryToMemory(
+          Pointer<Void>.fromAddress(address),
+          index,
+          Pointer<Uint8>.fromAddress(bufferAddress),
+          capacity,
+          outLen,
+        );
+        if (result != 0) {
+          throw RarException(result, _bindings.errorMessage(result));
+        }
+        return outLen.value;
+      } finally {
+        calloc.free(outLen);
+      }
+    });
+  }
+
+  static Future<int> _readAtInIsolate(
+    int address,
+    int index,
+    int offset,
+    int bufferAddress,
+    int length,
+  ) {
+    return _workers.run(() {
+      final outRead = calloc<Size>();
+      try {
+        final result = _bindings.readAt(
+          Pointer<Void>.fromAddress(address),
+          index,
+          offset,
+          Pointer<Uint8>.fromAddress(bufferAddress),
+          length,
+          outRead,
+        );
+        if (result != 0) {
+          throw RarException(result, _bindings.errorMessage(result));
+        }
+        return outRead.value;
+      } finally {
+        calloc.free(outRead);
+      }
+    });
+  }
+
+  static Future<void> _extractAllInIsolate(
+    int address,
+    String destPath,
+    RarOptions options,
+    int progressCallback,
+    int cancelToken,
+    int stats,
+  ) {
+    return _workers.run(() {
+      final destPathPtr = destPath.toNativeUtf8();
+      final optionsPtr = calloc<RarOptionsNative>();
+      try {
+        options._writeTo(
+          optionsPtr.ref,
+          progressCallback: progressCallback,
+          cancelToken: cancelToken,
+          stats: stats,
+        );
+        final result = _bindings.extractAllEx(
+          Pointer<Void>.fromAddress(address),
+          destPathPtr,
+          optionsPtr,
+          nullptr,
+        );
+        if (result != 0) {
+          throw RarException(result, _bindings.errorMessage(result));
+        }
+      } finally {
+        calloc.free(destPathPtr);
+        RarOptions._release(optionsPtr.ref);
+        calloc.free(optionsPtr);
+      }
+    });
+  }
+
+  static Future<void> _extractEntryInIsolate(
+    int address,
+    int index,
+    String destPath,
+    RarOptions options,
+    int progressCallback,
+    int cancelToken,
+    int stats,
+  ) {
+    return _workers.run(() {
+      final destPathPtr = destPath.toNativeUtf8();
+      final optionsPtr = calloc<RarOptionsNative>();
+      try {
+        options._writeTo(
+          optionsPtr.ref,
+          progressCallback: progressCallback,
+          cancelToken: cancelToken,
+          stats: stats,
+        );
+        final result = _bindings.extractEntryEx(
+          Pointer<Void>.fromAddress(address),
+          index,
+          destPathPtr,
+          optionsPtr,
+          nullptr,
+        );
+        if (result != 0) {
+          throw RarException(result, _bindings.errorMessage(result));
+        }
+      } finally {
+        calloc.free(destPathPtr);
+        RarOptions._release(optionsPtr.ref);
+        calloc.free(optionsPtr);
+      }
+    });
+  }
+
+  // Runs a background operation while keeping the handle open.
+  Future<T> _run<T>(Future<T> Function(int address) operation) async {
+    final address = _checkedHandle.address;
+    _pending++;
+    try {
+      return await operation(address);
+    } finally {
+      _pending--;
+      if (_closeRequested && _pending == 0) _release();
+    }
+  }
+
+  /// Release the native handle. Safe to call more than once.
+  void close() {
+    _closeRequested = true;
+    if (_pending == 0) _release();
+  }
+
+  void _release() {
+    if (_handle == nullptr) return;
+    _finalizer.detach(this);
+    _bindings.close(_handle);
+    _handle = nullptr;
+  }
+}
+
+// Number of entries fetched per rar_list_batch call
+const int _entryPageSize = 1024;
+
+// Names decoded by _packedNamesSliced between returns to the event loop
+const int _nameSliceSize = 4096;
+
+// Decodes names packed back to back with NUL terminators, reading the
+// native bytes in place. Runs on the calling isolate, so it yields to the
+// event loop after every _nameSliceSize names to keep frames being drawn.
+// `names` must stay valid until the future completes.
+Future<List<String>> _packedNamesSliced(Pointer<Utf8> names, int length) async {
+  if (length == 0) return <String>[];
+  final bytes = names.cast<Uint8>().asTypedList(length);
+  final files = <String>[];
+  var start = 0;
+  var sliceEnd = _nameSliceSize;
+  for (var i = 0; i < length; i++) {
+    if (bytes[i] != 0) continue;
+    files.add(utf8.decode(Uint8List.sublistView(bytes, start, i)));
+    start = i + 1;
+    if (files.length == sliceEnd) {
+      sliceEnd += _nameSliceSize;
+      await Future<void>.delayed(Duration.zero);
+    }
+  }
+  return files;
+}
+
+// Walk the native index of [handle] one page of structs at a time.
+void _readEntryPages(
+  Pointer<Void> handle,
+  void Function(RarEntryInfoNative info, int index) visit,
+) {
+  final page = calloc<RarEntryInfoNative>(_entryPageSize);
+  final count = calloc<Size>();
+  try {
+    var start = 0;
+    for (;;) {
+      final result = _bindings.listBatch(
+        handle,
+        start,
+        page,
+        _entryPageSize,
+        count,
+      );
+      if (result != 0) {
+        throw RarException(result, _bindings.errorMessage(result));
+      }
+      final n = count.value;
+      if (n == 0) break;
+      for (var i = 0; i < n; i++) {
+        visit(page[i], start + i);
+      }
+      start += n;
+    }
+  } finally {
+    calloc.free(page);
+    calloc.free(count);
+  }
 }
 
-// Global list for the current isolate to store files during listing
-List<String>? _isolateFileList;
+// Port the current streaming isolate forwards decompressed chunks to
+SendPort? _isolateStreamPort;
 
-// Static callback function for FFI
-void _isolateListCallback(Pointer<Utf8> filename) {
-  _isolateFileList?.add(filename.toDartString());
+// Static data callback for rar_stream_entry. The block is only valid for the
+// duration of the call, so it is copied into a transferable buffer here.
+// `userData` is the stream's rar_flow_t: each chunk takes a credit, which
+// the listening side returns once it has delivered the chunk, and a closed
+// flow (the subscription was cancelled) stops decompression.
+int _isolateStreamCallback(
+  Pointer<Void> data,
+  int size,
+  int offset,
+  Pointer<Void> userData,
+) {
+  final port = _isolateStreamPort;
+  if (port == null || _bindings.flowAcquire(userData) != 0) return 1;
+  final bytes = data.cast<Uint8>().asTypedList(size);
+  port.send(TransferableTypedData.fromList([bytes]));
+  return 0;
 }
 
 class RarFfi extends RarPlatform {
@@ -89,30 +2054,70 @@ class RarFfi extends RarPlatform {
     required String rarFilePath,
     required String destinationPath,
     String? password,
-  }) async {
-    return Isolate.run(() {
-      final lib = _library;
-      final extractFunc = lib.lookupFunction<RarExtractC, RarExtractDart>(
-        'rar_extract',
-      );
-      final getErrorFunc = lib
-          .lookupFunction<RarGetErrorMessageC, RarGetErrorMessageDart>(
-            'rar_get_error_message',
-          );
+  }) {
+    return startExtractRarFile(
+      rarFilePath: rarFilePath,
+      destinationPath: destinationPath,
+      password: password,
+    ).result;
+  }
+
+  /// Like [extractRarFile], with [options] and a progress stream.
+  ///
+  /// The archive is not scanned up front, so progress totals are unknown.
+  RarOperation<Map<String, dynamic>> startExtractRarFile({
+    required String rarFilePath,
+    required String destinationPath,
+    String? password,
+    RarOptions options = const RarOptions(),
+  }) {
+    return _startOperation(
+      (callback, cancelToken, stats) => _extractRarFileInIsolate(
+        rarFilePath,
+        destinationPath,
+        password,
+        options,
+        callback,
+        cancelToken,
+        stats,
+      ),
+      collectStats: options.collectStats,
+    );
+  }
+
+  static Future<Map<String, dynamic>> _extractRarFileInIsolate(
+    String rarFilePath,
+    String destinationPath,
+    String? password,
+    RarOptions options,
+    int progressCallback,
+    int cancelToken,
+    int stats,
+  ) {
+    return _workers.run(() {
+      final extractFunc = _bindings.extractEx;
+      final getErrorFunc = _bindings.getErrorMessage;
 
       final rarPathPtr = rarFilePath.toNativeUtf8();
       final destPathPtr = destinationPath.toNativeUtf8();
       final passwordPtr = password?.toNativeUtf8() ?? nullptr;
+      final optionsPtr = calloc<RarOptionsNative>();
 
-      // We can't easily pass a Dart callback to C when running in Isolate.run
-      // without NativeCallable.listener, but here we just need the return code.
-      // For detailed errors, we rely on the return code and get_error_message.
+      // Errors are reported through the return code and get_error_message;
+      // progress goes to the listener behind progressCallback.
 
       try {
+        options._writeTo(
+          optionsPtr.ref,
+          progressCallback: progressCallback,
+          cancelToken: cancelToken,
+          stats: stats,
+        );
         final result = extractFunc(
           rarPathPtr,
           destPathPtr,
           passwordPtr,
+          optionsPtr,
           nullptr,
         );
 
@@ -130,113 +2135,357 @@ class RarFfi extends RarPlatform {
         calloc.free(rarPathPtr);
         calloc.free(destPathPtr);
         if (passwordPtr != nullptr) calloc.free(passwordPtr);
+        RarOptions._release(optionsPtr.ref);
+        calloc.free(optionsPtr);
+      }
+    });
+  }
+
+  @override
+  Future<List<Map<String, dynamic>>> extractMany({
+    required List<String> rarFilePaths,
+    required List<String> destinationPaths,
+    String? password,
+  }) {
+    if (rarFilePaths.length != destinationPaths.length) {
+      throw ArgumentError(
+        'rarFilePaths and destinationPaths must have the same length',
+      );
+    }
+    return _runBatch(
+      [
+        for (var i = 0; i < rarFilePaths.length; i++)
+          (_jobExtract, rarFilePaths[i], destinationPaths[i]),
+      ],
+      password,
+      (result) async => result.code == 0
+          ? {'success': true, 'message': 'Extraction completed successfully'}
+          : {'success': false, 'message': _bindings.errorMessage(result.code)},
+    );
+  }
+
+  @override
+  Future<List<Map<String, dynamic>>> listMany({
+    required List<String> rarFilePaths,
+    String? password,
+  }) {
+    return _runBatch(
+      [for (final path in rarFilePaths) (_jobList, path, null)],
+      password,
+      (result) async => result.code == 0
+          ? {
+              'success': true,
+              'message': 'Successfully listed RAR contents',
+              'files': await _packedNamesSliced(result.names, result.namesLen),
+            }
+          : {
+              'success': false,
+              'message': _bindings.errorMessage(result.code),
+              'files': <String>[],
+            },
+    );
+  }
+
+  // RAR_JOB_* values
+  static const int _jobList = 0;
+  static const int _jobExtract = 1;
+
+  // Submits [jobs] as one asynchronous native batch. Native threads do the
+  // work, so no isolate is involved; the completion callback is posted back
+  // to this isolate, which converts and frees the results. Conversion runs
+  // on this isolate, usually the UI isolate, so it returns to the event
+  // loop between results and [convert] may do so within one.
+  static Future<List<Map<String, dynamic>>> _runBatch(
+    List<(int, String, String?)> jobs,
+    String? password,
+    Future<Map<String, dynamic>> Function(RarJobResultNative result) convert,
+  ) {
+    final count = jobs.length;
+    if (count == 0) return Future.value(<Map<String, dynamic>>[]);
+
+    final strings = <Pointer<Utf8>>[];
+    Pointer<Utf8> native(String? value) {
+      if (value == null) return nullptr;
+      final ptr = value.toNativeUtf8();
+      strings.add(ptr);
+      return ptr;
+    }
+
+    final jobsPtr = calloc<RarJobNative>(count);
+    final resultsPtr = calloc<RarJobResultNative>(count);
+    final optionsPtr = calloc<RarOptionsNative>();
+    final passwordPtr = native(password);
+    for (var i = 0; i < count; i++) {
+      final (type, rarPath, destPath) = jobs[i];
+      jobsPtr[i]
+        ..type = type
+        ..rarPath = native(rarPath)
+        ..destPath = native(destPath)
+        ..password = passwordPtr;
+    }
+    const RarOptions()._writeTo(optionsPtr.ref);
+
+    void release() {
+      for (final ptr in strings) {
+        calloc.free(ptr);
       }
+      calloc.free(jobsPtr);
+      calloc.free(resultsPtr);
+      calloc.free(optionsPtr);
+    }
+
+    final completer = Completer<List<Map<String, dynamic>>>();
+    late final NativeCallable<RarBatchCallbackC> done;
+    done = NativeCallable<RarBatchCallbackC>.listener((
+      int jobCount,
+      int failedCount,
+      Pointer<Void> userData,
+    ) {
+      done.close();
+      completer.complete(() async {
+        try {
+          final converted = <Map<String, dynamic>>[];
+          for (var i = 0; i < count; i++) {
+            if (i > 0) await Future<void>.delayed(Duration.zero);
+            converted.add(await convert(resultsPtr[i]));
+          }
+          return converted;
+        } finally {
+          _bindings.batchResultsFree(resultsPtr, count);
+          release();
+        }
+      }());
     });
+
+    final result = _bindings.batchSubmit(
+      jobsPtr,
+      count,
+      0,
+      optionsPtr,
+      resultsPtr,
+      done.nativeFunction,
+      nullptr,
+    );
+    if (result != 0) {
+      done.close();
+      release();
+      return Future.error(RarException(result, _bindings.errorMessage(result)));
+    }
+    return completer.future;
   }
 
+  // The worker only opens the archive and hands back the handle; the names
+  // are then decoded here straight from the handle's native name arena, so
+  // the listing is never built in the worker and copied across. The price
+  // is that decoding runs on the calling isolate, usually the UI isolate:
+  // it is done in slices of _nameSliceSize names with a return to the event
+  // loop between them, so a 100k-entry listing costs a few milliseconds per
+  // frame rather than one long stall, and the handle is closed on a worker.
   @override
   Future<Map<String, dynamic>> listRarContents({
     required String rarFilePath,
     String? password,
   }) async {
-    // We need to use a port to receive callbacks from the isolate
-    final receivePort = ReceivePort();
-
-    await Isolate.spawn(_listRarContentsIsolate, [
-      receivePort.sendPort,
-      rarFilePath,
-      password,
-    ]);
+    final listing = await _workers.run(
+      () => _listRarContentsIsolate(rarFilePath, password),
+    );
+    final handle = listing.remove('handle') as int?;
+    if (handle == null) return listing;
 
-    final result = await receivePort.first as Map<String, dynamic>;
-    return result;
+    final archive = Pointer<Void>.fromAddress(handle);
+    final names = calloc<Pointer<Utf8>>();
+    final length = calloc<Size>();
+    try {
+      final result = _bindings.entryNames(archive, names, length);
+      if (result != 0) {
+        return {
+          'success': false,
+          'message': _bindings.errorMessage(result),
+          'files': <String>[],
+          'rarVersion': listing['rarVersion'],
+        };
+      }
+      listing['files'] = await _packedNamesSliced(names.value, length.value);
+      return listing;
+    } catch (e) {
+      return {'success': false, 'message': 'Error: $e', 'files': <String>[]};
+    } finally {
+      calloc.free(names);
+      calloc.free(length);
+      unawaited(_workers.run(_closeHandleTask(handle)));
+    }
   }
 
-  static void _listRarContentsIsolate(List<dynamic> args) {
-    final sendPort = args[0] as SendPort;
-    final rarFilePath = args[1] as String;
-    final password = args[2] as String?;
+  // Built outside the async caller so the closure captures only the address
+  static void Function() _closeHandleTask(int address) {
+    return () => _bindings.close(Pointer<Void>.fromAddress(address));
+  }
 
+  // Returns the result map, with the open handle's address under 'handle'
+  // instead of 'files' on success
+  static Map<String, dynamic> _listRarContentsIsolate(
+    String rarFilePath,
+    String? password,
+  ) {
     try {
-      final lib = _library;
-      final listFunc = lib.lookupFunction<RarListC, RarListDart>('rar_list');
-      final getErrorFunc = lib
-          .lookupFunction<RarGetErrorMessageC, RarGetErrorMessageDart>(
-            'rar_get_error_message',
-          );
+      final getErrorFunc = _bindings.getErrorMessage;
 
       final rarPathPtr = rarFilePath.toNativeUtf8();
       final passwordPtr = password?.toNativeUtf8() ?? nullptr;
-
-      // Initialize the static list for this isolate
-      _isolateFileList = <String>[];
-
-      // Use Pointer.fromFunction for synchronous callback
-      final listCallback = Pointer.fromFunction<RarListCallbackC>(
-        _isolateListCallback,
-      );
+      final outArchive = calloc<Pointer<Void>>();
 
       try {
-        final result = listFunc(rarPathPtr, passwordPtr, listCallback, nullptr);
+        // The signature is read once, ahead of the open, for both outcomes
+        final rarVersion = _detectRarVersion(rarFilePath);
+        final result = _bindings.open(
+          rarPathPtr,
+          passwordPtr,
+          outArchive,
+          nullptr,
+        );
 
         if (result == 0) {
-          sendPort.send({
+          return {
             'success': true,
             'message': 'Successfully listed RAR contents',
-            'files': _isolateFileList, // Send the populated list
-            'rarVersion': _detectRarVersion(rarFilePath),
-          });
+            'handle': outArchive.value.address,
+            'rarVersion': rarVersion,
+          };
         } else {
           final errorMsgPtr = getErrorFunc(result);
           final errorMsg = errorMsgPtr.toDartString();
-          sendPort.send({
+          return {
             'success': false,
             'message': errorMsg,
             'files': <String>[],
-            'rarVersion': _detectRarVersion(rarFilePath),
-          });
+            'rarVersion': rarVersion,
+          };
         }
       } finally {
         calloc.free(rarPathPtr);
         if (passwordPtr != nullptr) calloc.free(passwordPtr);
-        _isolateFileList = null; // Cleanup
+        calloc.free(outArchive);
       }
     } catch (e) {
       dev.log('Error in isolate: $e');
-      sendPort.send({
+      return {
         'success': false,
         'message': 'Error: $e',
         'files': <String>[],
-      });
+      };
     }
   }
 
+  /// `rar_probe_info.flags` bits (`RAR_ARCHIVE_*` in src/rar_native.h).
+  static const int _archiveSolid = 0x0001;
+  static const int _archiveVolume = 0x0002;
+  static const int _archiveEncryptedHeaders = 0x0004;
+  static const int _archiveRecoveryRecord = 0x0008;
+  static const int _archiveLocked = 0x0010;
+
+  static String _versionName(int version) => switch (version) {
+    5 => 'RAR5',
+    4 => 'RAR4',
+    _ => 'Unknown',
+  };
+
+  // Signature check through rar_probe; null when the file cannot be opened.
   static String? _detectRarVersion(String filePath) {
+    final pathPtr = filePath.toNativeUtf8();
+    final info = calloc<RarProbeInfoNative>();
     try {
-      final file = File(filePath);
-      if (!file.existsSync()) return null;
+      final result = _bindings.probe(pathPtr, info);
+      if (result == 1) return null;
+      return _versionName(info.ref.version);
+    } finally {
+      calloc.free(pathPtr);
+      calloc.free(info);
+    }
+  }
 
-      final bytes = file.openSync().readSync(8);
+  @override
+  Future<Map<String, dynamic>> probeRar({required String rarFilePath}) {
+    return _workers.run(() => _probeRarIsolate(rarFilePath));
+  }
 
-      if (bytes.length >= 7) {
-        final sig0 = [0x52, 0x61, 0x72, 0x21, 0x1A, 0x07, 0x00];
-        final sig1 = [0x52, 0x61, 0x72, 0x21, 0x1A, 0x07, 0x01, 0x00];
+  static Map<String, dynamic> _probeRarIsolate(String rarFilePath) {
+    final pathPtr = rarFilePath.toNativeUtf8();
+    final info = calloc<RarProbeInfoNative>();
+    try {
+      final result = _bindings.probe(pathPtr, info);
+      final probe = info.ref;
+      final flags = probe.flags;
+      return {
+        'success': result == 0,
+        'message': result == 0
+            ? 'Successfully probed RAR file'
+            : _bindings.errorMessage(result),
+        'rarVersion': _versionName(probe.version),
+        'solid': flags & _archiveSolid != 0,
+        'encryptedHeaders': flags & _archiveEncryptedHeaders != 0,
+        'multiVolume': flags & _archiveVolume != 0,
+        'volumeIndex': probe.volumeIndex < 0 ? null : probe.volumeIndex,
+        'recoveryRecord': flags & _archiveRecoveryRecord != 0,
+        'locked': flags & _archiveLocked != 0,
+        'entryCount': probe.entryCount < 0 ? null : probe.entryCount,
+        'fileSize': probe.fileSize,
+      };
+    } finally {
+      calloc.free(pathPtr);
+      calloc.free(info);
+    }
+  }
 
-        bool matches(List<int> sig) {
-          if (bytes.length < sig.length) return false;
-          for (var i = 0; i < sig.length; i++) {
-            if (bytes[i] != sig[i]) return false;
-          }
-          return true;
-        }
+  @override
+  Future<Map<String, dynamic>> testRar({
+    required String rarFilePath,
+    String? password,
+  }) {
+    return _workers.run(() => _testRarIsolate(rarFilePath, password));
+  }
 
-        if (matches(sig1)) return 'RAR5';
-        if (matches(sig0)) return 'RAR4';
+  static Map<String, dynamic> _testRarIsolate(
+    String rarFilePath,
+    String? password,
+  ) {
+    final pathPtr = rarFilePath.toNativeUtf8();
+    final passwordPtr = password?.toNativeUtf8() ?? nullptr;
+    final report = calloc<RarTestReportNative>();
+    try {
+      final result = _bindings.test(
+        pathPtr,
+        passwordPtr,
+        0,
+        nullptr,
+        report,
+        nullptr,
+      );
+      final failures = <Map<String, dynamic>>[];
+      for (var i = 0; i < report.ref.failureCount; i++) {
+        final failure = report.ref.failures[i];
+        failures.add({
+          'index': failure.index,
+          'name': failure.name.toDartString(),
+          'code': failure.code,
+          'message': failure.message == nullptr
+              ? _bindings.errorMessage(failure.code)
+              : failure.message.toDartString(),
+        });
       }
-    } catch (e) {
-      // Ignore
+      return {
+        'success': result == 0,
+        'message': result == 0
+            ? 'All entries are intact'
+            : _bindings.errorMessage(result),
+        'entriesTested': report.ref.entriesTested,
+        'failures': failures,
+      };
+    } finally {
+      _bindings.testReportFree(report);
+      calloc.free(pathPtr);
+      if (passwordPtr != nullptr) calloc.free(passwordPtr);
+      calloc.free(report);
     }
-    return 'Unknown';
   }
 
   @override
@@ -1,6 +1,11 @@
 // lib/src/rar_ffi_stub.dart
 //
 // Stub for FFI implementation on platforms where dart:ffi is not available (Web).
+// It also mirrors the public handle API of rar_ffi.dart so code using it
+// compiles on web; opening an archive or index cache fails there. Methods
+// taking native buffers (readEntryInto, readAt) have no web counterpart.
+
+import 'dart:typed_data';
 
 import '../rar_platform_interface.dart';
 
@@ -22,3 +27,240 @@ class RarFfi extends RarPlatform {
     throw UnimplementedError('FFI not supported on this platform');
   }
 }
+
+UnsupportedError _unsupported() =>
+    UnsupportedError('RarArchive needs dart:ffi and is not available on web');
+
+/// Stub of the error raised by the handle-based [RarArchive] API.
+class RarException implements Exception {
+  const RarException(this.code, this.message);
+
+  static const int entryNotFound = 10;
+  static const int bufferTooSmall = 11;
+  static const int cancelled = 12;
+
+  final int code;
+  final String message;
+
+  @override
+  String toString() => 'RarException($code): $message';
+}
+
+/// Stub of the I/O tuning for [RarArchive.open].
+class RarOptions {
+  const RarOptions({
+    this.ioMode = ioAuto,
+    this.readBlockSize = 0,
+    this.writeBufferSize = 0,
+    this.progressIntervalMs = 0,
+    this.pipelineBlocks = 0,
+    this.writeMode = writeFaithful,
+    this.indexCache,
+    this.collectStats = false,
+    this.entryCacheBytes = 0,
+    this.prefetchEntries = 0,
+    this.filter,
+    this.extractThreads = 0,
+  });
+
+  static const int ioAuto = 0;
+  static const int ioRead = 1;
+  static const int writeFaithful = 0;
+  static const int writeFast = 1;
+
+  final int ioMode;
+  final int readBlockSize;
+  final int writeBufferSize;
+  final int progressIntervalMs;
+  final int pipelineBlocks;
+  final int writeMode;
+  final RarIndexCache? indexCache;
+  final bool collectStats;
+  final int entryCacheBytes;
+  final int prefetchEntries;
+  final RarFilter? filter;
+  final int extractThreads;
+}
+
+/// Stub of the extraction filter, see [RarOptions.filter].
+class RarFilter {
+  const RarFilter({
+    this.include = const [],
+    this.exclude = const [],
+    this.prefix,
+    this.minSize = 0,
+    this.maxSize = 0,
+  });
+
+  final List<String> include;
+  final List<String> exclude;
+  final String? prefix;
+  final int minSize;
+  final int maxSize;
+}
+
+/// Stub of the saved entry index directory, which cannot be opened on web.
+class RarIndexCache {
+  RarIndexCache._(this.directory);
+
+  final String directory;
+
+  static Future<RarIndexCache> open(String directory, {int maxBytes = 0}) =>
+      Future.error(_unsupported());
+
+  Future<void> setMaxBytes(int maxBytes) => Future.error(_unsupported());
+
+  Future<void> invalidate(String path) => Future.error(_unsupported());
+
+  Future<void> clear() => Future.error(_unsupported());
+
+  void close() {}
+}
+
+/// Stub of an extraction progress snapshot.
+class RarProgress {
+  const RarProgress({
+    required this.entriesDone,
+    required this.entriesTotal,
+    required this.bytesIn,
+    required this.bytesOut,
+    required this.bytesTotal,
+    this.entryIndex,
+    this.entryName,
+  });
+
+  final int entriesDone;
+  final int? entriesTotal;
+  final int bytesIn;
+  final int bytesOut;
+  final int? bytesTotal;
+  final int? entryIndex;
+  final String? entryName;
+
+  double? get fraction {
+    final total = bytesTotal;
+    if (total == null || total == 0) return null;
+    return bytesOut / total;
+  }
+}
+
+/// Stub of the per-phase extraction timings.
+class RarStats {
+  const RarStats({
+    required this.headerTime,
+    required this.readTime,
+    required this.createTime,
+    required this.writeTime,
+    required this.finishTime,
+    required this.mkdirTime,
+    required this.headers,
+    required this.entriesWritten,
+    required this.bytesDecoded,
+    required this.bytesWritten,
+    this.cacheHits = 0,
+    this.cacheMisses = 0,
+  });
+
+  final Duration headerTime;
+  final Duration readTime;
+  final Duration createTime;
+  final Duration writeTime;
+  final Duration finishTime;
+  final Duration mkdirTime;
+  final int headers;
+  final int entriesWritten;
+  final int bytesDecoded;
+  final int bytesWritten;
+  final int cacheHits;
+  final int cacheMisses;
+}
+
+/// Stub of a background operation, never started on web.
+class RarOperation<T> {
+  RarOperation._(this.result, this.progress);
+
+  final Future<T> result;
+  final Stream<RarProgress> progress;
+
+  RarStats? get stats => null;
+
+  void cancel() {}
+}
+
+/// Stub of the metadata for one archive entry.
+class RarEntry {
+  const RarEntry({
+    required this.index,
+    required this.name,
+    required this.size,
+    required this.packedSize,
+    required this.modified,
+    required this.crc32,
+    required this.mode,
+    required this.flags,
+  });
+
+  static const int flagDirectory = 0x0001;
+  static const int flagEncrypted = 0x0002;
+  static const int flagSolid = 0x0004;
+  static const int flagStored = 0x0008;
+  static const int flagSplitBefore = 0x0010;
+  static const int flagSplitAfter = 0x0020;
+  static const int flagHasCrc = 0x0040;
+
+  final int index;
+  final String name;
+  final int size;
+  final int packedSize;
+  final DateTime modified;
+  final int crc32;
+  final int mode;
+  final int flags;
+
+  bool get isDirectory => flags & flagDirectory != 0;
+  bool get isEncrypted => flags & flagEncrypted != 0;
+  bool get isStored => flags & flagStored != 0;
+  bool get hasCrc => flags & flagHasCrc != 0;
+}
+
+/// Stub of an opened archive; [open] always fails on web.
+class RarArchive {
+  RarArchive._(this.path, this.options);
+
+  final String path;
+  final RarOptions options;
+
+  static Future<RarArchive> open(
+    String path, {
+    String? password,
+    RarOptions options = const RarOptions(),
+  }) => Future.error(_unsupported());
+
+  int get length => throw _unsupported();
+  RarStats get stats => throw _unsupported();
+  RarEntry entryAt(int index) => throw _unsupported();
+  List<RarEntry> get entries => throw _unsupported();
+  int indexOf(String name) => throw _unsupported();
+
+  Future<void> extractAll(String destinationPath) =>
+      Future.error(_unsupported());
+  RarOperation<void> startExtractAll(String destinationPath) =>
+      throw _unsupported();
+  Future<void> extractEntry(int index, String destinationPath) =>
+      Future.error(_unsupported());
+  RarOperation<void> startExtractEntry(int index, String destinationPath) =>
+      throw _unsupported();
+
+  Future<Uint8List> readEntry(int index) => Future.error(_unsupported());
+  Future<Uint8List> readEntryNamed(String name) =>
+      Future.error(_unsupported());
+  Future<Uint8List> readRange(int index, int offset, int length) =>
+      Future.error(_unsupported());
+  Stream<Uint8List> streamEntry(
+    int index, {
+    int chunkSize = 1 << 20,
+    int chunksInFlight = 4,
+  }) => Stream.error(_unsupported());
+
+  void close() {}
+}
@@ -1,22 +1,203 @@
 // lib/src/rar_method_channel.dart
 //
 // MethodChannel implementation for the RAR plugin.
-// Used on Android and iOS where native implementations communicate via platform channels.
+// Used on iOS and macOS where native implementations communicate via platform
+// channels, and on Linux and Windows where the desktop plugins run calls on a
+// native executor and report progress over an event channel. Calls the
+// desktop plugins have no method for go straight to the library they bundle
+// through the FFI layer.
 
+import 'dart:async';
 import 'dart:io';
 
+import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
 import '../rar_platform_interface.dart';
+import 'rar_ffi.dart' if (dart.library.js_interop) 'rar_ffi_stub.dart';
+
+/// A list or extract call started with [RarMethodChannel.startListRarContents]
+/// or [RarMethodChannel.startExtractRarFile].
+class RarJob {
+  RarJob._(this.id, this.events, this.result);
+
+  /// Identifies the job in its events and for [cancel].
+  final int id;
+
+  /// Broadcast stream of the job's events; closes after the `done` event.
+  ///
+  /// Every event is a map with `job` and `type`:
+  /// - `progress`: `entriesDone`, `entriesTotal`, `bytesOut`, `bytesTotal`
+  ///   (-1 when unknown) and `entryName`;
+  /// - `entries`: the next page of a listing as `entries`, maps with `name`,
+  ///   `size` and `isDirectory`;
+  /// - `done`: `success`, `code` (a RAR_* code) and `message`.
+  ///
+  /// Events sent before anyone listens are dropped, so listen right after
+  /// starting the job.
+  final Stream<Map<String, dynamic>> events;
+
+  /// The same map as the matching [RarMethodChannel] call.
+  final Future<Map<String, dynamic>> result;
+
+  /// Cancel the job while it is queued or running.
+  ///
+  /// Returns false once the job has finished. A cancelled job still
+  /// completes [result], with `success: false`.
+  Future<bool> cancel() async {
+    try {
+      return await RarMethodChannel._channel.invokeMethod<bool>(
+            'cancelJob',
+            {'job': id},
+          ) ??
+          false;
+    } on PlatformException {
+      return false;
+    }
+  }
+}
 
 /// Method channel implementation of [RarPlatform].
 ///
 /// This implementation uses platform channels to communicate with the native
-/// Android (JUnRar) and iOS (UnrarKit) implementations.
+/// iOS and macOS (UnrarKit) and Linux and Windows (libarchive)
+/// implementations. On Linux and Windows, [probeRar], [testRar],
+/// [extractMany] and [listMany] call the plugin's bundled `rar_native`
+/// library through [RarFfi] instead.
 class RarMethodChannel extends RarPlatform {
   /// The method channel used to interact with the native platform.
   static const MethodChannel _channel = MethodChannel('com.lkrjangid.rar');
 
+  // The desktop plugins bundle librar_native / rar_native.dll
+  static bool get _hasNativeLibrary =>
+      !kIsWeb && (Platform.isLinux || Platform.isWindows);
+
+  // Created on first use, so other platforms never load the library
+  static final RarFfi _ffi = RarFfi();
+
+  /// Events of jobs started with a `job` id (Linux and Windows).
+  static const EventChannel _events = EventChannel('com.lkrjangid.rar/events');
+
+  static int _lastJob = 0;
+  static final Map<int, StreamController<Map<String, dynamic>>> _jobs = {};
+  // Listens to [_events] while any job is unfinished
+  static StreamSubscription<dynamic>? _subscription;
+
+  /// Start a listing on the desktop executor, see [listRarContents].
+  ///
+  /// Besides the result, the job reports pages of entries as they are read.
+  /// Only Linux and Windows send events; elsewhere [RarJob.events] closes
+  /// without any.
+  RarJob startListRarContents({
+    required String rarFilePath,
+    String? password,
+  }) {
+    return _startJob(
+      'listRarContents',
+      {'rarFilePath': rarFilePath, 'password': password},
+      (result) => _listResult(result, rarFilePath),
+    );
+  }
+
+  /// Start an extraction on the desktop executor, see [extractRarFile].
+  ///
+  /// Besides the result, the job reports progress per entry and chunk.
+  RarJob startExtractRarFile({
+    required String rarFilePath,
+    required String destinationPath,
+    String? password,
+  }) {
+    return _startJob(
+      'extractRarFile',
+      {
+        'rarFilePath': rarFilePath,
+        'destinationPath': destinationPath,
+        'password': password,
+      },
+      (result) async => {
+        'success': result['success'],
+        'message': result['message'],
+      },
+    );
+  }
+
+  RarJob _startJob(
+    String method,
+    Map<String, dynamic> arguments,
+    Future<Map<String, dynamic>> Function(Map<String, dynamic>) toResult,
+  ) {
+    final id = ++_lastJob;
+    final controller = StreamController<Map<String, dynamic>>.broadcast();
+    _jobs[id] = controller;
+    // Sent before the call below, so the plugin listens when the job starts
+    _subscription ??= _events.receiveBroadcastStream().listen(
+      _dispatchEvent,
+      onError: (Object _) {},
+    );
+
+    final result = _invokeJob(method, {...arguments, 'job': id})
+        .then(toResult)
+        .whenComplete(() => _finishJob(id));
+    return RarJob._(id, controller.stream, result);
+  }
+
+  Future<Map<String, dynamic>> _invokeJob(
+    String method,
+    Map<String, dynamic> arguments,
+  ) async {
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>(
+        method,
+        arguments,
+      );
+      return {
+        'success': result?['success'] ?? false,
+        'message': result?['message'] ?? 'Unknown error',
+        'files': result?['files'] ?? <String>[],
+      };
+    } on PlatformException catch (e) {
+      return {
+        'success': false,
+        'message': 'Platform error: ${e.message}',
+        'files': <String>[],
+      };
+    } catch (e) {
+      return {'success': false, 'message': 'Error: $e', 'files': <String>[]};
+    }
+  }
+
+  static void _dispatchEvent(dynamic event) {
+    if (event is! Map) return;
+    final job = event['job'];
+    final controller = _jobs[job];
+    if (controller == null) return;
+    controller.add(Map<String, dynamic>.from(event));
+    if (event['type'] == 'done') _finishJob(job as int);
+  }
+
+  // Also called for results without a `done` event (invalid arguments,
+  // platforms without an event channel)
+  static void _finishJob(int id) {
+    _jobs.remove(id)?.close();
+    if (_jobs.isEmpty) {
+      _subscription?.cancel();
+      _subscription = null;
+    }
+  }
+
+  // Helper: the [listRarContents] map for a normalized channel result
+  Future<Map<String, dynamic>> _listResult(
+    Map<String, dynamic> result,
+    String rarFilePath,
+  ) async {
+    return {
+      'success': result['success'],
+      'message': result['message'],
+      'files': result['files'],
+      'rarVersion': await _readRarVersion(rarFilePath),
+    };
+  }
+
   @override
   Future<Map<String, dynamic>> extractRarFile({
     required String rarFilePath,
@@ -47,19 +228,7 @@ class RarMethodChannel extends RarPlatform {
     required String rarFilePath,
     String? password,
   }) async {
-    String? rarVersion;
-    try {
-      final file = File(rarFilePath);
-      if (await file.exists()) {
-        // Read enough bytes for the longest signature (8 bytes for RAR5)
-        final handle = await file.open();
-        final bytes = await handle.read(8);
-        await handle.close();
-        rarVersion = _detectRarVersion(bytes);
-      }
-    } catch (e) {
-      // Ignore errors during version detection, it's an optional field
-    }
+    final rarVersion = await _readRarVersion(rarFilePath);
 
     try {
       final result = await _channel.invokeMethod<Map<dynamic, dynamic>>(
@@ -90,6 +259,22 @@ class RarMethodChannel extends RarPlatform {
     }
   }
 
+  Future<String?> _readRarVersion(String rarFilePath) async {
+    try {
+      final file = File(rarFilePath);
+      if (await file.exists()) {
+        // Read enough bytes for the longest signature (8 bytes for RAR5)
+        final handle = await file.open();
+        final bytes = await handle.read(8);
+        await handle.close();
+        return _detectRarVersion(bytes);
+      }
+    } catch (e) {
+      // Ignore errors during version detection, it's an optional field
+    }
+    return null;
+  }
+
   String? _detectRarVersion(Uint8List data) {
     if (data.length >= 7) {
       final sig0 = [0x52, 0x61, 0x72, 0x21, 0x1A, 0x07, 0x00];
@@ -108,6 +293,54 @@ class RarMethodChannel extends RarPlatform {
     return 'Unknown';
   }
 
+  @override
+  Future<Map<String, dynamic>> probeRar({required String rarFilePath}) {
+    if (_hasNativeLibrary) return _ffi.probeRar(rarFilePath: rarFilePath);
+    return super.probeRar(rarFilePath: rarFilePath);
+  }
+
+  @override
+  Future<Map<String, dynamic>> testRar({
+    required String rarFilePath,
+    String? password,
+  }) {
+    if (_hasNativeLibrary) {
+      return _ffi.testRar(rarFilePath: rarFilePath, password: password);
+    }
+    return super.testRar(rarFilePath: rarFilePath, password: password);
+  }
+
+  @override
+  Future<List<Map<String, dynamic>>> extractMany({
+    required List<String> rarFilePaths,
+    required List<String> destinationPaths,
+    String? password,
+  }) {
+    if (_hasNativeLibrary) {
+      return _ffi.extractMany(
+        rarFilePaths: rarFilePaths,
+        destinationPaths: destinationPaths,
+        password: password,
+      );
+    }
+    return super.extractMany(
+      rarFilePaths: rarFilePaths,
+      destinationPaths: destinationPaths,
+      password: password,
+    );
+  }
+
+  @override
+  Future<List<Map<String, dynamic>>> listMany({
+    required List<String> rarFilePaths,
+    String? password,
+  }) {
+    if (_hasNativeLibrary) {
+      return _ffi.listMany(rarFilePaths: rarFilePaths, password: password);
+    }
+    return super.listMany(rarFilePaths: rarFilePaths, password: password);
+  }
+
   @override
   Future<Map<String, dynamic>> createRarArchive({
     required String outputPath,
@@ -20,6 +20,9 @@ import 'dart:typed_data';
 import 'package:web/web.dart' as web;
 
 import '../rar_platform_interface.dart';
+import 'rar_web_entry.dart';
+
+export 'rar_web_entry.dart';
 
 /// JavaScript interop types for the RAR WASM library.
 ///
@@ -40,6 +43,46 @@ extension type RarFileEntry._(JSObject _) implements JSObject {
   external int get size;
 }
 
+/// Result of [RarWebJS.openBlob].
+extension type RarSessionResult._(JSObject _) implements JSObject {
+  external bool get success;
+  external String get message;
+  external int get session;
+}
+
+/// Result of [RarWebJS.listEntries].
+extension type RarEntryListResult._(JSObject _) implements JSObject {
+  external bool get success;
+  external String get message;
+  external JSArray<RarEntryInfoJS> get entries;
+}
+
+/// Entry metadata from [RarWebJS.listEntries].
+extension type RarEntryInfoJS._(JSObject _) implements JSObject {
+  external String get name;
+  external int get size;
+  external bool get isDirectory;
+  external int get lastModified;
+}
+
+/// Result of [RarWebJS.readEntry].
+extension type RarEntryDataResult._(JSObject _) implements JSObject {
+  external bool get success;
+  external String get message;
+  external JSArrayBuffer? get data;
+}
+
+/// Result of [RarWebJS.nextEntry].
+extension type RarNextEntryResult._(JSObject _) implements JSObject {
+  external bool get success;
+  external String get message;
+  external bool get done;
+  external String get name;
+  external JSArrayBuffer? get data;
+  external int get size;
+  external int get lastModified;
+}
+
 /// JavaScript API exposed by rar_web.js
 @JS('RarWeb')
 extension type RarWebJS._(JSObject _) implements JSObject {
@@ -59,10 +102,126 @@ extension type RarWebJS._(JSObject _) implements JSObject {
     JSString? password,
   );
 
+  /// Open a Blob or File for streaming access.
+  external static JSPromise<RarSessionResult> openBlob(
+    web.Blob blob,
+    JSString? password,
+  );
+
+  /// List the entries of a session without reading their data.
+  external static JSPromise<RarEntryListResult> listEntries(int session);
+
+  /// Extract one entry of a session.
+  external static JSPromise<RarEntryDataResult> readEntry(
+    int session,
+    JSString path,
+  );
+
+  /// Start a single pass over the files of a session.
+  external static RarResult startExtract(int session);
+
+  /// Take the next file of the pass started by [startExtract].
+  external static JSPromise<RarNextEntryResult> nextEntry(int session);
+
+  /// End the pass of a session early.
+  external static void stopExtract(int session);
+
+  /// Release a session.
+  external static JSPromise<JSAny?> closeArchive(int session);
+
+  /// Set the number of pooled workers; returns the size in effect.
+  external static int configurePool(int size);
+
   /// Check if the library is initialized.
   external static bool get isInitialized;
 }
 
+/// An archive opened from a Blob or File with [RarWeb.openBlob].
+///
+/// The archive stays in a worker; listing reads headers only and each
+/// entry is extracted on its own, so the page holds one entry at a time
+/// instead of the archive and everything in it. The worker still loads the
+/// whole archive into its WebAssembly memory, so the archive must fit there.
+class RarWebArchive {
+  RarWebArchive._(this._session);
+
+  // rar_web.js session id, 0 once closed
+  int _session;
+
+  int get _checkedSession {
+    if (_session == 0) throw StateError('RarWebArchive has been closed');
+    return _session;
+  }
+
+  /// Entries in archive order, without their data.
+  Future<List<RarWebEntry>> list() async {
+    final result = await RarWebJS.listEntries(_checkedSession).toDart;
+    if (!result.success) throw Exception(result.message);
+    return [
+      for (final entry in result.entries.toDart)
+        RarWebEntry(
+          name: entry.name,
+          size: entry.size,
+          isDirectory: entry.isDirectory,
+          lastModified: entry.lastModified > 0
+              ? DateTime.fromMillisecondsSinceEpoch(entry.lastModified)
+              : null,
+        ),
+    ];
+  }
+
+  /// Extract the entry named [name].
+  ///
+  /// Entries before it are skipped, which is cheap in non-solid archives;
+  /// in solid archives they are decompressed again on every call.
+  Future<Uint8List> read(String name) async {
+    final result = await RarWebJS.readEntry(_checkedSession, name.toJS).toDart;
+    final data = result.data;
+    if (!result.success || data == null) throw Exception(result.message);
+    return data.toDart.asUint8List();
+  }
+
+  /// Extract the files of the archive one at a time, in archive order.
+  ///
+  /// The worker walks the archive once, decompressing each file a single
+  /// time, and hands its data over without a copy. It stays at most one
+  /// file ahead of the listener, so a paused subscription stops extraction
+  /// and cancelling it ends the walk. [list] and [read] throw while the
+  /// stream runs.
+  Stream<(RarWebEntry, Uint8List)> extract() async* {
+    final session = _checkedSession;
+    final started = RarWebJS.startExtract(session);
+    if (!started.success) throw Exception(started.message);
+    try {
+      for (;;) {
+        final result = await RarWebJS.nextEntry(session).toDart;
+        final data = result.data;
+        if (!result.success) throw Exception(result.message);
+        if (result.done || data == null) return;
+        final entry = RarWebEntry(
+          name: result.name,
+          size: result.size,
+          isDirectory: false,
+          lastModified: result.lastModified > 0
+              ? DateTime.fromMillisecondsSinceEpoch(result.lastModified)
+              : null,
+        );
+        yield (entry, data.toDart.asUint8List());
+      }
+    } finally {
+      RarWebJS.stopExtract(session);
+    }
+  }
+
+  /// Release the archive and its worker.
+  Future<void> close() async {
+    final session = _session;
+    if (session == 0) return;
+    _session = 0;
+    await RarWebJS.closeArchive(session).toDart;
+  }
+}
+
 /// Web implementation of [RarPlatform] using JavaScript interop.
 ///
 /// This implementation uses a WASM-based RAR library loaded via JavaScript.
@@ -313,6 +472,33 @@ class RarWeb extends RarPlatform {
     _fileLoader = loader;
   }
 
+  /// Open a Blob or File (from a file picker or drag-and-drop) for
+  /// streaming access, see [RarWebArchive].
+  ///
+  /// The archive is never read into Dart memory, but the worker loads all
+  /// of it into its WebAssembly memory, so archives larger than that memory
+  /// cannot be opened. Throws if the archive cannot be opened.
+  static Future<RarWebArchive> openBlob(
+    web.Blob blob, {
+    String? password,
+  }) async {
+    await RarWeb()._ensureInitialized();
+    final result = await RarWebJS.openBlob(blob, password?.toJS).toDart;
+    if (!result.success) throw Exception(result.message);
+    return RarWebArchive._(result.session);
+  }
+
+  /// Set how many workers run [listRarContents] and [extractRarFile] calls
+  /// at once, each with its own libarchive instance. Calls beyond that wait
+  /// for a free worker. Defaults to one less than
+  /// `navigator.hardwareConcurrency`, between 1 and 8.
+  ///
+  /// Returns the size in effect.
+  static Future<int> setWorkerPoolSize(int size) async {
+    await RarWeb()._ensureInitialized();
+    return RarWebJS.configurePool(size);
+  }
+
   /// Store file data in the virtual file system.
   /// Use this to make file data available for RAR operations.
   static void storeFileData(String path, Uint8List data) {
@@ -0,0 +1,29 @@
+// lib/src/rar_web_entry.dart
+//
+// Entry metadata for streaming access to archives on web. Shared by
+// rar_web.dart and its stub so code using it compiles on every platform.
+
+/// One entry of an archive opened with `RarWeb.openBlob`.
+class RarWebEntry {
+  const RarWebEntry({
+    required this.name,
+    required this.size,
+    required this.isDirectory,
+    this.lastModified,
+  });
+
+  /// Path inside the archive.
+  final String name;
+
+  /// Unpacked size in bytes.
+  final int size;
+
+  /// Whether the entry is a directory.
+  final bool isDirectory;
+
+  /// Modification time, if the archive records one.
+  final DateTime? lastModified;
+
+  @override
+  String toString() => 'RarWebEntry($name, $size bytes)';
+}
@@ -5,6 +5,10 @@
 
 import 'dart:typed_data';
 
+import 'rar_web_entry.dart';
+
+export 'rar_web_entry.dart';
+
 /// Stub class for RarWeb on non-web platforms.
 /// This provides the same static API so code can reference RarWeb
 /// without conditional imports in application code.
@@ -28,4 +32,34 @@ class RarWeb {
   static List<String> listVirtualFiles() {
     return [];
   }
+
+  /// Set the number of web workers (web only; returns 0 elsewhere).
+  static Future<int> setWorkerPoolSize(int size) async {
+    return 0;
+  }
+
+  /// Open a Blob or File for streaming access (web only).
+  static Future<RarWebArchive> openBlob(Object blob, {String? password}) {
+    return Future.error(UnsupportedError('RarWeb.openBlob is web only'));
+  }
+}
+
+/// Stub of the web archive returned by [RarWeb.openBlob], which never
+/// completes with one on non-web platforms.
+class RarWebArchive {
+  RarWebArchive._();
+
+  /// Entries in archive order, without their data.
+  Future<List<RarWebEntry>> list() => throw UnsupportedError('Web only');
+
+  /// Extract the entry named [name].
+  Future<Uint8List> read(String name) => throw UnsupportedError('Web only');
+
+  /// Extract the files of the archive one at a time, in archive order, in
+  /// a single pass.
+  Stream<(RarWebEntry, Uint8List)> extract() =>
+      throw UnsupportedError('Web only');
+
+  /// Release the archive and its worker.
+  Future<void> close() async {}
 }
@@ -0,0 +1,210 @@
+// lib/src/rar_worker_pool.dart
+//
+// Long-lived worker isolates for the FFI layer.
+// Each worker resolves the native library and its function pointers once and
+// then takes closures over a port, so a call costs a message round trip
+// instead of an isolate spawn.
+
+import 'dart:async';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:math' as math;
+
+/// A pool of worker isolates that run closures, like [Isolate.run] without
+/// spawning an isolate per call.
+///
+/// Workers are started on demand, up to [size]. A task goes to an idle
+/// worker if there is one, otherwise to the least loaded worker once all
+/// [size] are running. Workers running an exclusive task take no other
+/// tasks and do not count towards [size]. An idle pool does not keep the
+/// calling isolate alive.
+class RarWorkerPool {
+  RarWorkerPool({int? size}) : size = math.max(1, size ?? _defaultSize);
+
+  static int get _defaultSize => math.min(Platform.numberOfProcessors, 4);
+
+  /// Pool used by the FFI layer.
+  static final RarWorkerPool shared = RarWorkerPool();
+
+  /// Maximum number of worker isolates shared by non-exclusive tasks.
+  final int size;
+
+  final List<_Worker> _workers = [];
+  final Map<int, Completer<Object?>> _pending = {};
+  RawReceivePort? _replies;
+  int _nextId = 0;
+  bool _closed = false;
+
+  /// Number of workers started so far.
+  int get workerCount => _workers.length;
+
+  /// Run [task] on a worker isolate and return its result.
+  ///
+  /// As with [Isolate.run], [task], the values it captures and its result
+  /// must be sendable between isolates. Tasks sharing a worker run one after
+  /// another, so long-running tasks should not wait on other tasks.
+  ///
+  /// An [exclusive] task gets a worker to itself until it completes, started
+  /// past [size] if none is idle. Use it for tasks that block their isolate
+  /// until the caller has done other work, possibly on this pool.
+  Future<R> run<R>(
+    FutureOr<R> Function() task, {
+    bool exclusive = false,
+  }) async {
+    if (_closed) throw StateError('RarWorkerPool has been closed');
+
+    final worker = exclusive ? _pickIdleWorker() : _pickWorker();
+    worker.exclusive = exclusive;
+    final id = _nextId++;
+    final completer = Completer<Object?>();
+    final replies = _replyPort;
+    _pending[id] = completer;
+    replies.keepIsolateAlive = true;
+    worker.load++;
+    try {
+      final SendPort port;
+      try {
+        port = await worker.port;
+      } catch (_) {
+        // Let the next call try a fresh worker
+        _workers.remove(worker);
+        rethrow;
+      }
+      port.send((id, task));
+      return await completer.future as R;
+    } finally {
+      _pending.remove(id);
+      worker.load--;
+      if (exclusive) {
+        worker.exclusive = false;
+        // Retire the extra worker started while this one was taken
+        if (_workers.length > size && _workers.remove(worker)) _stop(worker);
+      }
+      if (_pending.isEmpty) {
+        replies.keepIsolateAlive = false;
+        if (_closed) _shutDown();
+      }
+    }
+  }
+
+  /// Stop the workers once the tasks already submitted have finished.
+  void close() {
+    if (_closed) return;
+    _closed = true;
+    if (_pending.isEmpty) _shutDown();
+  }
+
+  _Worker _pickWorker() {
+    _Worker? best;
+    var shared = 0;
+    for (final worker in _workers) {
+      if (worker.exclusive) continue;
+      shared++;
+      if (best == null || worker.load < best.load) best = worker;
+    }
+    if (best != null && (best.load == 0 || shared >= size)) return best;
+    return _addWorker();
+  }
+
+  _Worker _pickIdleWorker() {
+    for (final worker in _workers) {
+      if (!worker.exclusive && worker.load == 0) return worker;
+    }
+    return _addWorker();
+  }
+
+  _Worker _addWorker() {
+    final worker = _Worker(_spawn(_replyPort.sendPort));
+    _workers.add(worker);
+    return worker;
+  }
+
+  RawReceivePort get _replyPort {
+    var replies = _replies;
+    if (replies == null) {
+      replies = _replies = RawReceivePort(_onReply, 'rar worker replies');
+      replies.keepIsolateAlive = false;
+    }
+    return replies;
+  }
+
+  void _onReply(Object? message) {
+    final (id, ok, value, stack) = message as (int, bool, Object?, String?);
+    final completer = _pending[id];
+    if (completer == null) return;
+    if (ok) {
+      completer.complete(value);
+    } else {
+      completer.completeError(value!, StackTrace.fromString(stack ?? ''));
+    }
+  }
+
+  void _shutDown() {
+    _workers.forEach(_stop);
+    _workers.clear();
+    _replies?.close();
+    _replies = null;
+  }
+
+  static void _stop(_Worker worker) {
+    worker.port.then((port) => port.send(null), onError: (_) {});
+  }
+
+  static Future<SendPort> _spawn(SendPort replies) async {
+    final ready = ReceivePort();
+    try {
+      await Isolate.spawn(
+        _workerMain,
+        (ready.sendPort, replies),
+        debugName: 'rar worker',
+      );
+      return await ready.first as SendPort;
+    } finally {
+      ready.close();
+    }
+  }
+}
+
+class _Worker {
+  _Worker(this.port);
+
+  final Future<SendPort> port;
+
+  // Tasks sent to this worker that have not completed yet
+  int load = 0;
+
+  // Running an exclusive task, so no other task may be sent here
+  bool exclusive = false;
+}
+
+// Worker entry point: run each closure received and reply with its result.
+// A null message stops the worker.
+void _workerMain((SendPort, SendPort) ports) {
+  final (ready, replies) = ports;
+  final requests = RawReceivePort(null, 'rar worker requests');
+
+  requests.handler = (Object? message) async {
+    if (message == null) {
+      requests.close();
+      return;
+    }
+    final (id, task) = message as (int, FutureOr<Object?> Function());
+    try {
+      final value = await task();
+      try {
+        replies.send((id, true, value, null));
+      } catch (e, s) {
+        // The result could not be sent; report that instead
+        replies.send((id, false, RemoteError('$e', '$s'), '$s'));
+      }
+    } catch (e, s) {
+      try {
+        replies.send((id, false, e, '$s'));
+      } catch (_) {
+        replies.send((id, false, RemoteError('$e', '$s'), '$s'));
+      }
+    }
+  };
+
+  ready.send(requests.sendPort);
+}
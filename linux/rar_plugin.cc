@@ -5,7 +5,10 @@
 #include <sys/utsname.h>
 
 #include <cstring>
+#include <string>
+#include <utility>
 
+#include "rar_executor.h"
 #include "rar_plugin_private.h"
 
 #define RAR_PLUGIN(obj) \
@@ -14,10 +17,193 @@
 
 struct _RarPlugin {
   GObject parent_instance;
+
+  // Runs listRarContents and extractRarFile calls off the platform thread
+  rar::Executor* executor;
+
+  // Progress, entries and completion events of jobs started with a "job" id
+  FlEventChannel* events;
+  gboolean listening;
 };
 
 G_DEFINE_TYPE(RarPlugin, rar_plugin, g_object_get_type())
 
+// A job event on its way from a worker thread to the platform thread
+struct JobDelivery {
+  RarPlugin* plugin;          // Referenced
+  FlMethodCall* method_call;  // Referenced; answered by the kDone event only
+  bool list_job;
+  rar::JobEvent event;
+};
+
+// Helper: string argument `key`, or "" when missing or not a string
+static std::string string_arg(FlValue* args, const char* key) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return "";
+  }
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return "";
+  }
+  return fl_value_get_string(value);
+}
+
+// Helper: integer argument `key`, or 0 when missing or not an integer
+static int64_t int_arg(FlValue* args, const char* key) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return 0;
+  }
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_INT) {
+    return 0;
+  }
+  return fl_value_get_int(value);
+}
+
+// Helper: the event channel payload for `event`
+static FlValue* job_event_to_value(const rar::JobEvent& event) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "job", fl_value_new_int(event.job));
+  switch (event.type) {
+    case rar::JobEvent::kProgress:
+      fl_value_set_string_take(value, "type", fl_value_new_string("progress"));
+      fl_value_set_string_take(value, "entriesDone",
+                               fl_value_new_int(event.entries_done));
+      fl_value_set_string_take(value, "entriesTotal",
+                               fl_value_new_int(event.entries_total));
+      fl_value_set_string_take(value, "bytesOut",
+                               fl_value_new_int(event.bytes_out));
+      fl_value_set_string_take(value, "bytesTotal",
+                               fl_value_new_int(event.bytes_total));
+      if (!event.entry_name.empty()) {
+        fl_value_set_string_take(value, "entryName",
+                                 fl_value_new_string(event.entry_name.c_str()));
+      }
+      break;
+    case rar::JobEvent::kEntries: {
+      FlValue* entries = fl_value_new_list();
+      for (const rar::JobEvent::Entry& entry : event.entries) {
+        FlValue* item = fl_value_new_map();
+        fl_value_set_string_take(item, "name",
+                                 fl_value_new_string(entry.name.c_str()));
+        fl_value_set_string_take(
+            item, "size", fl_value_new_int(static_cast<int64_t>(entry.size)));
+        fl_value_set_string_take(item, "isDirectory",
+                                 fl_value_new_bool(entry.is_directory));
+        fl_value_append_take(entries, item);
+      }
+      fl_value_set_string_take(value, "type", fl_value_new_string("entries"));
+      fl_value_set_string_take(value, "entries", entries);
+      break;
+    }
+    case rar::JobEvent::kDone:
+      fl_value_set_string_take(value, "type", fl_value_new_string("done"));
+      fl_value_set_string_take(value, "success",
+                               fl_value_new_bool(event.code == RAR_SUCCESS));
+      fl_value_set_string_take(value, "code", fl_value_new_int(event.code));
+      fl_value_set_string_take(value, "message",
+                               fl_value_new_string(event.message.c_str()));
+      break;
+  }
+  return value;
+}
+
+// Helper: the method call result for a finished job
+static FlValue* job_result_to_value(const rar::JobEvent& event,
+                                    bool list_job) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "success",
+                           fl_value_new_bool(event.code == RAR_SUCCESS));
+  fl_value_set_string_take(value, "message",
+                           fl_value_new_string(event.message.c_str()));
+  if (list_job) {
+    FlValue* files = fl_value_new_list();
+    for (const std::string& name : event.files) {
+      fl_value_append_take(files, fl_value_new_string(name.c_str()));
+    }
+    fl_value_set_string_take(value, "files", files);
+  }
+  return value;
+}
+
+static gboolean deliver_job_event(gpointer user_data) {
+  auto* delivery = static_cast<JobDelivery*>(user_data);
+  RarPlugin* self = delivery->plugin;
+  const rar::JobEvent& event = delivery->event;
+
+  if (event.job != 0 && self->listening && self->events != nullptr) {
+    g_autoptr(FlValue) value = job_event_to_value(event);
+    fl_event_channel_send(self->events, value, nullptr, nullptr);
+  }
+  if (delivery->method_call != nullptr) {
+    g_autoptr(FlValue) result = job_result_to_value(event, delivery->list_job);
+    g_autoptr(FlMethodResponse) response =
+        FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+    fl_method_call_respond(delivery->method_call, response, nullptr);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+static void free_job_delivery(gpointer user_data) {
+  auto* delivery = static_cast<JobDelivery*>(user_data);
+  g_object_unref(delivery->plugin);
+  if (delivery->method_call != nullptr) {
+    g_object_unref(delivery->method_call);
+  }
+  delete delivery;
+}
+
+// Queues a list or extract job and answers `method_call` once it is done.
+// Events reach the main loop in the order the worker posts them.
+static void start_job(RarPlugin* self, FlMethodCall* method_call,
+                      bool list_job) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  const std::string rar_path = string_arg(args, "rarFilePath");
+  const std::string dest_path = string_arg(args, "destinationPath");
+  const std::string password = string_arg(args, "password");
+  const int64_t job = int_arg(args, "job");
+
+  if (rar_path.empty() || (!list_job && dest_path.empty())) {
+    g_autoptr(FlValue) result = fl_value_new_map();
+    fl_value_set_string_take(result, "success", fl_value_new_bool(FALSE));
+    fl_value_set_string_take(
+        result, "message",
+        fl_value_new_string(list_job
+                                ? "rarFilePath is required"
+                                : "rarFilePath and destinationPath are required"));
+    if (list_job) {
+      fl_value_set_string_take(result, "files", fl_value_new_list());
+    }
+    g_autoptr(FlMethodResponse) response =
+        FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
+  }
+
+  // Held for the job and handed over to its kDone delivery
+  g_object_ref(self);
+  g_object_ref(method_call);
+
+  rar::JobCallback on_event = [self, method_call, list_job](
+                                  rar::JobEvent&& event) {
+    const bool done = event.type == rar::JobEvent::kDone;
+    // Progress and pages of jobs without an id have no listener
+    if (!done && event.job == 0) return;
+    auto* delivery = new JobDelivery{
+        done ? self : RAR_PLUGIN(g_object_ref(self)),
+        done ? method_call : nullptr, list_job, std::move(event)};
+    g_idle_add_full(G_PRIORITY_DEFAULT, deliver_job_event, delivery,
+                    free_job_delivery);
+  };
+
+  if (list_job) {
+    self->executor->List(job, rar_path, password, std::move(on_event));
+  } else {
+    self->executor->Extract(job, rar_path, dest_path, password,
+                            std::move(on_event));
+  }
+}
+
 // Called when a method call is received from Flutter.
 static void rar_plugin_handle_method_call(
     RarPlugin* self,
@@ -26,7 +212,18 @@ static void rar_plugin_handle_method_call(
 
   const gchar* method = fl_method_call_get_name(method_call);
 
-  if (strcmp(method, "getPlatformVersion") == 0) {
+  if (strcmp(method, "listRarContents") == 0) {
+    start_job(self, method_call, true);
+    return;
+  } else if (strcmp(method, "extractRarFile") == 0) {
+    start_job(self, method_call, false);
+    return;
+  } else if (strcmp(method, "cancelJob") == 0) {
+    const int64_t job = int_arg(fl_method_call_get_args(method_call), "job");
+    g_autoptr(FlValue) result =
+        fl_value_new_bool(job != 0 && self->executor->Cancel(job));
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  } else if (strcmp(method, "getPlatformVersion") == 0) {
     response = get_platform_version();
   } else {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
@@ -44,6 +241,11 @@ FlMethodResponse* get_platform_version() {
 }
 
 static void rar_plugin_dispose(GObject* object) {
+  RarPlugin* self = RAR_PLUGIN(object);
+  // Every job holds a reference, so none is running by now
+  delete self->executor;
+  self->executor = nullptr;
+  g_clear_object(&self->events);
   G_OBJECT_CLASS(rar_plugin_parent_class)->dispose(object);
 }
 
@@ -51,7 +253,9 @@ static void rar_plugin_class_init(RarPluginClass* klass) {
   G_OBJECT_CLASS(klass)->dispose = rar_plugin_dispose;
 }
 
-static void rar_plugin_init(RarPlugin* self) {}
+static void rar_plugin_init(RarPlugin* self) {
+  self->executor = new rar::Executor();
+}
 
 static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
                            gpointer user_data) {
@@ -59,18 +263,41 @@ static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
   rar_plugin_handle_method_call(plugin, method_call);
 }
 
+static FlMethodErrorResponse* events_listen_cb(FlEventChannel* channel,
+                                               FlValue* args,
+                                               gpointer user_data) {
+  RAR_PLUGIN(user_data)->listening = TRUE;
+  return nullptr;
+}
+
+static FlMethodErrorResponse* events_cancel_cb(FlEventChannel* channel,
+                                               FlValue* args,
+                                               gpointer user_data) {
+  RAR_PLUGIN(user_data)->listening = FALSE;
+  return nullptr;
+}
+
 void rar_plugin_register_with_registrar(FlPluginRegistrar* registrar) {
   RarPlugin* plugin = RAR_PLUGIN(
       g_object_new(rar_plugin_get_type(), nullptr));
 
+  FlBinaryMessenger* messenger = fl_plugin_registrar_get_messenger(registrar);
   g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
   g_autoptr(FlMethodChannel) channel =
-      fl_method_channel_new(fl_plugin_registrar_get_messenger(registrar),
-                            "rar",
+      fl_method_channel_new(messenger,
+                            "com.lkrjangid.rar",
                             FL_METHOD_CODEC(codec));
   fl_method_channel_set_method_call_handler(channel, method_call_cb,
                                             g_object_ref(plugin),
                                             g_object_unref);
 
+  plugin->events = fl_event_channel_new(messenger,
+                                        "com.lkrjangid.rar/events",
+                                        FL_METHOD_CODEC(codec));
+  // No reference: the plugin owns this channel and drops it in dispose, so
+  // a reference here would keep the plugin from ever being disposed
+  fl_event_channel_set_stream_handlers(plugin->events, events_listen_cb,
+                                       events_cancel_cb, plugin, nullptr);
+
   g_object_unref(plugin);
 }
@@ -2,7 +2,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <future>
+
 #include "include/rar/rar_plugin.h"
+#include "rar_executor.h"
 #include "rar_plugin_private.h"
 
 // This demonstrates a simple unit test of the C portion of this plugin's
@@ -27,5 +30,20 @@ TEST(RarPlugin, GetPlatformVersion) {
   EXPECT_THAT(fl_value_get_string(result), testing::StartsWith("Linux "));
 }
 
+TEST(RarExecutor, ReportsMissingArchive) {
+  Executor executor(1);
+  std::promise<JobEvent> done;
+  executor.List(1, "/nonexistent/archive.rar", "", [&done](JobEvent&& event) {
+    if (event.type == JobEvent::kDone) done.set_value(std::move(event));
+  });
+
+  JobEvent event = done.get_future().get();
+  EXPECT_EQ(event.job, 1);
+  EXPECT_EQ(event.code, RAR_FILE_NOT_FOUND);
+  EXPECT_TRUE(event.files.empty());
+  // Finished jobs can no longer be cancelled
+  EXPECT_FALSE(executor.Cancel(1));
+}
+
 }  // namespace test
 }  // namespace rar
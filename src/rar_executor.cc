@@ -0,0 +1,219 @@
+// src/rar_executor.cc
+//
+// Thread pool behind the desktop plugins, see rar_executor.h.
+
+#include "rar_executor.h"
+
+#include <utility>
+
+namespace rar {
+
+namespace {
+
+// Entries per kEntries event of a list job
+constexpr size_t kListPage = 256;
+
+const char* PasswordOrNull(const std::string& password) {
+  return password.empty() ? nullptr : password.c_str();
+}
+
+JobEvent DoneEvent(int64_t job, int code, const char* success_message) {
+  JobEvent event;
+  event.type = JobEvent::kDone;
+  event.job = job;
+  event.code = code;
+  if (code == RAR_SUCCESS) {
+    event.message = success_message;
+  } else {
+    const char* message = rar_get_error_message(code);
+    event.message = message ? message : "Unknown error";
+  }
+  return event;
+}
+
+// user_data of OnProgress
+struct ProgressTarget {
+  int64_t job;
+  const JobCallback* on_event;
+};
+
+void OnProgress(int64_t entries_done, int64_t entries_total, int64_t bytes_in,
+                int64_t bytes_out, int64_t bytes_total, int64_t entry_index,
+                const char* entry_name, void* user_data) {
+  (void)bytes_in;
+  (void)entry_index;
+  const auto* target = static_cast<const ProgressTarget*>(user_data);
+  JobEvent event;
+  event.type = JobEvent::kProgress;
+  event.job = target->job;
+  event.entries_done = entries_done;
+  event.entries_total = entries_total;
+  event.bytes_out = bytes_out;
+  event.bytes_total = bytes_total;
+  // Only valid during the call
+  if (entry_name) event.entry_name = entry_name;
+  (*target->on_event)(std::move(event));
+}
+
+// Helper: open `rar_path` with `token` as the cancel token of the handle
+int OpenArchive(const std::string& rar_path, const std::string& password,
+                rar_cancel_token_t* token, rar_archive_t** out_archive) {
+  if (rar_is_cancelled(token)) return RAR_CANCELLED;
+  rar_options options;
+  rar_options_init(&options);
+  options.cancel_token = token;
+  return rar_open_ex(rar_path.c_str(), PasswordOrNull(password), &options,
+                     out_archive, nullptr);
+}
+
+// Names come from the handle's index, so paging never touches the archive;
+// the token is checked between pages. Returns the kDone event.
+JobEvent RunList(int64_t job, const std::string& rar_path,
+                 const std::string& password, rar_cancel_token_t* token,
+                 const JobCallback& on_event) {
+  std::vector<std::string> files;
+  rar_archive_t* archive = nullptr;
+  int code = OpenArchive(rar_path, password, token, &archive);
+
+  std::vector<rar_entry_info> page(kListPage);
+  int64_t start = 0;
+  while (code == RAR_SUCCESS) {
+    if (rar_is_cancelled(token)) {
+      code = RAR_CANCELLED;
+      break;
+    }
+    size_t count = 0;
+    code = rar_list_batch(archive, start, page.data(), page.size(), &count);
+    if (code != RAR_SUCCESS || count == 0) break;
+
+    JobEvent event;
+    event.type = JobEvent::kEntries;
+    event.job = job;
+    event.entries.resize(count);
+    for (size_t i = 0; i < count; i++) {
+      JobEvent::Entry& entry = event.entries[i];
+      entry.name = page[i].name ? page[i].name : "";
+      entry.size = page[i].size;
+      entry.is_directory = (page[i].flags & RAR_ENTRY_DIRECTORY) != 0;
+      files.push_back(entry.name);
+    }
+    on_event(std::move(event));
+    start += static_cast<int64_t>(count);
+  }
+  rar_close(archive);
+
+  JobEvent done = DoneEvent(job, code, "Successfully listed RAR contents");
+  if (code == RAR_SUCCESS) done.files = std::move(files);
+  return done;
+}
+
+// Goes through a handle so that progress has entry and byte totals
+JobEvent RunExtract(int64_t job, const std::string& rar_path,
+                    const std::string& dest_path, const std::string& password,
+                    rar_cancel_token_t* token, const JobCallback& on_event) {
+  rar_archive_t* archive = nullptr;
+  int code = OpenArchive(rar_path, password, token, &archive);
+  if (code == RAR_SUCCESS) {
+    ProgressTarget target = {job, &on_event};
+    rar_options options;
+    rar_options_init(&options);
+    options.cancel_token = token;
+    options.progress_cb = OnProgress;
+    options.progress_user_data = &target;
+    code = rar_extract_all_ex(archive, dest_path.c_str(), &options, nullptr);
+  }
+  rar_close(archive);
+  return DoneEvent(job, code, "Extraction completed successfully");
+}
+
+}  // namespace
+
+Executor::Executor(unsigned threads) {
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  if (threads == 0) threads = 2;
+  threads_.reserve(threads);
+  for (unsigned i = 0; i < threads; i++) {
+    threads_.emplace_back(&Executor::WorkerMain, this);
+  }
+}
+
+Executor::~Executor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    // Queued jobs still run, but see the cancellation and end at once
+    for (auto& entry : tokens_) rar_cancel(entry.second);
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) thread.join();
+}
+
+void Executor::List(int64_t job, const std::string& rar_path,
+                    const std::string& password, JobCallback on_event) {
+  Post(job, on_event,
+       [job, rar_path, password, on_event](rar_cancel_token_t* token) {
+         return RunList(job, rar_path, password, token, on_event);
+       });
+}
+
+void Executor::Extract(int64_t job, const std::string& rar_path,
+                       const std::string& dest_path,
+                       const std::string& password, JobCallback on_event) {
+  Post(job, on_event,
+       [job, rar_path, dest_path, password,
+        on_event](rar_cancel_token_t* token) {
+         return RunExtract(job, rar_path, dest_path, password, token,
+                           on_event);
+       });
+}
+
+bool Executor::Cancel(int64_t job) {
+  if (job == 0) return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tokens_.find(job);
+  if (it == tokens_.end()) return false;
+  rar_cancel(it->second);
+  return true;
+}
+
+void Executor::Post(int64_t job, JobCallback on_event,
+                    std::function<JobEvent(rar_cancel_token_t*)> run) {
+  rar_cancel_token_t* token = rar_cancel_token_new();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tokens_.emplace(job, token);
+    queue_.push_back(Task{job, token, std::move(run), std::move(on_event)});
+  }
+  wake_.notify_one();
+}
+
+void Executor::WorkerMain() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) return;  // Stopping, and nothing left to finish
+    Task task = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+
+    // A NULL token (out of memory) only makes the job uncancellable
+    JobEvent done = task.run(task.token);
+
+    // The job is finished for Cancel before anyone hears of it
+    lock.lock();
+    auto range = tokens_.equal_range(task.job);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == task.token) {
+        tokens_.erase(it);
+        break;
+      }
+    }
+    lock.unlock();
+    rar_cancel_token_free(task.token);
+
+    task.on_event(std::move(done));
+    lock.lock();
+  }
+}
+
+}  // namespace rar
@@ -0,0 +1,117 @@
+// src/rar_executor.h
+//
+// Shared C++ job executor for the desktop plugins (linux/, windows/).
+//
+// A fixed pool of worker threads runs list and extract jobs against
+// rar_native.c. Every job has its own rar_cancel_token, so it can be
+// cancelled while queued or running, and reports progress, pages of listed
+// entries and completion through a callback on the worker thread. The
+// plugins forward those reports to the platform thread and on to Dart over
+// their event channel, so the platform thread never waits on an archive.
+//
+// Compiles as C++14 (the Linux plugin's standard settings).
+
+#ifndef RAR_EXECUTOR_H
+#define RAR_EXECUTOR_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rar_native.h"
+
+namespace rar {
+
+// One report of a job. Which fields are set depends on `type`.
+struct JobEvent {
+  enum Type { kProgress, kEntries, kDone };
+
+  struct Entry {
+    std::string name;
+    uint64_t size = 0;
+    bool is_directory = false;
+  };
+
+  Type type = kProgress;
+  int64_t job = 0;
+
+  // kProgress: counters as in rar_progress_callback (-1 when unknown)
+  int64_t entries_done = 0;
+  int64_t entries_total = -1;
+  int64_t bytes_out = 0;
+  int64_t bytes_total = -1;
+  std::string entry_name;
+
+  // kEntries: the next page of a listing, in archive order
+  std::vector<Entry> entries;
+
+  // kDone: the RAR_* result, its message and, for list jobs, every name
+  int code = RAR_SUCCESS;
+  std::string message;
+  std::vector<std::string> files;
+};
+
+// Receives the events of one job on a worker thread. kDone is always the
+// last event and is delivered exactly once, also for cancelled jobs.
+using JobCallback = std::function<void(JobEvent&&)>;
+
+class Executor {
+ public:
+  // Starts `threads` workers; 0 uses the number of CPU cores.
+  explicit Executor(unsigned threads = 0);
+
+  // Cancels every queued and running job, waits for their kDone events and
+  // stops the workers.
+  ~Executor();
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  // Queue a listing of `rar_path`. `job` names the job in its events and
+  // for Cancel; ids must be unique among unfinished jobs, and 0 makes the
+  // job uncancellable. An empty `password` means none.
+  void List(int64_t job, const std::string& rar_path,
+            const std::string& password, JobCallback on_event);
+
+  // Queue an extraction of `rar_path` into `dest_path`, see List.
+  void Extract(int64_t job, const std::string& rar_path,
+               const std::string& dest_path, const std::string& password,
+               JobCallback on_event);
+
+  // Cancel a queued or running job. Returns false if no unfinished job has
+  // that id. The job still ends with kDone (code RAR_CANCELLED).
+  bool Cancel(int64_t job);
+
+  size_t thread_count() const { return threads_.size(); }
+
+ private:
+  struct Task {
+    int64_t job;
+    rar_cancel_token_t* token;
+    // Runs the job, reporting everything but kDone, which it returns
+    std::function<JobEvent(rar_cancel_token_t*)> run;
+    JobCallback on_event;
+  };
+
+  void Post(int64_t job, JobCallback on_event,
+            std::function<JobEvent(rar_cancel_token_t*)> run);
+  void WorkerMain();
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<Task> queue_;
+  // Tokens of unfinished jobs by id (several for id 0)
+  std::multimap<int64_t, rar_cancel_token_t*> tokens_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace rar
+
+#endif  // RAR_EXECUTOR_H
@@ -10,6 +10,11 @@
 // This implementation is shared across Linux, macOS, and Windows.
 // Each platform's build system compiles this file and links with libarchive.
 
+// fallocate() on Linux and Android
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "rar_native.h"
 
 #include <stdio.h>
@@ -17,6 +22,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <time.h>
 
 // libarchive headers
 #include <archive.h>
@@ -29,12 +35,184 @@
 #define PATH_SEP '\\'
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <dirent.h>
 #define PATH_SEP '/'
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#endif
+
+// Hardware CRC32: PCLMULQDQ folding on x86-64, CRC32 instructions on ARMv8
+#if defined(__x86_64__) || defined(_M_X64)
+#define RAR_CRC32_PCLMUL 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define RAR_CRC32_ARM 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <arm_acle.h>
+#endif
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
 #endif
 
 // Buffer size for extraction
 #define BUFFER_SIZE 65536
 
+// Bounds for automatically sized read blocks and write buffers
+#define AUTO_BLOCK_MIN (16 * 1024)
+#define AUTO_BLOCK_MAX (4 * 1024 * 1024)
+
+// Upper bound on worker threads for parallel extraction
+#define MAX_EXTRACT_THREADS 64
+
+// Progress interval used when rar_options.progress_interval_ms is 0
+#define DEFAULT_PROGRESS_INTERVAL_MS 100
+
+// Minimal threading helpers (pthreads / Win32)
+#ifdef _WIN32
+typedef HANDLE rar_thread_t;
+typedef CRITICAL_SECTION rar_mutex_t;
+typedef CONDITION_VARIABLE rar_cond_t;
+typedef DWORD (WINAPI *rar_thread_fn)(void*);
+#define RAR_THREAD_RETURN DWORD WINAPI
+#define rar_mutex_init(m) InitializeCriticalSection(m)
+#define rar_mutex_destroy(m) DeleteCriticalSection(m)
+#define rar_mutex_lock(m) EnterCriticalSection(m)
+#define rar_mutex_unlock(m) LeaveCriticalSection(m)
+#define rar_cond_init(c) InitializeConditionVariable(c)
+#define rar_cond_destroy(c) ((void)(c))
+#define rar_cond_wait(c, m) SleepConditionVariableCS((c), (m), INFINITE)
+#define rar_cond_broadcast(c) WakeAllConditionVariable(c)
+#define rar_atomic_fetch_add(p, v) InterlockedExchangeAdd64((volatile LONG64*)(p), (v))
+#define rar_atomic_load(p) InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define rar_atomic_store(p, v) InterlockedExchange64((volatile LONG64*)(p), (v))
+typedef INIT_ONCE rar_once_t;
+#define RAR_ONCE_INIT INIT_ONCE_STATIC_INIT
+
+static BOOL CALLBACK rar_once_thunk(PINIT_ONCE once, PVOID fn, PVOID* ctx) {
+    (void)once;
+    (void)ctx;
+    ((void (*)(void))fn)();
+    return TRUE;
+}
+
+static void rar_once(rar_once_t* once, void (*fn)(void)) {
+    InitOnceExecuteOnce(once, rar_once_thunk, (PVOID)fn, NULL);
+}
+
+static int rar_thread_create(rar_thread_t* t, rar_thread_fn fn, void* arg) {
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t ? 0 : -1;
+}
+
+static void rar_thread_join(rar_thread_t t) {
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+}
+
+static void rar_thread_detach(rar_thread_t t) {
+    CloseHandle(t);
+}
+
+static int rar_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+static int64_t rar_monotonic_ms(void) {
+    return (int64_t)GetTickCount64();
+}
+
+static int64_t rar_monotonic_ns(void) {
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (now.QuadPart / freq.QuadPart) * 1000000000 +
+           (now.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+}
+#else
+typedef pthread_t rar_thread_t;
+typedef pthread_mutex_t rar_mutex_t;
+typedef pthread_cond_t rar_cond_t;
+typedef void* (*rar_thread_fn)(void*);
+#define RAR_THREAD_RETURN void*
+#define rar_mutex_init(m) pthread_mutex_init((m), NULL)
+#define rar_mutex_destroy(m) pthread_mutex_destroy(m)
+#define rar_mutex_lock(m) pthread_mutex_lock(m)
+#define rar_mutex_unlock(m) pthread_mutex_unlock(m)
+#define rar_cond_init(c) pthread_cond_init((c), NULL)
+#define rar_cond_destroy(c) pthread_cond_destroy(c)
+#define rar_cond_wait(c, m) pthread_cond_wait((c), (m))
+#define rar_cond_broadcast(c) pthread_cond_broadcast(c)
+#define rar_atomic_fetch_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define rar_atomic_load(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define rar_atomic_store(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+typedef pthread_once_t rar_once_t;
+#define RAR_ONCE_INIT PTHREAD_ONCE_INIT
+#define rar_once(once, fn) pthread_once((once), (fn))
+
+static int rar_thread_create(rar_thread_t* t, rar_thread_fn fn, void* arg) {
+    return pthread_create(t, NULL, fn, arg) == 0 ? 0 : -1;
+}
+
+static void rar_thread_join(rar_thread_t t) {
+    pthread_join(t, NULL);
+}
+
+static void rar_thread_detach(rar_thread_t t) {
+    pthread_detach(t);
+}
+
+static int rar_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+static int64_t rar_monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int64_t rar_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+
+// Per-phase counters, see rar_options.stats. Every measurement goes through
+// STATS_OF, so with RAR_NO_STATS the stats pointer is a constant NULL and
+// the compiler drops the clock reads along with the branches around them.
+#ifdef RAR_NO_STATS
+#define STATS_OF(options) ((rar_stats*)NULL)
+#else
+#define STATS_OF(options) ((options)->stats)
+#endif
+
+// Start of a timed phase; 0 when nothing is measured
+#define STATS_CLOCK(stats) ((stats) ? rar_monotonic_ns() : 0)
+
+// Add `value` to a counter; `value` is only evaluated when measuring
+#define STATS_ADD(stats, field, value) \
+    do { if (stats) rar_atomic_fetch_add(&(stats)->field, (int64_t)(value)); } while (0)
+
+// Add the time since `start` (from STATS_CLOCK) to a counter
+#define STATS_SINCE(stats, field, start) STATS_ADD(stats, field, rar_monotonic_ns() - (start))
+
 // Error messages
 static const char* error_messages[] = {
     "Success",
@@ -46,17 +224,127 @@ static const char* error_messages[] = {
     "Unknown archive format (not a valid RAR file)",
     "Incorrect password or password required",
     "Data error in archive (CRC check failed)",
-    "Unknown error"
+    "Unknown error",
+    "Entry not found in archive",
+    "Output buffer too small",
+    "Operation cancelled"
 };
 
+#define ERROR_MESSAGE_COUNT ((int)(sizeof(error_messages) / sizeof(error_messages[0])))
+
 // Get error message for code
 RAR_EXPORT const char* rar_get_error_message(int error_code) {
-    if (error_code < 0 || error_code > RAR_UNKNOWN_ERROR) {
+    if (error_code < 0 || error_code >= ERROR_MESSAGE_COUNT) {
         return error_messages[RAR_UNKNOWN_ERROR];
     }
     return error_messages[error_code];
 }
 
+// Defaults used when an API is called without options
+static const rar_options default_options = {RAR_IO_AUTO, 0, 0, NULL, NULL, 0, NULL, 0, RAR_WRITE_FAITHFUL, NULL, NULL, 0, 0, NULL, 0};
+
+// Initialise options with the defaults
+RAR_EXPORT void rar_options_init(rar_options* options) {
+    if (options) *options = default_options;
+}
+
+// Whether rar_options.stats is filled in by this build
+RAR_EXPORT int rar_stats_enabled(void) {
+#ifdef RAR_NO_STATS
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+static const rar_options* options_or_default(const rar_options* options) {
+    return options ? options : &default_options;
+}
+
+struct rar_cancel_token {
+    int64_t cancelled;      // Atomic
+};
+
+RAR_EXPORT rar_cancel_token_t* rar_cancel_token_new(void) {
+    return calloc(1, sizeof(rar_cancel_token_t));
+}
+
+RAR_EXPORT void rar_cancel(rar_cancel_token_t* token) {
+    if (token) rar_atomic_store(&token->cancelled, 1);
+}
+
+RAR_EXPORT int rar_is_cancelled(const rar_cancel_token_t* token) {
+    return token && rar_atomic_load(&((rar_cancel_token_t*)token)->cancelled) != 0;
+}
+
+RAR_EXPORT void rar_cancel_token_free(rar_cancel_token_t* token) {
+    free(token);
+}
+
+// Helper: Flag a cancelled reader. map_archive_error turns the ECANCELED
+// errno into RAR_CANCELLED, so cancellation travels the normal error path.
+static int fail_cancelled(struct archive* a) {
+    archive_set_error(a, ECANCELED, "Operation cancelled");
+    return ARCHIVE_FATAL;
+}
+
+// Helper: archive_read_next_header that stops once the options' cancel
+// token is set, timed into their stats
+static int read_next_header(struct archive* a, struct archive_entry** entry, const rar_options* options) {
+    if (rar_is_cancelled(options->cancel_token)) return fail_cancelled(a);
+    rar_stats* stats = STATS_OF(options);
+    int64_t start = STATS_CLOCK(stats);
+    int r = archive_read_next_header(a, entry);
+    STATS_SINCE(stats, header_ns, start);
+    if (r == ARCHIVE_OK) STATS_ADD(stats, headers, 1);
+    return r;
+}
+
+// Helper: Buffer size for a file of `file_size` bytes on a file system whose
+// preferred I/O size is `fs_block`. About 1/64th of the file, as a power of
+// two between AUTO_BLOCK_MIN and AUTO_BLOCK_MAX, and at least fs_block.
+static size_t auto_block_size(int64_t file_size, int64_t fs_block) {
+    size_t size = AUTO_BLOCK_MIN;
+    while (size < AUTO_BLOCK_MAX && (int64_t)size * 64 < file_size) size *= 2;
+    while (size < AUTO_BLOCK_MAX && (int64_t)size < fs_block) size *= 2;
+    return size;
+}
+
+// Helper: Size of a path and its file system's preferred I/O size (0 if unknown)
+static void path_io_hint(const char* path, int64_t* size, int64_t* fs_block) {
+#ifdef _WIN32
+    struct _stat64 st;
+    int ok = _stat64(path, &st) == 0;
+    *size = ok ? (int64_t)st.st_size : 0;
+    *fs_block = 0;
+#else
+    struct stat st;
+    int ok = stat(path, &st) == 0;
+    *size = ok ? (int64_t)st.st_size : 0;
+    *fs_block = ok ? (int64_t)st.st_blksize : 0;
+#endif
+}
+
+// Helper: Write buffer size for extracting rar_path below dest_path
+static size_t resolve_write_buffer_size(const rar_options* options, const char* rar_path, const char* dest_path) {
+    int64_t archive_size, dest_block, unused;
+    if (options->write_buffer_size > 0) return options->write_buffer_size;
+    path_io_hint(rar_path, &archive_size, &unused);
+    path_io_hint(dest_path, &unused, &dest_block);
+    return auto_block_size(archive_size, dest_block);
+}
+
+#ifdef _WIN32
+// Helper: Convert a UTF-8 path for the wide Win32 API; the caller frees it
+static wchar_t* utf8_to_wide(const char* path) {
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+    if (wlen <= 0) return NULL;
+    wchar_t* wpath = malloc((size_t)wlen * sizeof(wchar_t));
+    if (wpath) MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, wlen);
+    return wpath;
+}
+#endif
+
 // Helper: Create directory and parent directories
 static int create_directory_recursive(const char* path) {
     char* path_copy = strdup(path);
@@ -107,275 +395,5252 @@ static int create_directory_recursive(const char* path) {
     return (result == 0 || errno == EEXIST) ? 0 : -1;
 }
 
-// Helper: Get parent directory of a path
-static char* get_parent_directory(const char* path) {
-    char* result = strdup(path);
-    if (!result) return NULL;
+// Bump allocator for strings that live until the arena is reset
+typedef struct arena_chunk {
+    struct arena_chunk* next;
+    size_t used;
+    size_t cap;
+    char data[];
+} arena_chunk;
 
-    // Find last separator
-    char* last_sep = strrchr(result, PATH_SEP);
-    if (!last_sep) {
-        last_sep = strrchr(result, '/');
-    }
+typedef struct {
+    arena_chunk* head;      // Chunk being filled; older chunks follow
+} path_arena;
 
-    if (last_sep && last_sep != result) {
-        *last_sep = '\0';
+// Helper: Copy `len` bytes of `s` plus a terminator into the arena
+static char* arena_strndup(path_arena* arena, const char* s, size_t len) {
+    arena_chunk* c = arena->head;
+    if (!c || c->cap - c->used < len + 1) {
+        size_t cap = c ? c->cap * 2 : 16 * 1024;
+        if (cap < len + 1) cap = len + 1;
+        c = malloc(sizeof(arena_chunk) + cap);
+        if (!c) return NULL;
+        c->next = arena->head;
+        c->used = 0;
+        c->cap = cap;
+        arena->head = c;
     }
-
-    return result;
+    char* p = c->data + c->used;
+    memcpy(p, s, len);
+    p[len] = '\0';
+    c->used += len + 1;
+    return p;
 }
 
-// Helper: Copy archive data to file
-static int copy_data(struct archive* ar, struct archive* aw) {
-    const void* buff;
-    size_t size;
-    int64_t offset;
-    int r;
+// Helper: Forget every string but keep the newest (largest) chunk
+static void arena_reset(path_arena* arena) {
+    arena_chunk* c = arena->head;
+    if (!c) return;
+    while (c->next) {
+        arena_chunk* old = c->next;
+        c->next = old->next;
+        free(old);
+    }
+    c->used = 0;
+}
 
-    for (;;) {
-        r = archive_read_data_block(ar, &buff, &size, &offset);
-        if (r == ARCHIVE_EOF) return ARCHIVE_OK;
-        if (r != ARCHIVE_OK) return r;
+static void arena_free(path_arena* arena) {
+    while (arena->head) {
+        arena_chunk* c = arena->head;
+        arena->head = c->next;
+        free(c);
+    }
+}
 
-        r = archive_write_data_block(aw, buff, size, offset);
-        if (r != ARCHIVE_OK) return r;
+// Helper: Last path separator in `path`, or NULL
+static char* last_separator(char* path) {
+    char* last = NULL;
+    for (char* p = path; *p; p++) {
+        if (*p == PATH_SEP || *p == '/') last = p;
     }
+    return last;
 }
 
-// Helper: Map libarchive error to our error codes
-static int map_archive_error(struct archive* a, rar_error_callback error_cb) {
-    int err = archive_errno(a);
-    const char* err_str = archive_error_string(a);
+// Set of directories known to exist, so that extraction creates each one
+// once instead of once per entry below it
+typedef struct {
+    uint32_t hash;
+    size_t len;
+    char* path;             // NULL for an empty slot
+} dir_cache_slot;
 
-    if (error_cb && err_str) {
-        error_cb(err_str);
+typedef struct {
+    dir_cache_slot* slots;
+    size_t cap;             // Power of two, or 0 before the first insert
+    size_t count;
+    path_arena paths;       // Storage for the slots' paths
+} dir_cache;
+
+static uint32_t path_hash(const char* path, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ (unsigned char)path[i]) * 16777619u;
+    return h;
+}
+
+// Helper: Slot holding the first `len` bytes of `path`, or the empty slot
+// where they would go
+static dir_cache_slot* dir_cache_find(const dir_cache* c, const char* path, size_t len, uint32_t hash) {
+    size_t i = hash & (c->cap - 1);
+    for (;;) {
+        dir_cache_slot* s = &c->slots[i];
+        if (!s->path || (s->hash == hash && s->len == len && memcmp(s->path, path, len) == 0)) return s;
+        i = (i + 1) & (c->cap - 1);
     }
+}
 
-    // Map common errors
-    if (err == ENOENT) return RAR_FILE_NOT_FOUND;
-    if (err == ENOMEM) return RAR_MEMORY_ERROR;
+static int dir_cache_contains(const dir_cache* c, const char* path, size_t len) {
+    return c->count > 0 && dir_cache_find(c, path, len, path_hash(path, len))->path != NULL;
+}
 
-    // Check error string for hints
-    if (err_str) {
-        if (strstr(err_str, "password") || strstr(err_str, "Password") ||
-            strstr(err_str, "encrypted") || strstr(err_str, "Encrypted")) {
-            return RAR_BAD_PASSWORD;
-        }
-        if (strstr(err_str, "corrupt") || strstr(err_str, "Corrupt") ||
-            strstr(err_str, "invalid") || strstr(err_str, "Invalid")) {
-            return RAR_BAD_ARCHIVE;
-        }
-        if (strstr(err_str, "CRC") || strstr(err_str, "checksum")) {
-            return RAR_BAD_DATA;
-        }
-        if (strstr(err_str, "format") || strstr(err_str, "Format")) {
-            return RAR_UNKNOWN_FORMAT;
+// Helper: Remember the first `len` bytes of `path`. The cache is only an
+// optimisation, so running out of memory just leaves the path out.
+static void dir_cache_add(dir_cache* c, const char* path, size_t len) {
+    if ((c->count + 1) * 4 > c->cap * 3) {
+        size_t cap = c->cap ? c->cap * 2 : 64;
+        dir_cache_slot* slots = calloc(cap, sizeof(dir_cache_slot));
+        if (!slots) return;
+        dir_cache old = *c;
+        c->slots = slots;
+        c->cap = cap;
+        for (size_t i = 0; i < old.cap; i++) {
+            if (!old.slots[i].path) continue;
+            size_t j = old.slots[i].hash & (cap - 1);
+            while (slots[j].path) j = (j + 1) & (cap - 1);
+            slots[j] = old.slots[i];
         }
+        free(old.slots);
     }
 
-    return RAR_UNKNOWN_ERROR;
+    uint32_t hash = path_hash(path, len);
+    dir_cache_slot* s = dir_cache_find(c, path, len, hash);
+    if (s->path) return;
+    s->path = arena_strndup(&c->paths, path, len);
+    if (!s->path) return;
+    s->hash = hash;
+    s->len = len;
+    c->count++;
 }
 
-// Extract RAR archive
-RAR_EXPORT int rar_extract(
-    const char* rar_path,
-    const char* dest_path,
-    const char* password,
-    rar_error_callback error_cb
-) {
-    struct archive* a = NULL;
-    struct archive* ext = NULL;
-    struct archive_entry* entry;
-    int r;
-    int result = RAR_SUCCESS;
+static void dir_cache_clear(dir_cache* c) {
+    if (c->count > 0) memset(c->slots, 0, c->cap * sizeof(dir_cache_slot));
+    c->count = 0;
+    arena_reset(&c->paths);
+}
 
-    // Check if file exists
-    FILE* f = fopen(rar_path, "rb");
-    if (!f) {
-        if (error_cb) error_cb("RAR file not found");
-        return RAR_FILE_NOT_FOUND;
-    }
-    fclose(f);
+static void dir_cache_free(dir_cache* c) {
+    free(c->slots);
+    arena_free(&c->paths);
+    memset(c, 0, sizeof(*c));
+}
 
-    // Create destination directory
-    if (create_directory_recursive(dest_path) != 0) {
-        if (error_cb) error_cb("Failed to create destination directory");
-        return RAR_CREATE_ERROR;
+// Helper: create_directory_recursive that skips directories already in
+// `cache` and adds the ones it creates. Only the components below the
+// nearest cached ancestor are created. `path` is modified during the call
+// but restored before it returns.
+static int create_directory_cached(dir_cache* cache, char* path) {
+    size_t len = strlen(path);
+    if (dir_cache_contains(cache, path, len)) return 0;
+
+    size_t start = 0;
+#ifdef _WIN32
+    // Skip drive letter on Windows
+    if (path[0] && path[1] == ':') start = 2;
+#endif
+    // Skip leading separator
+    if (path[start] == PATH_SEP) start++;
+
+    // Find the nearest ancestor known to exist
+    size_t from = start;
+    for (size_t i = len; i-- > start;) {
+        if ((path[i] == PATH_SEP || path[i] == '/') && dir_cache_contains(cache, path, i)) {
+            from = i + 1;
+            break;
+        }
     }
 
-    // Create archive reader
-    a = archive_read_new();
-    if (!a) {
-        if (error_cb) error_cb("Failed to create archive reader");
-        return RAR_MEMORY_ERROR;
+    // Create the rest (ignore errors for existing directories)
+    for (size_t i = from; i < len; i++) {
+        if (path[i] != PATH_SEP && path[i] != '/') continue;
+        char saved = path[i];
+        path[i] = '\0';
+        if (mkdir(path, 0755) == 0 || errno == EEXIST) dir_cache_add(cache, path, i);
+        path[i] = saved;
     }
 
-    // Enable RAR format support
-    archive_read_support_format_rar(a);
-    archive_read_support_format_rar5(a);
+    int result = mkdir(path, 0755);
+    if (result != 0 && errno != EEXIST) return -1;
+    dir_cache_add(cache, path, len);
+    return 0;
+}
 
-    // Enable all filters/compressions
-    archive_read_support_filter_all(a);
+// Destination for decompressed blocks; returns ARCHIVE_OK to continue
+typedef int (*data_sink)(void* ctx, const void* buff, size_t size, int64_t offset);
 
-    // Set password if provided
-    if (password && strlen(password) > 0) {
-        archive_read_add_passphrase(a, password);
-    }
+// Helper: Feed every data block of the current entry into a sink, stopping
+// early if `cancel` is set. `stats` may be NULL.
+static int copy_data_to(struct archive* ar, data_sink sink, void* ctx, const rar_cancel_token_t* cancel, rar_stats* stats) {
+    const void* buff;
+    size_t size;
+    int64_t offset;
+    int r;
 
-    // Create disk writer
-    ext = archive_write_disk_new();
-    if (!ext) {
-        archive_read_free(a);
-        if (error_cb) error_cb("Failed to create disk writer");
-        return RAR_MEMORY_ERROR;
+    for (;;) {
+        if (rar_is_cancelled(cancel)) return fail_cancelled(ar);
+        int64_t start = STATS_CLOCK(stats);
+        r = archive_read_data_block(ar, &buff, &size, &offset);
+        STATS_SINCE(stats, read_ns, start);
+        if (r == ARCHIVE_EOF) return ARCHIVE_OK;
+        if (r != ARCHIVE_OK) return r;
+        STATS_ADD(stats, bytes_decoded, size);
+
+        r = sink(ctx, buff, size, offset);
+        if (r != ARCHIVE_OK) return r;
     }
+}
 
-    // Set extraction options
-    int flags = ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_PERM | ARCHIVE_EXTRACT_ACL | ARCHIVE_EXTRACT_FFLAGS;
-    archive_write_disk_set_options(ext, flags);
-    archive_write_disk_set_standard_lookup(ext);
+// ---------------------------------------------------------------------------
+// Entry filters (rar_options.filter)
+// ---------------------------------------------------------------------------
 
-    // Open archive
-    r = archive_read_open_filename(a, rar_path, BUFFER_SIZE);
-    if (r != ARCHIVE_OK) {
-        result = map_archive_error(a, error_cb);
-        archive_read_free(a);
-        archive_write_free(ext);
-        return result;
-    }
+static int is_path_sep(char c) {
+    return c == '/' || c == PATH_SEP;
+}
 
-    // Extract each entry
-    while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
-        // Build full output path
-        const char* entry_path = archive_entry_pathname(entry);
-        size_t full_path_len = strlen(dest_path) + strlen(entry_path) + 2;
-        char* full_path = malloc(full_path_len);
-        if (!full_path) {
-            result = RAR_MEMORY_ERROR;
-            if (error_cb) error_cb("Memory allocation failed");
-            break;
+// Helper: Match `s` against the bracket expression at `p` (just past the
+// '['). Stores the position after the closing ']' in *end. Returns 1 on a
+// match, 0 on none, -1 if the expression is not closed (the '[' is literal).
+static int glob_class(const char* p, char s, const char** end) {
+    int negate = *p == '!' || *p == '^';
+    int match = 0;
+    if (negate) p++;
+
+    // A ']' right after the '[' is part of the set
+    const char* start = p;
+    while (*p && (*p != ']' || p == start)) {
+        char lo = *p == '\\' && p[1] ? *++p : *p;
+        char hi = lo;
+        if (p[1] == '-' && p[2] && p[2] != ']') {
+            p += 2;
+            hi = *p == '\\' && p[1] ? *++p : *p;
         }
-        snprintf(full_path, full_path_len, "%s%c%s", dest_path, PATH_SEP, entry_path);
+        if ((unsigned char)s >= (unsigned char)lo && (unsigned char)s <= (unsigned char)hi) match = 1;
+        p++;
+    }
+    if (*p != ']') return -1;
+    *end = p + 1;
+    return match != negate;
+}
 
-        // Update entry pathname
-        archive_entry_set_pathname(entry, full_path);
+// Helper: Glob match of a whole path. `*` and `?` stop at separators, `**`
+// crosses them ("**/" also matches no directory at all), `[...]` is a set
+// or range ("[!...]" negated) and `\` quotes the next character.
+static int glob_match(const char* p, const char* s) {
+    for (;;) {
+        switch (*p) {
+        case '\0':
+            return *s == '\0';
 
-        // Create parent directory if needed
-        char* parent = get_parent_directory(full_path);
-        if (parent) {
-            create_directory_recursive(parent);
-            free(parent);
+        case '*': {
+            int deep = p[1] == '*';
+            while (*p == '*') p++;
+            if (deep && *p == '/' && glob_match(p + 1, s)) return 1;
+            for (;;) {
+                if (glob_match(p, s)) return 1;
+                if (!*s || (!deep && is_path_sep(*s))) return 0;
+                s++;
+            }
         }
 
-        // Write header
-        r = archive_write_header(ext, entry);
-        if (r != ARCHIVE_OK) {
-            result = map_archive_error(ext, error_cb);
-            free(full_path);
+        case '?':
+            if (!*s || is_path_sep(*s)) return 0;
+            p++;
+            s++;
             break;
-        }
 
-        // Copy data if it's a regular file
-        if (archive_entry_size(entry) > 0) {
-            r = copy_data(a, ext);
-            if (r != ARCHIVE_OK) {
-                result = map_archive_error(a, error_cb);
-                free(full_path);
+        case '[': {
+            const char* end;
+            int m = *s && !is_path_sep(*s) ? glob_class(p + 1, *s, &end) : 0;
+            if (m == 0) return 0;
+            if (m > 0) {
+                p = end;
+                s++;
                 break;
             }
+            if (*s != '[') return 0;  // Unclosed: a literal '['
+            p++;
+            s++;
+            break;
         }
 
-        // Finish entry
-        r = archive_write_finish_entry(ext);
-        if (r != ARCHIVE_OK) {
-            result = map_archive_error(ext, error_cb);
-            free(full_path);
+        case '\\':
+            if (p[1]) p++;
+            // fall through
+        default:
+            if (*p == '/' ? !is_path_sep(*s) : *p != *s) return 0;
+            p++;
+            s++;
             break;
         }
-
-        free(full_path);
     }
+}
 
-    // Check for read errors
-    if (r != ARCHIVE_EOF && result == RAR_SUCCESS) {
-        result = map_archive_error(a, error_cb);
+// Helper: Patterns without a separator match the last path component,
+// the others the whole path
+static int glob_match_path(const char* pattern, const char* path) {
+    if (!strchr(pattern, '/')) {
+        const char* base = path;
+        for (const char* c = path; *c; c++) {
+            if (is_path_sep(*c)) base = c + 1;
+        }
+        return glob_match(pattern, base);
     }
-
-    // Cleanup
-    archive_read_close(a);
-    archive_read_free(a);
-    archive_write_close(ext);
-    archive_write_free(ext);
-
-    return result;
+    return glob_match(pattern, path);
 }
 
-// List RAR archive contents
-RAR_EXPORT int rar_list(
-    const char* rar_path,
-    const char* password,
-    rar_list_callback list_cb,
-    rar_error_callback error_cb
-) {
-    struct archive* a = NULL;
-    struct archive_entry* entry;
-    int r;
-    int result = RAR_SUCCESS;
+// Helper: 1 if an entry with this path, unpacked size and type passes
+// `filter` (NULL passes everything)
+static int filter_matches(const rar_filter* filter, const char* path, uint64_t size, int is_dir) {
+    if (!filter) return 1;
 
-    // Check if file exists
-    FILE* f = fopen(rar_path, "rb");
-    if (!f) {
-        if (error_cb) error_cb("RAR file not found");
-        return RAR_FILE_NOT_FOUND;
+    // On a component boundary: "photos" covers "photos" and "photos/..."
+    if (filter->prefix && *filter->prefix) {
+        size_t len = strlen(filter->prefix);
+        while (len > 0 && is_path_sep(filter->prefix[len - 1])) len--;
+        for (size_t i = 0; i < len; i++) {
+            char want = filter->prefix[i];
+            if (is_path_sep(want) ? !is_path_sep(path[i]) : path[i] != want) return 0;
+        }
+        if (path[len] && !is_path_sep(path[len])) return 0;
     }
-    fclose(f);
 
-    // Create archive reader
-    a = archive_read_new();
-    if (!a) {
-        if (error_cb) error_cb("Failed to create archive reader");
-        return RAR_MEMORY_ERROR;
+    if (!is_dir) {
+        if (size < filter->min_size) return 0;
+        if (filter->max_size && size > filter->max_size) return 0;
     }
 
-    // Enable RAR format support
-    archive_read_support_format_rar(a);
-    archive_read_support_format_rar5(a);
+    if (filter->include_count > 0) {
+        size_t i = 0;
+        while (i < filter->include_count && !glob_match_path(filter->include[i], path)) i++;
+        if (i == filter->include_count) return 0;
+    }
+    for (size_t i = 0; i < filter->exclude_count; i++) {
+        if (glob_match_path(filter->exclude[i], path)) return 0;
+    }
+    return 1;
+}
 
-    // Enable all filters
-    archive_read_support_filter_all(a);
+// Where extracted entries are written: the libarchive disk writer and, in
+// RAR_WRITE_FAST mode, a file of our own for the current regular file
+typedef struct {
+    struct archive* ext;
+    int fast;               // rar_options.write_mode is RAR_WRITE_FAST
+#ifdef _WIN32
+    HANDLE file;            // Open own file, INVALID_HANDLE_VALUE if none
+#else
+    int fd;                 // Open own file, -1 if none
+#endif
+    int error;              // errno of the first failed write to the own file
+    dir_cache dirs;         // Directories created by the current extraction
+    rar_stats* stats;       // rar_options.stats, NULL if not measured
+    const rar_filter* filter;   // rar_options.filter, NULL to write every entry
+
+    // Output path of the current entry, after a prefix of the destination
+    // and a separator that is built once per extraction
+    char* path;
+    size_t path_cap;
+    size_t prefix_len;
+} disk_output;
+
+static int own_file_is_open(const disk_output* d) {
+#ifdef _WIN32
+    return d->file != INVALID_HANDLE_VALUE;
+#else
+    return d->fd >= 0;
+#endif
+}
+
+// Helper: Write a block to the own file at `offset`
+static int own_file_write(disk_output* d, const void* buff, size_t size, int64_t offset) {
+    const unsigned char* p = (const unsigned char*)buff;
+    while (size > 0) {
+#ifdef _WIN32
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+        DWORD n = 0;
+        OVERLAPPED ov;
+        memset(&ov, 0, sizeof(ov));
+        ov.Offset = (DWORD)((uint64_t)offset & 0xFFFFFFFF);
+        ov.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+        if (!WriteFile(d->file, p, chunk, &n, &ov) || n == 0) {
+            if (!d->error) d->error = EIO;
+            return ARCHIVE_FATAL;
+        }
+#else
+        ssize_t n = pwrite(d->fd, p, size, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (!d->error) d->error = n < 0 ? errno : EIO;
+            return ARCHIVE_FATAL;
+        }
+#endif
+        p += n;
+        size -= (size_t)n;
+        offset += (int64_t)n;
+    }
+    return ARCHIVE_OK;
+}
+
+static int disk_sink(void* ctx, const void* buff, size_t size, int64_t offset) {
+    disk_output* d = (disk_output*)ctx;
+    int64_t start = STATS_CLOCK(d->stats);
+    int r = own_file_is_open(d) ? own_file_write(d, buff, size, offset)
+                                : (int)archive_write_data_block(d->ext, buff, size, offset);
+    STATS_SINCE(d->stats, write_ns, start);
+    if (r == ARCHIVE_OK) STATS_ADD(d->stats, bytes_written, size);
+    return r;
+}
+
+// Sink that merges blocks smaller than its stage into chunks of stage_cap
+// bytes before passing them on. Blocks at least that large go straight
+// through without copying, so does everything when there is no stage.
+typedef struct {
+    data_sink target;
+    void* target_ctx;
+    int (*target_drain)(void* target_ctx);  // Optional: waits for queued writes
+    unsigned char* stage;   // NULL when blocks are passed through as-is
+    size_t stage_len;
+    size_t stage_cap;
+    int64_t stage_offset;
+} coalesce_ctx;
+
+// Helper: Set up a coalescing sink; stage_cap 0 disables staging
+static int coalesce_init(coalesce_ctx* c, data_sink target, void* target_ctx, size_t stage_cap) {
+    memset(c, 0, sizeof(*c));
+    c->target = target;
+    c->target_ctx = target_ctx;
+    if (stage_cap > 0) {
+        c->stage = malloc(stage_cap);
+        if (!c->stage) return -1;
+        c->stage_cap = stage_cap;
+    }
+    return 0;
+}
+
+static void coalesce_free(coalesce_ctx* c) {
+    free(c->stage);
+    c->stage = NULL;
+}
+
+// Helper: Make sure the stage holds at least stage_cap bytes; the sink must
+// be empty. Used when one sink serves several archives.
+static int coalesce_reserve(coalesce_ctx* c, size_t stage_cap) {
+    if (stage_cap <= c->stage_cap) return 0;
+    unsigned char* stage = malloc(stage_cap);
+    if (!stage) return -1;
+    free(c->stage);
+    c->stage = stage;
+    c->stage_cap = stage_cap;
+    return 0;
+}
+
+// Helper: Pass on whatever is staged
+static int coalesce_flush(coalesce_ctx* c) {
+    if (c->stage_len == 0) return ARCHIVE_OK;
+    int r = c->target(c->target_ctx, c->stage, c->stage_len, c->stage_offset);
+    c->stage_offset += (int64_t)c->stage_len;
+    c->stage_len = 0;
+    return r;
+}
+
+static int coalesce_sink(void* ctx, const void* buff, size_t size, int64_t offset) {
+    coalesce_ctx* c = (coalesce_ctx*)ctx;
+    const unsigned char* p = (const unsigned char*)buff;
+    int r;
+
+    if (!c->stage) return c->target(c->target_ctx, buff, size, offset);
+
+    // A gap (sparse block) ends the current chunk
+    if (c->stage_len > 0 && offset != c->stage_offset + (int64_t)c->stage_len) {
+        if ((r = coalesce_flush(c)) != ARCHIVE_OK) return r;
+    }
+
+    while (size > 0) {
+        if (c->stage_len == 0) {
+            c->stage_offset = offset;
+            // Large blocks need no coalescing
+            if (size >= c->stage_cap) return c->target(c->target_ctx, p, size, offset);
+        }
+        size_t n = c->stage_cap - c->stage_len;
+        if (n > size) n = size;
+        memcpy(c->stage + c->stage_len, p, n);
+        c->stage_len += n;
+        p += n;
+        size -= n;
+        offset += (int64_t)n;
+        if (c->stage_len == c->stage_cap && (r = coalesce_flush(c)) != ARCHIVE_OK) return r;
+    }
+    return ARCHIVE_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Write pipeline: a writer thread drains a bounded ring of pooled blocks
+// ---------------------------------------------------------------------------
+
+// Queued block; its data lives in the pool slot with the same index
+typedef struct {
+    size_t len;
+    int64_t offset;
+} pipeline_slot;
+
+// Single-producer/single-consumer ring between the decoding thread and a
+// writer thread. Slot i of the ring owns block i of the pool, so memory is
+// fixed at slot_count * block_size. head and tail only ever grow; the mutex
+// and condition variable are only touched when one side has to sleep.
+typedef struct {
+    data_sink target;           // Runs on the writer thread
+    void* target_ctx;
+    unsigned char* pool;
+    pipeline_slot* slots;
+    size_t slot_count;
+    size_t block_size;
+    int64_t head;               // Next slot to write (atomic, writer)
+    int64_t tail;               // Next slot to fill (atomic, decoder)
+    int64_t failed;             // Set once the target fails (atomic)
+    int64_t stop;               // Asks the writer to exit when empty (atomic)
+    int64_t writer_waiting;     // Atomic
+    int64_t decoder_waiting;    // Atomic
+    size_t fill_len;            // Bytes staged in slot `tail` (decoder only)
+    int64_t fill_offset;
+    rar_mutex_t lock;
+    rar_cond_t cond;
+    rar_thread_t thread;
+} write_pipeline;
+
+static int pipeline_writer_ready(write_pipeline* p) {
+    return rar_atomic_load(&p->head) != rar_atomic_load(&p->tail) || rar_atomic_load(&p->stop);
+}
+
+static int pipeline_slot_free(write_pipeline* p) {
+    return rar_atomic_load(&p->tail) - rar_atomic_load(&p->head) < (int64_t)p->slot_count;
+}
+
+static int pipeline_empty(write_pipeline* p) {
+    return rar_atomic_load(&p->head) == rar_atomic_load(&p->tail);
+}
+
+// Helper: Sleep until `ready` holds. The flag is raised before the final
+// check, so a peer that publishes after that check sees it and wakes us.
+static void pipeline_wait(write_pipeline* p, int64_t* waiting, int (*ready)(write_pipeline*)) {
+    if (ready(p)) return;
+    rar_mutex_lock(&p->lock);
+    rar_atomic_store(waiting, 1);
+    while (!ready(p)) rar_cond_wait(&p->cond, &p->lock);
+    rar_atomic_store(waiting, 0);
+    rar_mutex_unlock(&p->lock);
+}
+
+static void pipeline_wake(write_pipeline* p, int64_t* waiting) {
+    if (!rar_atomic_load(waiting)) return;
+    rar_mutex_lock(&p->lock);
+    rar_cond_broadcast(&p->cond);
+    rar_mutex_unlock(&p->lock);
+}
+
+static RAR_THREAD_RETURN pipeline_writer(void* arg) {
+    write_pipeline* p = (write_pipeline*)arg;
+
+    for (;;) {
+        pipeline_wait(p, &p->writer_waiting, pipeline_writer_ready);
+        int64_t head = rar_atomic_load(&p->head);
+        if (head == rar_atomic_load(&p->tail)) break;  // Stopped and empty
+
+        size_t i = (size_t)(head % (int64_t)p->slot_count);
+        // After a failure blocks are dropped so the decoder never stalls
+        if (!rar_atomic_load(&p->failed) &&
+            p->target(p->target_ctx, p->pool + i * p->block_size, p->slots[i].len,
+                      p->slots[i].offset) != ARCHIVE_OK) {
+            rar_atomic_store(&p->failed, 1);
+        }
+        rar_atomic_store(&p->head, head + 1);
+        pipeline_wake(p, &p->decoder_waiting);
+    }
+    return 0;
+}
+
+// Helper: Start a writer thread feeding `target`, with `slot_count` blocks
+// of `block_size` bytes in flight. Returns 0, or -1 if that is not possible.
+static int pipeline_start(write_pipeline* p, data_sink target, void* target_ctx, size_t slot_count, size_t block_size) {
+    memset(p, 0, sizeof(*p));
+    if (slot_count == 0 || block_size == 0) return -1;
+
+    p->target = target;
+    p->target_ctx = target_ctx;
+    p->slot_count = slot_count;
+    p->block_size = block_size;
+    p->pool = malloc(slot_count * block_size);
+    p->slots = calloc(slot_count, sizeof(pipeline_slot));
+    if (!p->pool || !p->slots) {
+        free(p->pool);
+        free(p->slots);
+        return -1;
+    }
+
+    rar_mutex_init(&p->lock);
+    rar_cond_init(&p->cond);
+    if (rar_thread_create(&p->thread, pipeline_writer, p) != 0) {
+        rar_cond_destroy(&p->cond);
+        rar_mutex_destroy(&p->lock);
+        free(p->pool);
+        free(p->slots);
+        return -1;
+    }
+    return 0;
+}
+
+// Helper: Hand the staged block to the writer
+static void pipeline_publish(write_pipeline* p) {
+    int64_t tail = rar_atomic_load(&p->tail);
+    pipeline_slot* slot = &p->slots[(size_t)(tail % (int64_t)p->slot_count)];
+    slot->len = p->fill_len;
+    slot->offset = p->fill_offset;
+    p->fill_len = 0;
+    rar_atomic_store(&p->tail, tail + 1);
+    pipeline_wake(p, &p->writer_waiting);
+}
+
+// Sink on the decoding thread: copies data into pooled blocks
+static int pipeline_sink(void* ctx, const void* buff, size_t size, int64_t offset) {
+    write_pipeline* p = (write_pipeline*)ctx;
+    const unsigned char* src = (const unsigned char*)buff;
+
+    if (rar_atomic_load(&p->failed)) return ARCHIVE_FATAL;
+
+    // A gap (sparse block) ends the current block
+    if (p->fill_len > 0 && offset != p->fill_offset + (int64_t)p->fill_len) pipeline_publish(p);
+
+    while (size > 0) {
+        if (p->fill_len == 0) {
+            pipeline_wait(p, &p->decoder_waiting, pipeline_slot_free);
+            p->fill_offset = offset;
+        }
+        size_t i = (size_t)(rar_atomic_load(&p->tail) % (int64_t)p->slot_count);
+        size_t n = p->block_size - p->fill_len;
+        if (n > size) n = size;
+        memcpy(p->pool + i * p->block_size + p->fill_len, src, n);
+        p->fill_len += n;
+        src += n;
+        size -= n;
+        offset += (int64_t)n;
+        if (p->fill_len == p->block_size) pipeline_publish(p);
+    }
+    return ARCHIVE_OK;
+}
+
+// Helper: Wait until everything queued has been written. The writer is idle
+// afterwards, so the target may be used directly again.
+static int pipeline_drain(void* ctx) {
+    write_pipeline* p = (write_pipeline*)ctx;
+    if (p->fill_len > 0) pipeline_publish(p);
+    pipeline_wait(p, &p->decoder_waiting, pipeline_empty);
+    return rar_atomic_load(&p->failed) ? ARCHIVE_FATAL : ARCHIVE_OK;
+}
+
+static void pipeline_stop(write_pipeline* p) {
+    pipeline_drain(p);
+    rar_atomic_store(&p->stop, 1);
+    rar_mutex_lock(&p->lock);
+    rar_cond_broadcast(&p->cond);
+    rar_mutex_unlock(&p->lock);
+    rar_thread_join(p->thread);
+    rar_cond_destroy(&p->cond);
+    rar_mutex_destroy(&p->lock);
+    free(p->pool);
+    free(p->slots);
+}
+
+// Output path into a disk writer: a write buffer, or a write pipeline when
+// rar_options.pipeline_blocks asks for one
+typedef struct {
+    coalesce_ctx out;
+    write_pipeline pipe;
+    int piped;
+} write_stage;
+
+// Helper: Set up writes into `disk` in blocks of block_size bytes. Falls back
+// to a plain write buffer if the pipeline cannot be started.
+static int write_stage_init(write_stage* w, disk_output* disk, const rar_options* options, size_t block_size) {
+    w->piped = options->pipeline_blocks > 0 &&
+               pipeline_start(&w->pipe, disk_sink, disk, options->pipeline_blocks, block_size) == 0;
+    if (w->piped) {
+        coalesce_init(&w->out, pipeline_sink, &w->pipe, 0);
+        w->out.target_drain = pipeline_drain;
+        return 0;
+    }
+    return coalesce_init(&w->out, disk_sink, disk, block_size);
+}
+
+static void write_stage_free(write_stage* w) {
+    if (w->piped) pipeline_stop(&w->pipe);
+    coalesce_free(&w->out);
+}
+
+// Counters shared by every reader taking part in one extraction
+typedef struct {
+    rar_progress_callback cb;   // NULL: reporting disabled
+    void* user_data;
+    int64_t interval_ms;
+    int64_t entries_total;      // -1 if unknown
+    int64_t bytes_total;        // -1 if unknown
+    int64_t entries_done;       // Atomic
+    int64_t bytes_in;           // Atomic
+    int64_t bytes_out;          // Atomic
+    int64_t next_report_ms;     // Atomic; earliest time of the next report
+    rar_mutex_t lock;           // Serialises callbacks from worker threads
+} progress_tracker;
+
+static void progress_init(progress_tracker* t, const rar_options* options, int64_t entries_total, int64_t bytes_total) {
+    memset(t, 0, sizeof(*t));
+    t->cb = options->progress_cb;
+    t->user_data = options->progress_user_data;
+    t->interval_ms = options->progress_interval_ms ? options->progress_interval_ms : DEFAULT_PROGRESS_INTERVAL_MS;
+    t->entries_total = entries_total;
+    t->bytes_total = bytes_total;
+    rar_mutex_init(&t->lock);
+}
+
+static void progress_destroy(progress_tracker* t) {
+    rar_mutex_destroy(&t->lock);
+}
+
+// Helper: Invoke the callback if the interval has passed (or `force` is set)
+static void progress_report(progress_tracker* t, int force, int64_t entry_index, const char* entry_name) {
+    if (!t->cb) return;
+
+    int64_t now = rar_monotonic_ms();
+    if (!force && now < rar_atomic_load(&t->next_report_ms)) return;
+
+    rar_mutex_lock(&t->lock);
+    if (force || now >= t->next_report_ms) {
+        rar_atomic_store(&t->next_report_ms, now + t->interval_ms);
+        t->cb(rar_atomic_load(&t->entries_done), t->entries_total,
+              rar_atomic_load(&t->bytes_in), rar_atomic_load(&t->bytes_out), t->bytes_total,
+              entry_index, entry_name, t->user_data);
+    }
+    rar_mutex_unlock(&t->lock);
+}
+
+// Per-reader progress state. Sits in front of the sink that receives an
+// entry's data and counts what passes through.
+typedef struct {
+    progress_tracker* tracker;
+    struct archive* a;
+    int64_t entry_index;
+    const char* entry_name;
+    int64_t last_in;            // Reader position at the last update
+    data_sink next;
+    void* next_ctx;
+} progress_sink_ctx;
+
+static void progress_sink_init(progress_sink_ctx* p, progress_tracker* tracker, struct archive* a) {
+    memset(p, 0, sizeof(*p));
+    p->tracker = tracker;
+    p->a = a;
+}
+
+// Helper: Count packed bytes consumed since the last update
+static void progress_update_in(progress_sink_ctx* p) {
+    int64_t pos = (int64_t)archive_filter_bytes(p->a, 0);
+    if (pos > p->last_in) rar_atomic_fetch_add(&p->tracker->bytes_in, pos - p->last_in);
+    p->last_in = pos;
+}
+
+static void progress_begin_entry(progress_sink_ctx* p, int64_t index, const char* name) {
+    p->entry_index = index;
+    p->entry_name = name;
+    p->last_in = (int64_t)archive_filter_bytes(p->a, 0);
+}
+
+static void progress_end_entry(progress_sink_ctx* p) {
+    progress_update_in(p);
+    rar_atomic_fetch_add(&p->tracker->entries_done, 1);
+    progress_report(p->tracker, 0, p->entry_index, p->entry_name);
+}
+
+static int progress_sink(void* ctx, const void* buff, size_t size, int64_t offset) {
+    progress_sink_ctx* p = (progress_sink_ctx*)ctx;
+    int r = p->next(p->next_ctx, buff, size, offset);
+
+    rar_atomic_fetch_add(&p->tracker->bytes_out, (int64_t)size);
+    progress_update_in(p);
+    progress_report(p->tracker, 0, p->entry_index, p->entry_name);
+    return r;
+}
+
+// Helper: Copy archive data to file through the write buffer `out`
+static int copy_data(
+    struct archive* ar,
+    coalesce_ctx* out,
+    progress_sink_ctx* progress,
+    const rar_cancel_token_t* cancel,
+    rar_stats* stats
+) {
+    int r;
+    if (progress && progress->tracker->cb) {
+        progress->next = coalesce_sink;
+        progress->next_ctx = out;
+        r = copy_data_to(ar, progress_sink, progress, cancel, stats);
+    } else {
+        r = copy_data_to(ar, coalesce_sink, out, cancel, stats);
+    }
+    if (r == ARCHIVE_OK) r = coalesce_flush(out);
+    out->stage_len = 0;
+
+    // Queued writes must finish before the entry is closed, even on failure
+    if (out->target_drain) {
+        int d = out->target_drain(out->target_ctx);
+        if (r == ARCHIVE_OK) r = d;
+    }
+    return r;
+}
+
+// Helper: Map libarchive error to our error codes
+static int map_archive_error(struct archive* a, rar_error_callback error_cb) {
+    int err = archive_errno(a);
+    const char* err_str = archive_error_string(a);
+
+    if (error_cb && err_str) {
+        error_cb(err_str);
+    }
+
+    // Map common errors
+    if (err == ECANCELED) return RAR_CANCELLED;
+    if (err == ENOENT) return RAR_FILE_NOT_FOUND;
+    if (err == ENOMEM) return RAR_MEMORY_ERROR;
+
+    // Check error string for hints
+    if (err_str) {
+        if (strstr(err_str, "password") || strstr(err_str, "Password") ||
+            strstr(err_str, "encrypted") || strstr(err_str, "Encrypted")) {
+            return RAR_BAD_PASSWORD;
+        }
+        if (strstr(err_str, "corrupt") || strstr(err_str, "Corrupt") ||
+            strstr(err_str, "invalid") || strstr(err_str, "Invalid")) {
+            return RAR_BAD_ARCHIVE;
+        }
+        if (strstr(err_str, "CRC") || strstr(err_str, "checksum")) {
+            return RAR_BAD_DATA;
+        }
+        if (strstr(err_str, "format") || strstr(err_str, "Format")) {
+            return RAR_UNKNOWN_FORMAT;
+        }
+    }
+
+    return RAR_UNKNOWN_ERROR;
+}
+
+// Helper: Create an archive reader with RAR/RAR5 formats and all filters enabled
+static struct archive* create_archive_reader(const char* password) {
+    struct archive* a = archive_read_new();
+    if (!a) return NULL;
+
+    // Enable RAR format support
+    archive_read_support_format_rar(a);
+    archive_read_support_format_rar5(a);
+
+    // Enable all filters/compressions
+    archive_read_support_filter_all(a);
 
     // Set password if provided
     if (password && strlen(password) > 0) {
         archive_read_add_passphrase(a, password);
     }
 
-    // Open archive
-    r = archive_read_open_filename(a, rar_path, BUFFER_SIZE);
-    if (r != ARCHIVE_OK) {
-        result = map_archive_error(a, error_cb);
-        archive_read_free(a);
-        return result;
+    return a;
+}
+
+// Helper: Create a disk writer with our standard extraction options. Fast
+// mode restores only times and permissions, which also skips the user and
+// group lookups needed for owners and ACLs.
+static struct archive* create_disk_writer(int fast) {
+    struct archive* ext = archive_write_disk_new();
+    if (!ext) return NULL;
+
+    // Set extraction options
+    int flags = ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_PERM;
+    if (!fast) flags |= ARCHIVE_EXTRACT_ACL | ARCHIVE_EXTRACT_FFLAGS;
+    archive_write_disk_set_options(ext, flags);
+    if (!fast) archive_write_disk_set_standard_lookup(ext);
+
+    return ext;
+}
+
+static int disk_output_init(disk_output* d, const rar_options* options) {
+    memset(d, 0, sizeof(*d));
+    d->fast = options->write_mode == RAR_WRITE_FAST;
+    d->stats = STATS_OF(options);
+    d->filter = options->filter;
+#ifdef _WIN32
+    d->file = INVALID_HANDLE_VALUE;
+#else
+    d->fd = -1;
+#endif
+    d->ext = create_disk_writer(d->fast);
+    return d->ext ? 0 : -1;
+}
+
+// Helper: Grow the path buffer to hold `len` bytes
+static int disk_output_reserve_path(disk_output* d, size_t len) {
+    if (len <= d->path_cap) return 0;
+    size_t cap = d->path_cap ? d->path_cap : 256;
+    while (cap < len) cap *= 2;
+    char* path = realloc(d->path, cap);
+    if (!path) return -1;
+    d->path = path;
+    d->path_cap = cap;
+    return 0;
+}
+
+// Helper: Start an extraction below dest_path, which must already exist.
+// Directories cached by a previous extraction may be gone by now.
+static int disk_output_begin(disk_output* d, const char* dest_path) {
+    size_t dest_len = strlen(dest_path);
+    if (disk_output_reserve_path(d, dest_len + 2) != 0) return -1;
+    memcpy(d->path, dest_path, dest_len);
+    d->path[dest_len] = PATH_SEP;
+    d->path[dest_len + 1] = '\0';
+    d->prefix_len = dest_len + 1;
+
+    dir_cache_clear(&d->dirs);
+    dir_cache_add(&d->dirs, dest_path, dest_len);
+    return 0;
+}
+
+static void disk_output_free(disk_output* d) {
+    dir_cache_free(&d->dirs);
+    free(d->path);
+    d->path = NULL;
+    d->path_cap = 0;
+    if (!d->ext) return;
+    archive_write_close(d->ext);
+    archive_write_free(d->ext);
+    d->ext = NULL;
+}
+
+// Helper: Create `path` as the own file, replacing whatever was there like
+// the disk writer does, and reserve `size` bytes for it. Preallocation is
+// only a hint, so its failure is ignored. Returns 0 or an errno value.
+static int own_file_open(disk_output* d, const char* path, int64_t size) {
+    d->error = 0;
+#ifdef _WIN32
+    wchar_t* wpath = utf8_to_wide(path);
+    if (!wpath) return ENOMEM;
+    d->file = CreateFileW(wpath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    free(wpath);
+    if (d->file == INVALID_HANDLE_VALUE) return EACCES;
+
+    // Allocates without moving end of file, so unwritten space never reads
+    // back as stale disk contents (unlike SetFileValidData)
+    if (size > 0) {
+        FILE_ALLOCATION_INFO alloc;
+        alloc.AllocationSize.QuadPart = size;
+        SetFileInformationByHandle(d->file, FileAllocationInfo, &alloc, sizeof(alloc));
+    }
+#else
+    int fd;
+    int replaced = 0;
+    for (;;) {
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd >= 0) break;
+        if (errno == EINTR) continue;
+        // Never write through an existing file, hard link or symlink
+        if (errno != EEXIST || replaced || unlink(path) != 0) return errno;
+        replaced = 1;
     }
+    d->fd = fd;
 
-    // List each entry
-    while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
-        const char* pathname = archive_entry_pathname(entry);
-        if (pathname && list_cb) {
-            list_cb(pathname);
+    if (size > 0) {
+#if defined(__linux__)
+        // Unlike posix_fallocate, never falls back to writing zeros
+        fallocate(fd, 0, 0, (off_t)size);
+#elif defined(__APPLE__)
+        fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t)size, 0};
+        if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+            store.fst_flags = F_ALLOCATEALL;
+            fcntl(fd, F_PREALLOCATE, &store);
         }
+#endif
+    }
+#endif
+    return 0;
+}
 
-        // Skip data (we only need headers for listing)
-        archive_read_data_skip(a);
+// Helper: Close the own file without touching its metadata
+static void own_file_close(disk_output* d) {
+#ifdef _WIN32
+    CloseHandle(d->file);
+    d->file = INVALID_HANDLE_VALUE;
+#else
+    close(d->fd);
+    d->fd = -1;
+#endif
+}
+
+// Helper: Set the own file's size, times and permissions from `entry` and
+// close it. Returns 0 or an errno value.
+static int own_file_finish(disk_output* d, struct archive_entry* entry) {
+    int64_t size = archive_entry_size(entry);
+    int err = 0;
+#ifdef _WIN32
+    // Trailing holes of sparse entries are never written
+    LARGE_INTEGER end;
+    end.QuadPart = size;
+    if (!SetFilePointerEx(d->file, end, NULL, FILE_BEGIN) || !SetEndOfFile(d->file)) err = EIO;
+
+    // FILETIME counts 100 ns intervals since 1601; zero leaves a field alone
+    FILE_BASIC_INFO info;
+    memset(&info, 0, sizeof(info));
+    if (archive_entry_mtime_is_set(entry)) {
+        info.LastWriteTime.QuadPart = (int64_t)archive_entry_mtime(entry) * 10000000 +
+                                      archive_entry_mtime_nsec(entry) / 100 + 116444736000000000LL;
     }
+    if (archive_entry_atime_is_set(entry)) {
+        info.LastAccessTime.QuadPart = (int64_t)archive_entry_atime(entry) * 10000000 +
+                                       archive_entry_atime_nsec(entry) / 100 + 116444736000000000LL;
+    }
+    if (!(archive_entry_mode(entry) & 0222)) info.FileAttributes = FILE_ATTRIBUTE_READONLY;
+    SetFileInformationByHandle(d->file, FileBasicInfo, &info, sizeof(info));
 
-    // Check for read errors
-    if (r != ARCHIVE_EOF) {
-        result = map_archive_error(a, error_cb);
+    if (!CloseHandle(d->file) && !err) err = EIO;
+    d->file = INVALID_HANDLE_VALUE;
+#else
+    // Trailing holes of sparse entries are never written
+    if (ftruncate(d->fd, (off_t)size) != 0) err = errno;
+
+    // Set-user/group-ID bits are dropped, as the disk writer does when it
+    // does not restore owners
+    fchmod(d->fd, (mode_t)(archive_entry_perm(entry) & 01777));
+
+    struct timespec times[2];
+    times[0].tv_sec = archive_entry_atime(entry);
+    times[0].tv_nsec = archive_entry_atime_is_set(entry) ? archive_entry_atime_nsec(entry) : UTIME_NOW;
+    times[1].tv_sec = archive_entry_mtime(entry);
+    times[1].tv_nsec = archive_entry_mtime_is_set(entry) ? archive_entry_mtime_nsec(entry) : UTIME_OMIT;
+    futimens(d->fd, times);
+
+    if (close(d->fd) != 0 && !err) err = errno;
+    d->fd = -1;
+#endif
+    return err;
+}
+
+// Helper: Write the current entry of `a` below the destination passed to
+// disk_output_begin through `disk`, buffering its data in `out` (a
+// coalescing sink that targets `disk`). `progress` may be NULL; `index` is
+// the entry's position in the archive. A file left incomplete by
+// cancellation is removed.
+static int extract_entry(
+    struct archive* a,
+    disk_output* disk,
+    coalesce_ctx* out,
+    progress_sink_ctx* progress,
+    const rar_cancel_token_t* cancel,
+    int64_t index,
+    struct archive_entry* entry,
+    rar_error_callback error_cb
+) {
+    // Build full output path after the destination prefix
+    const char* entry_path = archive_entry_pathname(entry);
+
+    // Filtered out: skip the data (a seek, outside solid archives) and
+    // create nothing
+    if (disk->filter && !filter_matches(disk->filter, entry_path, (uint64_t)archive_entry_size(entry),
+                                        archive_entry_filetype(entry) == AE_IFDIR)) {
+        if (archive_read_data_skip(a) != ARCHIVE_OK) return map_archive_error(a, error_cb);
+        return RAR_SUCCESS;
     }
 
-    // Cleanup
-    archive_read_close(a);
-    archive_read_free(a);
+    size_t entry_len = strlen(entry_path);
+    if (disk_output_reserve_path(disk, disk->prefix_len + entry_len + 1) != 0) {
+        if (error_cb) error_cb("Memory allocation failed");
+        return RAR_MEMORY_ERROR;
+    }
+    char* full_path = disk->path;
+    memcpy(full_path + disk->prefix_len, entry_path, entry_len + 1);
+
+    // Update entry pathname
+    archive_entry_set_pathname(entry, full_path);
+
+    // The archive path is the tail of full_path, which stays put until the
+    // next entry
+    if (progress) progress_begin_entry(progress, index, full_path + disk->prefix_len);
+
+    // Create parent directory if needed; the destination already exists
+    char* sep = last_separator(full_path + disk->prefix_len);
+    if (sep) {
+        char saved = *sep;
+        *sep = '\0';
+        int64_t start = STATS_CLOCK(disk->stats);
+        create_directory_cached(&disk->dirs, full_path);
+        STATS_SINCE(disk->stats, mkdir_ns, start);
+        *sep = saved;
+    }
+
+    // Fast mode writes regular files itself; everything else goes through
+    // the disk writer
+    int own = disk->fast && archive_entry_filetype(entry) == AE_IFREG && !archive_entry_hardlink(entry);
 
+    // Write header
+    int result = RAR_SUCCESS;
+    int64_t start = STATS_CLOCK(disk->stats);
+    if (own) {
+        if (own_file_open(disk, full_path, archive_entry_size(entry)) != 0) {
+            if (error_cb) error_cb("Failed to create output file");
+            result = RAR_CREATE_ERROR;
+        }
+    } else {
+        int r = archive_write_header(disk->ext, entry);
+        if (r != ARCHIVE_OK) {
+            result = map_archive_error(disk->ext, error_cb);
+        }
+    }
+    STATS_SINCE(disk->stats, create_ns, start);
+
+    // Copy data if it's a regular file
+    if (result == RAR_SUCCESS && archive_entry_size(entry) > 0) {
+        int r = copy_data(a, out, progress, cancel, disk->stats);
+        if (r != ARCHIVE_OK) {
+            if (own && disk->error) {
+                if (error_cb) error_cb("Failed to write output file");
+                result = RAR_CREATE_ERROR;
+            } else {
+                result = map_archive_error(a, error_cb);
+            }
+        }
+        if (result != RAR_SUCCESS && own) {
+            own_file_close(disk);
+            if (result == RAR_CANCELLED) remove(full_path);
+        } else if (result == RAR_CANCELLED) {
+            // Close the partial file before deleting it
+            archive_write_finish_entry(disk->ext);
+            remove(full_path);
+        }
+    }
+
+    // Finish entry
+    if (result == RAR_SUCCESS) {
+        start = STATS_CLOCK(disk->stats);
+        if (own) {
+            if (own_file_finish(disk, entry) != 0) {
+                if (error_cb) error_cb("Failed to write output file");
+                result = RAR_CREATE_ERROR;
+            }
+        } else {
+            int r = archive_write_finish_entry(disk->ext);
+            if (r != ARCHIVE_OK) {
+                result = map_archive_error(disk->ext, error_cb);
+            }
+        }
+        STATS_SINCE(disk->stats, finish_ns, start);
+        if (result == RAR_SUCCESS) STATS_ADD(disk->stats, entries_written, 1);
+    }
+
+    // Files below this directory need not create it again
+    if (result == RAR_SUCCESS && archive_entry_filetype(entry) == AE_IFDIR) {
+        dir_cache_add(&disk->dirs, full_path, strlen(full_path));
+    }
+
+    if (result == RAR_SUCCESS && progress) progress_end_entry(progress);
     return result;
 }
+
+// ---------------------------------------------------------------------------
+// Archive input: memory-mapped files with a positioned-read fallback
+// ---------------------------------------------------------------------------
+
+// Read-only view of an archive file. When the file can be mapped, `map`
+// covers all of it and readers hand libarchive pointers straight into the
+// mapping; otherwise data is fetched with positioned reads.
+typedef struct {
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    const unsigned char* map;   // NULL when the file is not mapped
+    int64_t size;
+    int64_t fs_block;           // Preferred I/O size (st_blksize), 0 if unknown
+} rar_file;
+
+// Helper: Open a file, mapping it unless io_mode is RAR_IO_READ.
+// Returns 0 or an errno value.
+static int rar_file_open(rar_file* rf, const char* path, int io_mode) {
+    memset(rf, 0, sizeof(*rf));
+
+#ifdef _WIN32
+    // Paths are UTF-8; open through the wide API so non-ASCII names work
+    wchar_t* wpath = utf8_to_wide(path);
+    if (!wpath) return ENOMEM;
+    rf->file = CreateFileW(wpath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    free(wpath);
+    if (rf->file == INVALID_HANDLE_VALUE) {
+        DWORD err = GetLastError();
+        return (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) ? ENOENT : EACCES;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(rf->file, &size)) {
+        CloseHandle(rf->file);
+        return EIO;
+    }
+    rf->size = (int64_t)size.QuadPart;
+
+    if (io_mode != RAR_IO_READ && rf->size > 0 && (uint64_t)rf->size <= (uint64_t)SIZE_MAX) {
+        rf->mapping = CreateFileMappingW(rf->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (rf->mapping) {
+            rf->map = (const unsigned char*)MapViewOfFile(rf->mapping, FILE_MAP_READ, 0, 0, 0);
+            if (!rf->map) {
+                CloseHandle(rf->mapping);
+                rf->mapping = NULL;
+            }
+        }
+    }
+#else
+    rf->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (rf->fd < 0) return errno;
+
+    struct stat st;
+    if (fstat(rf->fd, &st) != 0) {
+        int err = errno;
+        close(rf->fd);
+        return err;
+    }
+    rf->size = (int64_t)st.st_size;
+    rf->fs_block = (int64_t)st.st_blksize;
+
+    // Empty files, pipes and files too large for the address space are read instead
+    if (io_mode != RAR_IO_READ && S_ISREG(st.st_mode) && rf->size > 0 && (uint64_t)rf->size <= (uint64_t)SIZE_MAX) {
+        void* map = mmap(NULL, (size_t)rf->size, PROT_READ, MAP_PRIVATE, rf->fd, 0);
+        if (map != MAP_FAILED) rf->map = (const unsigned char*)map;
+    }
+#endif
+
+    return 0;
+}
+
+// Helper: Read up to `len` bytes at `offset`. Returns the byte count, -1 on error.
+static int64_t rar_file_read(const rar_file* rf, int64_t offset, void* buf, size_t len) {
+    if (offset < 0 || offset >= rf->size) return 0;
+    if ((uint64_t)(rf->size - offset) < (uint64_t)len) len = (size_t)(rf->size - offset);
+
+    if (rf->map) {
+        memcpy(buf, rf->map + offset, len);
+        return (int64_t)len;
+    }
+
+#ifdef _WIN32
+    OVERLAPPED ov;
+    DWORD n = 0;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD)((uint64_t)offset & 0xFFFFFFFF);
+    ov.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+    if (len > 0x40000000) len = 0x40000000;
+    if (!ReadFile(rf->file, buf, (DWORD)len, &n, &ov)) {
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+    return (int64_t)n;
+#else
+    ssize_t n;
+    do {
+        n = pread(rf->fd, buf, len, (off_t)offset);
+    } while (n < 0 && errno == EINTR);
+    return n < 0 ? -1 : (int64_t)n;
+#endif
+}
+
+static void rar_file_close(rar_file* rf) {
+#ifdef _WIN32
+    if (rf->map) UnmapViewOfFile(rf->map);
+    if (rf->mapping) CloseHandle(rf->mapping);
+    if (rf->file && rf->file != INVALID_HANDLE_VALUE) CloseHandle(rf->file);
+#else
+    if (rf->map) munmap((void*)rf->map, (size_t)rf->size);
+    if (rf->fd >= 0) close(rf->fd);
+#endif
+    memset(rf, 0, sizeof(*rf));
+}
+
+// Helper: Read a RAR variable-length integer (RAR5 "vint")
+static int read_vint(const unsigned char* p, size_t len, size_t* pos, uint64_t* out) {
+    uint64_t value = 0;
+    for (int shift = 0; *pos < len && shift < 64; shift += 7) {
+        unsigned char b = p[(*pos)++];
+        value |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *out = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// Archive probe: signature and main header, read without libarchive
+// ---------------------------------------------------------------------------
+
+// Bytes of the archive read by a probe. Entry counts are only reported when
+// every header up to the end-of-archive block lies within them.
+#define PROBE_BYTES 8192
+
+static const unsigned char rar4_signature[] = {0x52, 0x61, 0x72, 0x21, 0x1A, 0x07, 0x00};
+static const unsigned char rar5_signature[] = {0x52, 0x61, 0x72, 0x21, 0x1A, 0x07, 0x01, 0x00};
+
+static uint32_t read_le16(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t read_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Helper: Read `len` bytes at `offset`; returns the number of bytes read
+static size_t read_at(const rar_file* f, int64_t offset, unsigned char* buf, size_t len) {
+    int64_t n = rar_file_read(f, offset, buf, len);
+    return n > 0 ? (size_t)n : 0;
+}
+
+// Helper: Count the RAR4 file headers in buf[pos..len), not counting files
+// continued from a previous volume. Returns -1 unless the end-of-archive
+// block is reached.
+static int64_t count_rar4_entries(const unsigned char* buf, size_t len, size_t pos) {
+    int64_t count = 0;
+    while (pos + 7 <= len) {
+        // HEAD_CRC(2) HEAD_TYPE(1) HEAD_FLAGS(2) HEAD_SIZE(2) [ADD_SIZE(4)]
+        const unsigned char* h = buf + pos;
+        unsigned type = h[2];
+        uint32_t flags = read_le16(h + 3);
+        uint64_t size = read_le16(h + 5);
+        if (size < 7) return -1;
+        if (type == 0x7B) return count;
+
+        if ((flags & 0x8000) || type == 0x74) {
+            if (pos + 11 > len) return -1;
+            size += read_le32(h + 7);
+            // HIGH_PACK_SIZE of large files
+            if (type == 0x74 && (flags & 0x0100)) {
+                if (pos + 36 > len) return -1;
+                size += (uint64_t)read_le32(h + 32) << 32;
+            }
+        }
+        if (type == 0x74 && !(flags & 0x0001)) count++;
+        if (size > len) return -1;
+        pos += (size_t)size;
+    }
+    return -1;
+}
+
+// Helper: count_rar4_entries for RAR5 blocks
+static int64_t count_rar5_entries(const unsigned char* buf, size_t len, size_t pos) {
+    int64_t count = 0;
+    while (pos + 5 <= len) {
+        // HEAD_CRC32(4) HEAD_SIZE(vint) HEAD_TYPE HEAD_FLAGS [EXTRA_SIZE] [DATA_SIZE]
+        size_t p = pos + 4;
+        uint64_t head_size, type, flags, extra_size = 0, data_size = 0;
+        if (read_vint(buf, len, &p, &head_size)) return -1;
+        size_t body = p;
+        if (read_vint(buf, len, &p, &type) || read_vint(buf, len, &p, &flags)) return -1;
+        if ((flags & 0x01) && read_vint(buf, len, &p, &extra_size)) return -1;
+        if ((flags & 0x02) && read_vint(buf, len, &p, &data_size)) return -1;
+        if (type == 5) return count;
+
+        if (type == 2 && !(flags & 0x0008)) count++;
+        if (head_size > len || data_size > len) return -1;
+        pos = body + (size_t)head_size + (size_t)data_size;
+    }
+    return -1;
+}
+
+// Helper: Probe an open archive file, see rar_probe
+static int probe_file(const rar_file* f, rar_probe_info* info) {
+    unsigned char buf[PROBE_BYTES];
+
+    memset(info, 0, sizeof(*info));
+    info->volume_index = -1;
+    info->entry_count = -1;
+    info->file_size = f->size;
+
+    size_t len = read_at(f, 0, buf, sizeof(buf));
+
+    if (len >= sizeof(rar5_signature) && memcmp(buf, rar5_signature, sizeof(rar5_signature)) == 0) {
+        info->version = 5;
+
+        // CRC32, header size, header type, header flags, [extra], [data], archive flags
+        size_t p = sizeof(rar5_signature) + 4;
+        uint64_t head_size, type, flags, skip, arc_flags, volume = 0;
+        if (read_vint(buf, len, &p, &head_size)) return RAR_BAD_ARCHIVE;
+        size_t body = p;
+        if (read_vint(buf, len, &p, &type)) return RAR_BAD_ARCHIVE;
+        if (type == 4) {
+            // Encryption header precedes the main header
+            info->flags = RAR_ARCHIVE_ENCRYPTED_HEADERS;
+            return RAR_SUCCESS;
+        }
+        if (type != 1 || read_vint(buf, len, &p, &flags)) return RAR_BAD_ARCHIVE;
+        if ((flags & 0x01) && read_vint(buf, len, &p, &skip)) return RAR_BAD_ARCHIVE;
+        if ((flags & 0x02) && read_vint(buf, len, &p, &skip)) return RAR_BAD_ARCHIVE;
+        if (read_vint(buf, len, &p, &arc_flags)) return RAR_BAD_ARCHIVE;
+        // The first volume carries no volume number
+        if ((arc_flags & 0x0002) && read_vint(buf, len, &p, &volume)) return RAR_BAD_ARCHIVE;
+
+        if (arc_flags & 0x0001) info->flags |= RAR_ARCHIVE_VOLUME;
+        if (arc_flags & 0x0004) info->flags |= RAR_ARCHIVE_SOLID;
+        if (arc_flags & 0x0008) info->flags |= RAR_ARCHIVE_RECOVERY_RECORD;
+        if (arc_flags & 0x0010) info->flags |= RAR_ARCHIVE_LOCKED;
+        info->volume_index = (int64_t)volume;
+        if (head_size <= len) info->entry_count = count_rar5_entries(buf, len, body + (size_t)head_size);
+        return RAR_SUCCESS;
+    }
+
+    if (len >= sizeof(rar4_signature) && memcmp(buf, rar4_signature, sizeof(rar4_signature)) == 0) {
+        info->version = 4;
+
+        // HEAD_CRC(2) HEAD_TYPE(1) HEAD_FLAGS(2) HEAD_SIZE(2) RESERVED(6)
+        size_t pos = sizeof(rar4_signature);
+        if (len < pos + 7) return RAR_BAD_ARCHIVE;
+        const unsigned char* h = buf + pos;
+        uint32_t flags = read_le16(h + 3);
+        uint32_t head_size = read_le16(h + 5);
+        if (h[2] != 0x73 || head_size < 7) return RAR_BAD_ARCHIVE;
+
+        if (flags & 0x0001) info->flags |= RAR_ARCHIVE_VOLUME;
+        if (flags & 0x0004) info->flags |= RAR_ARCHIVE_LOCKED;
+        if (flags & 0x0008) info->flags |= RAR_ARCHIVE_SOLID;
+        if (flags & 0x0040) info->flags |= RAR_ARCHIVE_RECOVERY_RECORD;
+        if (flags & 0x0080) info->flags |= RAR_ARCHIVE_ENCRYPTED_HEADERS;
+
+        // Later volumes only store their number at the end of the volume;
+        // MHD_FIRSTVOLUME is set by RAR 3.0 and newer
+        if (!(flags & 0x0001) || (flags & 0x0100)) info->volume_index = 0;
+        if (!(flags & 0x0080)) info->entry_count = count_rar4_entries(buf, len, pos + head_size);
+        return RAR_SUCCESS;
+    }
+
+    return RAR_UNKNOWN_FORMAT;
+}
+
+// Helper: 1 if a probed archive is solid, 0 if not, -1 if unknown (not a
+// RAR file, or RAR5 headers that are encrypted, main header included)
+static int probe_solid(int probe_result, const rar_probe_info* info) {
+    if (probe_result != RAR_SUCCESS) return -1;
+    if (info->version == 5 && (info->flags & RAR_ARCHIVE_ENCRYPTED_HEADERS)) return -1;
+    return (info->flags & RAR_ARCHIVE_SOLID) ? 1 : 0;
+}
+
+RAR_EXPORT int rar_probe(const char* rar_path, rar_probe_info* info) {
+    rar_file file;
+    if (!info) return RAR_UNKNOWN_ERROR;
+    memset(info, 0, sizeof(*info));
+    info->volume_index = -1;
+    info->entry_count = -1;
+    if (!rar_path) return RAR_FILE_NOT_FOUND;
+
+    // Reads are small and few, so mapping the file would not pay off
+    int err = rar_file_open(&file, rar_path, RAR_IO_READ);
+    if (err != 0) return err == ENOMEM ? RAR_MEMORY_ERROR : RAR_FILE_NOT_FOUND;
+
+    int result = probe_file(&file, info);
+    rar_file_close(&file);
+    return result;
+}
+
+// Raw fields parsed from a file header block
+typedef struct {
+    int64_t header_offset;
+    int64_t data_offset;
+    uint64_t packed_size;
+    uint32_t crc32;
+    uint32_t flags;   // RAR_ENTRY_SOLID/STORED/SPLIT_*/HAS_CRC
+} raw_file_header;
+
+// Helper: Walk blocks from `pos` until the next file header and parse it.
+// Returns 0 on success, -1 if no file header could be parsed.
+static int parse_file_header(const rar_file* f, int version, int64_t pos, raw_file_header* out) {
+    unsigned char buf[256];
+
+    memset(out, 0, sizeof(*out));
+
+    // Skip the signature when scanning from the start of the archive
+    if (pos == 0) pos = version == 5 ? sizeof(rar5_signature) : sizeof(rar4_signature);
+
+    for (;;) {
+        size_t len = read_at(f, pos, buf, sizeof(buf));
+
+        if (version == 4) {
+            // HEAD_CRC(2) HEAD_TYPE(1) HEAD_FLAGS(2) HEAD_SIZE(2) [ADD_SIZE(4)]
+            if (len < 7) return -1;
+            unsigned type = buf[2];
+            uint32_t flags = read_le16(buf + 3);
+            uint32_t head_size = read_le16(buf + 5);
+            if (head_size < 7) return -1;
+
+            if (type == 0x7B) return -1;  // End of archive
+            if (type != 0x74) {
+                uint64_t add_size = 0;
+                if (flags & 0x8000) {
+                    if (len < 11) return -1;
+                    add_size = read_le32(buf + 7);
+                }
+                pos += head_size + add_size;
+                continue;
+            }
+
+            // PACK_SIZE(4) UNP_SIZE(4) HOST_OS(1) FILE_CRC(4) FTIME(4)
+            // UNP_VER(1) METHOD(1) NAME_SIZE(2) ATTR(4) [HIGH_PACK(4) HIGH_UNP(4)]
+            if (len < 32) return -1;
+            out->header_offset = pos;
+            out->data_offset = pos + head_size;
+            out->packed_size = read_le32(buf + 7);
+            if ((flags & 0x0100) && len >= 40) {
+                out->packed_size |= (uint64_t)read_le32(buf + 32) << 32;
+            }
+            out->crc32 = read_le32(buf + 16);
+            out->flags = RAR_ENTRY_HAS_CRC;
+            if (buf[25] == 0x30) out->flags |= RAR_ENTRY_STORED;
+            if (flags & 0x0010) out->flags |= RAR_ENTRY_SOLID;
+            if (flags & 0x0001) out->flags |= RAR_ENTRY_SPLIT_BEFORE;
+            if (flags & 0x0002) out->flags |= RAR_ENTRY_SPLIT_AFTER;
+            return 0;
+        }
+
+        // RAR5: HEAD_CRC32(4) HEAD_SIZE(vint) then HEAD_SIZE bytes of header
+        size_t p = 4;
+        uint64_t head_size, type, head_flags, extra_size = 0, data_size = 0;
+        if (len < 5 || read_vint(buf, len, &p, &head_size)) return -1;
+        int64_t data_offset = pos + (int64_t)p + (int64_t)head_size;
+        if (read_vint(buf, len, &p, &type) || read_vint(buf, len, &p, &head_flags)) return -1;
+        if ((head_flags & 0x01) && read_vint(buf, len, &p, &extra_size)) return -1;
+        if ((head_flags & 0x02) && read_vint(buf, len, &p, &data_size)) return -1;
+
+        if (type == 5) return -1;  // End of archive
+        if (type != 2) {
+            pos = data_offset + (int64_t)data_size;
+            continue;
+        }
+
+        // FILE_FLAGS UNP_SIZE ATTRIBUTES [MTIME(4)] [DATA_CRC32(4)] COMP_INFO
+        uint64_t file_flags, unp_size, attributes, comp_info;
+        if (read_vint(buf, len, &p, &file_flags) ||
+            read_vint(buf, len, &p, &unp_size) ||
+            read_vint(buf, len, &p, &attributes)) return -1;
+        if (file_flags & 0x0002) p += 4;
+        out->flags = 0;
+        if (file_flags & 0x0004) {
+            if (p + 4 > len) return -1;
+            out->crc32 = read_le32(buf + p);
+            out->flags |= RAR_ENTRY_HAS_CRC;
+            p += 4;
+        }
+        if (read_vint(buf, len, &p, &comp_info)) return -1;
+
+        out->header_offset = pos;
+        out->data_offset = data_offset;
+        out->packed_size = data_size;
+        if (((comp_info >> 7) & 0x07) == 0) out->flags |= RAR_ENTRY_STORED;
+        if (comp_info & 0x0040) out->flags |= RAR_ENTRY_SOLID;
+        if (head_flags & 0x0008) out->flags |= RAR_ENTRY_SPLIT_BEFORE;
+        if (head_flags & 0x0010) out->flags |= RAR_ENTRY_SPLIT_AFTER;
+        return 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Multi-volume archives
+// ---------------------------------------------------------------------------
+
+// The volumes of an archive are read as one stream, the concatenation of
+// every volume in order, which is what libarchive's RAR readers expect when
+// an entry continues in the next volume. Offsets into that stream are "set
+// offsets"; for an archive that is a single file they are file offsets.
+typedef struct {
+    char* path;
+    int64_t begin;          // Set offset of the volume's first byte
+    int64_t size;
+} rar_volume;
+
+typedef struct {
+    rar_volume* items;
+    size_t count;
+    size_t capacity;
+    int64_t size;           // Sum of the volume sizes
+} volume_set;
+
+// Volume naming schemes
+#define VOLUME_NAMES_PART 0     // name.part1.rar, name.part2.rar, ...
+#define VOLUME_NAMES_OLD  1     // name.rar, name.r00 .. name.r99, name.s00, ...
+
+// How the volumes of a set are named, derived from the name of one of them
+typedef struct {
+    const char* path;
+    int scheme;
+    size_t stem_len;        // Leading bytes of `path` shared by every name
+    int digits;             // Width of the part number (VOLUME_NAMES_PART)
+    size_t suffix;          // Offset of the text after the part number
+    int upper;              // Upper case extension (VOLUME_NAMES_OLD)
+    int64_t index;          // Index of `path` in the set, from 0
+} volume_naming;
+
+// Helper: Compare `n` bytes of `s` with lower case ASCII `lower`, ignoring case
+static int ascii_iequal(const char* s, const char* lower, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        char c = s[i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != lower[i]) return 0;
+    }
+    return 1;
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Helper: Read the volume name `path` in `scheme`. Returns 0 if it does not fit.
+static int volume_naming_parse(volume_naming* n, const char* path, int scheme) {
+    size_t len = strlen(path);
+
+    memset(n, 0, sizeof(*n));
+    n->path = path;
+    n->scheme = scheme;
+    if (len < 4) return 0;
+
+    if (scheme == VOLUME_NAMES_PART) {
+        // ".part" DIGITS ".rar"
+        size_t end = len - 4;
+        size_t start = end;
+        if (!ascii_iequal(path + end, ".rar", 4)) return 0;
+        while (start > 0 && end - start < 9 && is_digit(path[start - 1])) start--;
+        if (start == end || start < 5 || !ascii_iequal(path + start - 5, ".part", 5)) return 0;
+
+        int64_t number = 0;
+        for (size_t i = start; i < end; i++) number = number * 10 + (path[i] - '0');
+        if (number < 1) return 0;
+        n->stem_len = start;
+        n->digits = (int)(end - start);
+        n->suffix = end;
+        n->index = number - 1;
+        return 1;
+    }
+
+    // ".rar" for the first volume, then ".r00" .. ".r99", ".s00" .. ".z99"
+    const char* ext = path + len - 3;
+    if (path[len - 4] != '.') return 0;
+    if (ascii_iequal(ext, "rar", 3)) {
+        n->index = 0;
+    } else {
+        char letter = ext[0] >= 'A' && ext[0] <= 'Z' ? (char)(ext[0] - 'A' + 'a') : ext[0];
+        if (letter < 'r' || letter > 'z' || !is_digit(ext[1]) || !is_digit(ext[2])) return 0;
+        n->index = 1 + (letter - 'r') * 100 + (ext[1] - '0') * 10 + (ext[2] - '0');
+    }
+    n->stem_len = len - 3;
+    n->upper = ext[0] >= 'A' && ext[0] <= 'Z';
+    return 1;
+}
+
+// Helper: Write the name of volume `index` to `out`, which has room for
+// stem_len + 32 bytes. Returns 0 if the scheme has no volume `index`.
+static int volume_naming_format(const volume_naming* n, int64_t index, char* out) {
+    char* p = out + n->stem_len;
+
+    memcpy(out, n->path, n->stem_len);
+    if (n->scheme == VOLUME_NAMES_PART) {
+        if (index + 1 > 999999999) return 0;
+        // The ".rar" suffix keeps the case it has in `path`
+        snprintf(p, 32, "%0*lld%s", n->digits, (long long)(index + 1), n->path + n->suffix);
+        return 1;
+    }
+
+    if (index == 0) {
+        snprintf(p, 32, "%s", n->upper ? "RAR" : "rar");
+    } else {
+        if (index > 900) return 0;
+        char letter = (char)((n->upper ? 'R' : 'r') + (index - 1) / 100);
+        snprintf(p, 32, "%c%02d", letter, (int)((index - 1) % 100));
+    }
+    return 1;
+}
+
+// Helper: Size of the regular file at `path`. Returns 0, or -1 if there is none.
+static int regular_file_size(const char* path, int64_t* size) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    wchar_t* wpath = utf8_to_wide(path);
+    if (!wpath) return -1;
+    BOOL ok = GetFileAttributesExW(wpath, GetFileExInfoStandard, &data);
+    free(wpath);
+    if (!ok || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) return -1;
+    *size = ((int64_t)data.nFileSizeHigh << 32) | (int64_t)data.nFileSizeLow;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return -1;
+    *size = (int64_t)st.st_size;
+#endif
+    return 0;
+}
+
+static void volume_set_free(volume_set* set) {
+    for (size_t i = 0; i < set->count; i++) free(set->items[i].path);
+    free(set->items);
+    memset(set, 0, sizeof(*set));
+}
+
+// Helper: Append a copy of `path` as the next volume. Returns 0 or ENOMEM.
+static int volume_set_add(volume_set* set, const char* path, int64_t size) {
+    if (set->count == set->capacity) {
+        size_t cap = set->capacity ? set->capacity * 2 : 4;
+        rar_volume* items = realloc(set->items, cap * sizeof(rar_volume));
+        if (!items) return ENOMEM;
+        set->items = items;
+        set->capacity = cap;
+    }
+    char* copy = strdup(path);
+    if (!copy) return ENOMEM;
+
+    rar_volume* v = &set->items[set->count++];
+    v->path = copy;
+    v->begin = set->size;
+    v->size = size;
+    set->size += size;
+    return 0;
+}
+
+// Helper: Collect the volumes of the set `path` (a volume of `path_size`
+// bytes) belongs to, from the first one up to the first missing name. Falls
+// back to `path` alone unless every volume before it is present. Stores the
+// index of `path` in *path_index. Returns 0 or ENOMEM.
+static int volume_set_discover(volume_set* set, const char* path, int64_t path_size, size_t* path_index) {
+    volume_naming naming;
+
+    memset(set, 0, sizeof(*set));
+    *path_index = 0;
+
+    for (int scheme = VOLUME_NAMES_PART; scheme <= VOLUME_NAMES_OLD; scheme++) {
+        if (!volume_naming_parse(&naming, path, scheme)) continue;
+
+        char* name = malloc(naming.stem_len + 32);
+        if (!name) return ENOMEM;
+        for (int64_t i = 0; volume_naming_format(&naming, i, name); i++) {
+            int64_t size = path_size;
+            const char* volume = i == naming.index ? path : name;
+            if (i != naming.index && regular_file_size(name, &size) != 0) {
+                // Not every tool pads part numbers: name.part9.rar, name.part10.rar
+                if (scheme != VOLUME_NAMES_PART || naming.digits == 1) break;
+                int digits = naming.digits;
+                naming.digits = 1;
+                volume_naming_format(&naming, i, name);
+                naming.digits = digits;
+                if (regular_file_size(name, &size) != 0) break;
+            }
+            if (volume_set_add(set, volume, size) != 0) {
+                free(name);
+                volume_set_free(set);
+                return ENOMEM;
+            }
+        }
+        free(name);
+
+        // A set of one is no better than `path` alone; try the other scheme
+        if (set->count > (size_t)naming.index && set->count > 1) {
+            *path_index = (size_t)naming.index;
+            return 0;
+        }
+        volume_set_free(set);
+    }
+
+    return volume_set_add(set, path, path_size);
+}
+
+// Helper: Index of the volume holding set offset `offset`
+static size_t volume_find(const volume_set* set, int64_t offset) {
+    size_t lo = 0;
+    size_t hi = set->count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (set->items[mid].begin <= offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Reads a volume set with at most one volume open at a time. Volumes are
+// opened when a read first reaches them, so skipping over a volume never
+// opens it.
+typedef struct {
+    const volume_set* set;
+    size_t current;         // Index of the open volume, set->count if none
+    rar_file file;
+    int io_mode;
+} volume_cursor;
+
+static void volume_cursor_init(volume_cursor* c, const volume_set* set, int io_mode) {
+    memset(c, 0, sizeof(*c));
+    c->set = set;
+    c->current = set->count;
+    c->io_mode = io_mode;
+}
+
+static void volume_cursor_close(volume_cursor* c) {
+    if (c->set && c->current < c->set->count) rar_file_close(&c->file);
+    if (c->set) c->current = c->set->count;
+}
+
+// Helper: Make volume `index` the open one. Returns 0 or an errno value.
+static int volume_cursor_select(volume_cursor* c, size_t index) {
+    if (index == c->current) return 0;
+    volume_cursor_close(c);
+    int err = rar_file_open(&c->file, c->set->items[index].path, c->io_mode);
+    if (err == 0) c->current = index;
+    return err;
+}
+
+// Helper: Open `path` and, if it is part of a multi-volume archive, find the
+// other volumes. On success `c` reads `set` with `path` open. Returns 0 or an
+// errno value.
+static int volume_set_open(volume_set* set, volume_cursor* c, const char* path, int io_mode) {
+    rar_probe_info info;
+    rar_file file;
+    size_t index = 0;
+    int err;
+
+    memset(set, 0, sizeof(*set));
+    volume_cursor_init(c, set, io_mode);
+
+    err = rar_file_open(&file, path, io_mode);
+    if (err != 0) return err;
+
+    if (probe_file(&file, &info) == RAR_SUCCESS && (info.flags & RAR_ARCHIVE_VOLUME)) {
+        err = volume_set_discover(set, path, file.size, &index);
+    } else {
+        err = volume_set_add(set, path, file.size);
+    }
+    if (err != 0) {
+        rar_file_close(&file);
+        volume_set_free(set);
+        volume_cursor_init(c, set, io_mode);
+        return err;
+    }
+
+    volume_cursor_init(c, set, io_mode);
+    c->file = file;
+    c->current = index;
+    return 0;
+}
+
+static void volume_set_close(volume_set* set, volume_cursor* c) {
+    volume_cursor_close(c);
+    volume_set_free(set);
+}
+
+// Helper: Size of what precedes the first file header of volume `index`:
+// its signature, main header and any service headers. Returns -1 if unknown.
+static int64_t volume_head_len(volume_cursor* c, size_t index) {
+    rar_probe_info info;
+    raw_file_header raw;
+
+    if (volume_cursor_select(c, index) != 0) return -1;
+    if (probe_file(&c->file, &info) != RAR_SUCCESS) return -1;
+    if (parse_file_header(&c->file, info.version, 0, &raw) != 0) return -1;
+    return raw.header_offset;
+}
+
+// Helper: Find the entries whose first header lies in volume `index`: the
+// set offset of the first one (-1 if none) and how many there are. Returns 0,
+// or -1 if the volume cannot be opened.
+static int scan_volume(const volume_set* set, size_t index, int version, int64_t* first, int64_t* count) {
+    rar_file file;
+    raw_file_header raw;
+    int64_t pos = 0;
+
+    *first = -1;
+    *count = 0;
+    if (rar_file_open(&file, set->items[index].path, RAR_IO_READ) != 0) return -1;
+
+    // Files continued from the previous volume belong to that volume
+    while (parse_file_header(&file, version, pos, &raw) == 0) {
+        if (!(raw.flags & RAR_ENTRY_SPLIT_BEFORE)) {
+            if (*first < 0) *first = set->items[index].begin + raw.header_offset;
+            (*count)++;
+        }
+        pos = raw.data_offset + (int64_t)raw.packed_size;
+    }
+
+    rar_file_close(&file);
+    return 0;
+}
+
+// Helper: parse_file_header on a volume set, with `pos` and the offsets
+// found in set offsets. When the volume holding `pos` has no further file
+// header, the search goes on in the next volumes, past the headers of files
+// continued from an earlier volume.
+static int parse_set_header(volume_cursor* c, int version, int64_t pos, raw_file_header* out) {
+    const volume_set* set = c->set;
+
+    for (size_t v = volume_find(set, pos); v < set->count; v++) {
+        const rar_volume* volume = &set->items[v];
+        int64_t file_pos = pos > volume->begin ? pos - volume->begin : 0;
+        int later = pos < volume->begin;
+
+        if (volume_cursor_select(c, v) != 0) return -1;
+        while (parse_file_header(&c->file, version, file_pos, out) == 0) {
+            if (!later || !(out->flags & RAR_ENTRY_SPLIT_BEFORE)) {
+                out->header_offset += volume->begin;
+                out->data_offset += volume->begin;
+                return 0;
+            }
+            file_pos = out->data_offset + (int64_t)out->packed_size;
+        }
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// Archive input: the libarchive client
+// ---------------------------------------------------------------------------
+
+// libarchive client over a volume set. The stream libarchive sees is the
+// `head_len` bytes at `head_at` followed by everything from `splice_at` on;
+// head_len == splice_at == 0 is simply the whole set.
+typedef struct {
+    volume_set owned;       // The set, unless it belongs to the caller
+    volume_cursor cursor;
+    int64_t head_at;
+    int64_t head_len;
+    int64_t splice_at;
+    int64_t pos;            // Logical position seen by libarchive
+    unsigned char* buf;     // Read buffer, allocated for the first unmapped volume
+    size_t block_size;      // Size of buf
+    size_t ramp;            // Current read size; restarts small after a skip
+} archive_source;
+
+static la_ssize_t source_read(struct archive* a, void* client_data, const void** buff) {
+    archive_source* src = (archive_source*)client_data;
+    const volume_set* set = src->cursor.set;
+    int64_t offset;
+    int64_t avail;
+
+    if (src->pos < src->head_len) {
+        offset = src->head_at + src->pos;
+        avail = src->head_len - src->pos;
+    } else {
+        offset = src->splice_at + (src->pos - src->head_len);
+        avail = set->size - offset;
+    }
+    if (avail <= 0) return 0;
+
+    // A read never crosses into the next volume
+    size_t v = src->cursor.current;
+    if (v >= set->count || offset < set->items[v].begin ||
+        offset - set->items[v].begin >= set->items[v].size) {
+        v = volume_find(set, offset);
+    }
+    const rar_volume* volume = &set->items[v];
+    int err = volume_cursor_select(&src->cursor, v);
+    if (err != 0) {
+        archive_set_error(a, err == ENOMEM ? ENOMEM : EIO, "Cannot open volume %s", volume->path);
+        return -1;
+    }
+    const rar_file* file = &src->cursor.file;
+    int64_t file_offset = offset - volume->begin;
+    if (avail > volume->size - file_offset) avail = volume->size - file_offset;
+
+    if (file->map) {
+        // Hand out the rest of the current segment without copying
+        if (avail > file->size - file_offset) avail = file->size - file_offset;
+        if (avail <= 0) return 0;
+        if ((uint64_t)avail > (uint64_t)(SIZE_MAX >> 1)) avail = (int64_t)(SIZE_MAX >> 1);
+        *buff = file->map + file_offset;
+        src->pos += avail;
+        return (la_ssize_t)avail;
+    }
+
+    if (!src->buf) {
+        src->buf = malloc(src->block_size);
+        if (!src->buf) {
+            archive_set_error(a, ENOMEM, "Memory allocation failed");
+            return -1;
+        }
+    }
+
+    // Reads grow back to block_size after a skip, so that fetching the next
+    // header does not pull in a full block of data that will be skipped too
+    size_t want = src->ramp < src->block_size ? src->ramp : src->block_size;
+    if ((uint64_t)avail < want) want = (size_t)avail;
+    if (src->ramp < src->block_size) src->ramp *= 2;
+
+    int64_t n = rar_file_read(file, file_offset, src->buf, want);
+    if (n < 0) {
+        archive_set_error(a, EIO, "Read error");
+        return -1;
+    }
+    src->pos += n;
+    *buff = src->buf;
+    return (la_ssize_t)n;
+}
+
+// Length of the logical stream described by an archive_source
+static int64_t source_length(const archive_source* src) {
+    int64_t tail = src->cursor.set->size - src->splice_at;
+    return src->head_len + (tail > 0 ? tail : 0);
+}
+
+// Skipping only moves the logical position; nothing is read or touched
+static la_int64_t source_skip(struct archive* a, void* client_data, la_int64_t request) {
+    (void)a;
+    archive_source* src = (archive_source*)client_data;
+    int64_t remaining = source_length(src) - src->pos;
+    if (request > remaining) request = remaining;
+    if (request < 0) request = 0;
+    src->pos += request;
+    src->ramp = AUTO_BLOCK_MIN;
+    return request;
+}
+
+static la_int64_t source_seek(struct archive* a, void* client_data, la_int64_t offset, int whence) {
+    archive_source* src = (archive_source*)client_data;
+    int64_t base;
+
+    switch (whence) {
+    case SEEK_SET: base = 0; break;
+    case SEEK_CUR: base = src->pos; break;
+    case SEEK_END: base = source_length(src); break;
+    default: base = -1; break;
+    }
+    if (base < 0 || base + offset < 0) {
+        archive_set_error(a, EINVAL, "Invalid seek");
+        return ARCHIVE_FATAL;
+    }
+    src->pos = base + offset;
+    src->ramp = AUTO_BLOCK_MIN;
+    return src->pos;
+}
+
+static int source_close(struct archive* a, void* client_data) {
+    (void)a;
+    archive_source* src = (archive_source*)client_data;
+    volume_set_close(&src->owned, &src->cursor);
+    free(src->buf);
+    free(src);
+    return ARCHIVE_OK;
+}
+
+// Helper: Install `src` as the client of reader `a` and open it
+static int open_source(
+    struct archive* a,
+    archive_source* src,
+    int64_t head_len,
+    int64_t splice_at,
+    int64_t file_size,
+    int64_t fs_block,
+    const rar_options* options
+) {
+    src->block_size = options->read_block_size > 0
+        ? options->read_block_size
+        : auto_block_size(file_size, fs_block);
+    src->ramp = AUTO_BLOCK_MIN;
+    src->head_len = head_len;
+    src->splice_at = splice_at;
+
+    // A stream spliced into a later volume starts with that volume's own
+    // signature and main header, as RAR5 checks that volume numbers follow on
+    const volume_set* set = src->cursor.set;
+    size_t v = volume_find(set, splice_at);
+    if (head_len > 0 && v > 0) {
+        int64_t len = volume_head_len(&src->cursor, v);
+        if (len > 0 && set->items[v].begin + len <= splice_at) {
+            src->head_at = set->items[v].begin;
+            src->head_len = len;
+        }
+    }
+
+    // Positions are tracked here and every read is positioned, so skips and
+    // seeks never read through entry data or move a shared file offset
+    archive_read_set_read_callback(a, source_read);
+    archive_read_set_skip_callback(a, source_skip);
+    archive_read_set_seek_callback(a, source_seek);
+    archive_read_set_close_callback(a, source_close);
+    archive_read_set_callback_data(a, src);
+    return archive_read_open1(a);
+}
+
+// Helper: Open reader `a` on the archive at `path` and any further volumes
+// (see archive_source for the splice parameters, given in set offsets).
+// libarchive owns the source once this returns.
+static int open_archive_source(
+    struct archive* a,
+    const char* path,
+    int64_t head_len,
+    int64_t splice_at,
+    const rar_options* options
+) {
+    archive_source* src = calloc(1, sizeof(archive_source));
+    if (!src) {
+        archive_set_error(a, ENOMEM, "Memory allocation failed");
+        return ARCHIVE_FATAL;
+    }
+
+    // Any file that cannot be opened maps to RAR_FILE_NOT_FOUND
+    int err = volume_set_open(&src->owned, &src->cursor, path, options->io_mode);
+    if (err != 0) {
+        free(src);
+        archive_set_error(a, err == ENOMEM ? ENOMEM : ENOENT, "RAR file not found");
+        return ARCHIVE_FATAL;
+    }
+
+    const rar_file* file = &src->cursor.file;
+    return open_source(a, src, head_len, splice_at, file->size, file->fs_block, options);
+}
+
+// Helper: open_archive_source on a volume set owned by the caller, which
+// must outlive the reader. No volume is opened before it is read.
+static int open_set_source(
+    struct archive* a,
+    const volume_set* set,
+    int64_t head_len,
+    int64_t splice_at,
+    const rar_options* options
+) {
+    archive_source* src = calloc(1, sizeof(archive_source));
+    if (!src) {
+        archive_set_error(a, ENOMEM, "Memory allocation failed");
+        return ARCHIVE_FATAL;
+    }
+    volume_cursor_init(&src->cursor, set, options->io_mode);
+    return open_source(a, src, head_len, splice_at, set->items[0].size, 0, options);
+}
+
+// Helper: Open reader `a` on a whole archive
+static int open_archive_file(struct archive* a, const char* path, const rar_options* options) {
+    return open_archive_source(a, path, 0, 0, options);
+}
+
+// Extract RAR archive
+RAR_EXPORT int rar_extract(
+    const char* rar_path,
+    const char* dest_path,
+    const char* password,
+    rar_error_callback error_cb
+) {
+    return rar_extract_ex(rar_path, dest_path, password, NULL, error_cb);
+}
+
+// Helper: Extract every entry of rar_path in order through an existing disk
+// writer `ext` and its write buffer `out`
+static int extract_with_writer(
+    const char* rar_path,
+    const char* dest_path,
+    const char* password,
+    const rar_options* options,
+    progress_tracker* tracker,
+    disk_output* disk,
+    coalesce_ctx* out,
+    rar_error_callback error_cb
+) {
+    struct archive* a = NULL;
+    struct archive_entry* entry;
+    progress_sink_ctx progress;
+    int r;
+    int result = RAR_SUCCESS;
+
+    // Create archive reader
+    a = create_archive_reader(password);
+    if (!a) {
+        if (error_cb) error_cb("Failed to create archive reader");
+        return RAR_MEMORY_ERROR;
+    }
+
+    // Open archive; a missing file fails here, before anything is created
+    r = open_archive_file(a, rar_path, options);
+    if (r != ARCHIVE_OK) {
+        result = map_archive_error(a, error_cb);
+        archive_read_free(a);
+        return result;
+    }
+
+    // Create destination directory
+    if (create_directory_recursive(dest_path) != 0) {
+        if (error_cb) error_cb("Failed to create destination directory");
+        archive_read_free(a);
+        return RAR_CREATE_ERROR;
+    }
+    if (disk_output_begin(disk, dest_path) != 0) {
+        if (error_cb) error_cb("Memory allocation failed");
+        archive_read_free(a);
+        return RAR_MEMORY_ERROR;
+    }
+
+    // Extract each entry
+    progress_sink_init(&progress, tracker, a);
+    for (int64_t index = 0; (r = read_next_header(a, &entry, options)) == ARCHIVE_OK; index++) {
+        result = extract_entry(a, disk, out, &progress, options->cancel_token, index, entry, error_cb);
+        if (result != RAR_SUCCESS) break;
+    }
+
+    // Check for read errors
+    if (r != ARCHIVE_EOF && result == RAR_SUCCESS) {
+        result = map_archive_error(a, error_cb);
+    }
+
+    // Cleanup
+    archive_read_close(a);
+    archive_read_free(a);
+
+    return result;
+}
+
+// Helper: Sequential extraction shared by rar_extract_ex and the fallbacks
+// of parallel extraction
+static int extract_sequential(
+    const char* rar_path,
+    const char* dest_path,
+    const char* password,
+    const rar_options* options,
+    progress_tracker* tracker,
+    rar_error_callback error_cb
+) {
+    write_stage stage;
+    disk_output disk;
+
+    // Create disk writer
+    if (disk_output_init(&disk, options) != 0) {
+        if (error_cb) error_cb("Failed to create disk writer");
+        return RAR_MEMORY_ERROR;
+    }
+
+    // Write buffer or pipeline
+    if (write_stage_init(&stage, &disk, options, resolve_write_buffer_size(options, rar_path, dest_path)) != 0) {
+        disk_output_free(&disk);
+        if (error_cb) error_cb("Memory allocation failed");
+        return RAR_MEMORY_ERROR;
+    }
+
+    int result = extract_with_writer(rar_path, dest_path, password, options, tracker, &disk, &stage.out, error_cb);
+
+    write_stage_free(&stage);
+    disk_output_free(&disk);
+
+    return result;
+}
+
+// Extract RAR archive with explicit options
+RAR_EXPORT int rar_extract_ex(
+    const char* rar_path,
+    const char* dest_path,
+    const char* password,
+    const rar_options* options,
+    rar_error_callback error_cb
+) {
+    progress_tracker tracker;
+    options = options_or_default(options);
+    progress_init(&tracker, options, -1, -1);
+
+    int result = extract_sequential(rar_path, dest_path, password, options, &tracker, error_cb);
+
+    progress_report(&tracker, 1, -1, NULL);
+    progress_destroy(&tracker);
+    return result;
+}
+
+// Shared state for one parallel extraction
+typedef struct {
+    const char* rar_path;
+    const char* dest_path;
+    const char* password;
+    const rar_options* options;
+    size_t write_buffer_size;
+    progress_tracker* tracker;
+    int64_t next_entry;   // Next unclaimed entry index (atomic)
+    int64_t failed;       // Set once any worker fails (atomic)
+    const volume_set* volumes;  // Volumes handed out whole, NULL for entries
+    int version;          // RAR version of `volumes`
+    int64_t next_volume;  // Next unclaimed volume (atomic)
+    int result;           // First error code, guarded by lock
+    char error_message[256];  // Its message, guarded by lock
+    rar_mutex_t lock;
+} parallel_extract_ctx;
+
+// Helper: The RAR_* code and message of a worker failure. With a reader the
+// code comes from its error, otherwise `code` is used.
+static int worker_error(struct archive* a, int code, const char** message) {
+    *message = NULL;
+    if (a) {
+        code = map_archive_error(a, NULL);
+        *message = archive_error_string(a);
+    }
+    if (!*message) *message = rar_get_error_message(code);
+    return code;
+}
+
+// Helper: Record a worker failure; only the first error is kept. Its message
+// goes to error_cb on the calling thread once the workers have joined.
+static void parallel_fail(parallel_extract_ctx* ctx, struct archive* a, int code) {
+    const char* message;
+    code = worker_error(a, code, &message);
+    rar_mutex_lock(&ctx->lock);
+    if (ctx->result == RAR_SUCCESS) {
+        ctx->result = code;
+        snprintf(ctx->error_message, sizeof(ctx->error_message), "%s", message ? message : "");
+    }
+    rar_mutex_unlock(&ctx->lock);
+    rar_atomic_store(&ctx->failed, 1);
+}
+
+// Worker: scan headers with a private reader, claiming entries as it reaches
+// them. Claims come from a shared counter, so a worker that finishes early
+// simply takes the next entry nobody has started yet.
+static RAR_THREAD_RETURN parallel_extract_worker(void* arg) {
+    parallel_extract_ctx* ctx = (parallel_extract_ctx*)arg;
+    struct archive_entry* entry;
+    coalesce_ctx out;
+    disk_output disk;
+    progress_sink_ctx progress;
+    int r;
+
+    struct archive* a = create_archive_reader(ctx->password);
+    int disk_ok = disk_output_init(&disk, ctx->options) == 0 &&
+                  disk_output_begin(&disk, ctx->dest_path) == 0;
+    if (!a || !disk_ok || coalesce_init(&out, disk_sink, &disk, ctx->write_buffer_size) != 0) {
+        parallel_fail(ctx, NULL, RAR_MEMORY_ERROR);
+        if (a) archive_read_free(a);
+        disk_output_free(&disk);
+        return 0;
+    }
+
+    r = open_archive_file(a, ctx->rar_path, ctx->options);
+    if (r != ARCHIVE_OK) {
+        parallel_fail(ctx, a, RAR_OPEN_ERROR);
+        archive_read_free(a);
+        disk_output_free(&disk);
+        coalesce_free(&out);
+        return 0;
+    }
+
+    int64_t index = 0;
+    int64_t claimed = rar_atomic_fetch_add(&ctx->next_entry, 1);
+    progress_sink_init(&progress, ctx->tracker, a);
+
+    while (!rar_atomic_load(&ctx->failed) &&
+           (r = read_next_header(a, &entry, ctx->options)) == ARCHIVE_OK) {
+        if (index == claimed) {
+            // Errors are reported through parallel_fail, not error_cb
+            int code = extract_entry(a, &disk, &out, &progress, ctx->options->cancel_token,
+                                     index, entry, NULL);
+            if (code != RAR_SUCCESS) {
+                parallel_fail(ctx, NULL, code);
+                break;
+            }
+            claimed = rar_atomic_fetch_add(&ctx->next_entry, 1);
+        } else {
+            archive_read_data_skip(a);
+        }
+        index++;
+    }
+
+    if (r != ARCHIVE_EOF && r != ARCHIVE_OK) {
+        parallel_fail(ctx, a, RAR_UNKNOWN_ERROR);
+    }
+
+    archive_read_close(a);
+    archive_read_free(a);
+    disk_output_free(&disk);
+    coalesce_free(&out);
+    return 0;
+}
+
+// Worker for multi-volume archives: claim whole volumes and extract the
+// entries whose first header lies in them. The reader is spliced to start at
+// the claimed volume's first such entry, so earlier volumes are never opened;
+// an entry that continues into the next volume is read on from there.
+static RAR_THREAD_RETURN parallel_volume_worker(void* arg) {
+    parallel_extract_ctx* ctx = (parallel_extract_ctx*)arg;
+    const volume_set* set = ctx->volumes;
+    struct archive_entry* entry;
+    coalesce_ctx out;
+    disk_output disk;
+    progress_sink_ctx progress;
+
+    int disk_ok = disk_output_init(&disk, ctx->options) == 0 &&
+                  disk_output_begin(&disk, ctx->dest_path) == 0;
+    if (!disk_ok || coalesce_init(&out, disk_sink, &disk, ctx->write_buffer_size) != 0) {
+        parallel_fail(ctx, NULL, RAR_MEMORY_ERROR);
+        disk_output_free(&disk);
+        return 0;
+    }
+
+    while (!rar_atomic_load(&ctx->failed)) {
+        int64_t volume = rar_atomic_fetch_add(&ctx->next_volume, 1);
+        int64_t first, count;
+        if (volume >= (int64_t)set->count) break;
+
+        if (scan_volume(set, (size_t)volume, ctx->version, &first, &count) != 0) {
+            parallel_fail(ctx, NULL, RAR_OPEN_ERROR);
+            break;
+        }
+        if (count == 0) continue;
+
+        struct archive* a = create_archive_reader(ctx->password);
+        if (!a) {
+            parallel_fail(ctx, NULL, RAR_MEMORY_ERROR);
+            break;
+        }
+        if (open_set_source(a, set, first, first, ctx->options) != ARCHIVE_OK) {
+            parallel_fail(ctx, a, RAR_OPEN_ERROR);
+            archive_read_free(a);
+            break;
+        }
+
+        progress_sink_init(&progress, ctx->tracker, a);
+        for (int64_t i = 0; i < count && !rar_atomic_load(&ctx->failed); i++) {
+            int r = read_next_header(a, &entry, ctx->options);
+            if (r != ARCHIVE_OK) {
+                // Running out of entries early means the volume is damaged
+                parallel_fail(ctx, r == ARCHIVE_EOF ? NULL : a, RAR_BAD_ARCHIVE);
+                break;
+            }
+
+            // Entries are numbered in the order they are started
+            int64_t index = rar_atomic_fetch_add(&ctx->next_entry, 1);
+            int code = extract_entry(a, &disk, &out, &progress, ctx->options->cancel_token,
+                                     index, entry, NULL);
+            if (code != RAR_SUCCESS) {
+                parallel_fail(ctx, NULL, code);
+                break;
+            }
+        }
+
+        archive_read_close(a);
+        archive_read_free(a);
+    }
+
+    disk_output_free(&disk);
+    coalesce_free(&out);
+    return 0;
+}
+
+// Helper: Parallel extraction shared by rar_extract_parallel and handles
+static int extract_parallel(
+    const char* rar_path,
+    const char* dest_path,
+    const char* password,
+    int num_threads,
+    const rar_options* options,
+    progress_tracker* tracker,
+    rar_error_callback error_cb
+) {
+    if (num_threads <= 0) num_threads = rar_cpu_count();
+    if (num_threads > MAX_EXTRACT_THREADS) num_threads = MAX_EXTRACT_THREADS;
+
+    // Solid archives must be decompressed in order; unknown layouts too
+    rar_probe_info probe;
+    int probed = rar_probe(rar_path, &probe);
+    if (num_threads == 1 || probe_solid(probed, &probe) != 0) {
+        return extract_sequential(rar_path, dest_path, password, options, tracker, error_cb);
+    }
+
+    if (create_directory_recursive(dest_path) != 0) {
+        if (error_cb) error_cb("Failed to create destination directory");
+        return RAR_CREATE_ERROR;
+    }
+
+    parallel_extract_ctx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.rar_path = rar_path;
+    ctx.dest_path = dest_path;
+    ctx.password = password;
+    ctx.options = options;
+    ctx.write_buffer_size = resolve_write_buffer_size(options, rar_path, dest_path);
+    ctx.tracker = tracker;
+    ctx.result = RAR_SUCCESS;
+
+    // Volumes whose headers can be read are handed out whole, so a worker
+    // only opens the volumes holding its entries
+    volume_set set;
+    volume_cursor cursor;
+    memset(&set, 0, sizeof(set));
+    if ((probe.flags & RAR_ARCHIVE_VOLUME) && !(probe.flags & RAR_ARCHIVE_ENCRYPTED_HEADERS) &&
+        volume_set_open(&set, &cursor, rar_path, RAR_IO_READ) == 0) {
+        volume_cursor_close(&cursor);
+        if (set.count > 1) {
+            ctx.volumes = &set;
+            ctx.version = probe.version;
+            if ((size_t)num_threads > set.count) num_threads = (int)set.count;
+        }
+    }
+    rar_thread_fn worker = ctx.volumes ? parallel_volume_worker : parallel_extract_worker;
+    rar_mutex_init(&ctx.lock);
+
+    rar_thread_t threads[MAX_EXTRACT_THREADS];
+    int started = 0;
+    for (; started < num_threads; started++) {
+        if (rar_thread_create(&threads[started], worker, &ctx) != 0) break;
+    }
+
+    if (started == 0) {
+        rar_mutex_destroy(&ctx.lock);
+        volume_set_free(&set);
+        return extract_sequential(rar_path, dest_path, password, options, tracker, error_cb);
+    }
+
+    for (int i = 0; i < started; i++) {
+        rar_thread_join(threads[i]);
+    }
+
+    rar_mutex_destroy(&ctx.lock);
+    volume_set_free(&set);
+    if (ctx.result != RAR_SUCCESS && error_cb && ctx.error_message[0]) error_cb(ctx.error_message);
+    return ctx.result;
+}
+
+// Extract RAR archive using several independent readers
+RAR_EXPORT int rar_extract_parallel(
+    const char* rar_path,
+    const char* dest_path,
+    const char* password,
+    int num_threads,
+    rar_error_callback error_cb
+) {
+    progress_tracker tracker;
+    progress_init(&tracker, &default_options, -1, -1);
+
+    int result = extract_parallel(rar_path, dest_path, password, num_threads, &default_options, &tracker, error_cb);
+
+    progress_destroy(&tracker);
+    return result;
+}
+
+// List RAR archive contents
+RAR_EXPORT int rar_list(
+    const char* rar_path,
+    const char* password,
+    rar_list_callback list_cb,
+    rar_error_callback error_cb
+) {
+    return rar_list_ex(rar_path, password, NULL, list_cb, error_cb);
+}
+
+// Receives entry names while listing
+typedef void (*name_visitor)(void* ctx, const char* name);
+
+// Helper: Read every header of rar_path and pass its name to `visit`
+static int list_archive(
+    const char* rar_path,
+    const char* password,
+    const rar_options* options,
+    name_visitor visit,
+    void* visit_ctx,
+    rar_error_callback error_cb
+) {
+    struct archive* a = NULL;
+    struct archive_entry* entry;
+    int r;
+    int result = RAR_SUCCESS;
+
+    // With a cache, list through a handle so the index is saved and reused
+    if (options->index_cache) {
+        rar_archive_t* h;
+        result = rar_open_ex(rar_path, password, options, &h, error_cb);
+        if (result != RAR_SUCCESS) return result;
+        int64_t count = rar_entry_count(h);
+        for (int64_t i = 0; i < count && result == RAR_SUCCESS; i++) {
+            // Names come from the index, so this is the only place to stop
+            if (rar_is_cancelled(options->cancel_token)) {
+                if (error_cb) error_cb("Operation cancelled");
+                result = RAR_CANCELLED;
+                break;
+            }
+            rar_entry_info info;
+            result = rar_stat(h, i, &info);
+            if (result == RAR_SUCCESS && *info.name) visit(visit_ctx, info.name);
+        }
+        rar_close(h);
+        return result;
+    }
+
+    // Create archive reader
+    a = create_archive_reader(password);
+    if (!a) {
+        if (error_cb) error_cb("Failed to create archive reader");
+        return RAR_MEMORY_ERROR;
+    }
+
+    // Open archive
+    r = open_archive_file(a, rar_path, options);
+    if (r != ARCHIVE_OK) {
+        result = map_archive_error(a, error_cb);
+        archive_read_free(a);
+        return result;
+    }
+
+    // List each entry
+    while ((r = read_next_header(a, &entry, options)) == ARCHIVE_OK) {
+        const char* pathname = archive_entry_pathname(entry);
+        if (pathname) {
+            visit(visit_ctx, pathname);
+        }
+
+        // Skip data (we only need headers for listing)
+        archive_read_data_skip(a);
+    }
+
+    // Check for read errors
+    if (r != ARCHIVE_EOF) {
+        result = map_archive_error(a, error_cb);
+    }
+
+    // Cleanup
+    archive_read_close(a);
+    archive_read_free(a);
+
+    return result;
+}
+
+// Adapter from name_visitor to the public rar_list_callback
+typedef struct {
+    rar_list_callback cb;
+} list_callback_ctx;
+
+static void list_callback_visit(void* ctx, const char* name) {
+    list_callback_ctx* c = (list_callback_ctx*)ctx;
+    if (c->cb) c->cb(name);
+}
+
+// List RAR archive contents with explicit options
+RAR_EXPORT int rar_list_ex(
+    const char* rar_path,
+    const char* password,
+    const rar_options* options,
+    rar_list_callback list_cb,
+    rar_error_callback error_cb
+) {
+    list_callback_ctx ctx = {list_cb};
+    return list_archive(rar_path, password, options_or_default(options), list_callback_visit, &ctx, error_cb);
+}
+
+// ---------------------------------------------------------------------------
+// Batch jobs
+// ---------------------------------------------------------------------------
+
+// Shared state for one rar_batch_submit call
+typedef struct {
+    const rar_job* jobs;
+    rar_job_result* results;
+    size_t count;
+    rar_options options;    // Copied so asynchronous batches outlive the caller's
+    rar_batch_callback done_cb;
+    void* user_data;
+    int64_t next_job;       // Next unclaimed job (atomic)
+    int64_t running;        // Participants still working, asynchronous batches (atomic)
+} batch_ctx;
+
+// Packed names collected by a list job
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+    int64_t count;
+    int failed;             // Set when an allocation failed
+} name_list;
+
+static void name_list_visit(void* ctx, const char* name) {
+    name_list* l = (name_list*)ctx;
+    size_t n = strlen(name) + 1;
+    if (l->failed) return;
+
+    if (l->len + n > l->capacity) {
+        size_t cap = l->capacity ? l->capacity : 4096;
+        while (cap < l->len + n) cap *= 2;
+        char* data = realloc(l->data, cap);
+        if (!data) {
+            l->failed = 1;
+            return;
+        }
+        l->data = data;
+        l->capacity = cap;
+    }
+    memcpy(l->data + l->len, name, n);
+    l->len += n;
+    l->count++;
+}
+
+// Per-thread state reused across the jobs a worker runs
+typedef struct {
+    disk_output disk;       // Writer created on the first extract job
+    coalesce_ctx out;       // Write buffer targeting `disk`, grown as needed
+} batch_worker_state;
+
+static int run_list_job(const batch_ctx* ctx, const rar_job* job, rar_job_result* res) {
+    name_list names;
+    memset(&names, 0, sizeof(names));
+
+    int result = list_archive(job->rar_path, job->password, &ctx->options, name_list_visit, &names, NULL);
+    if (result == RAR_SUCCESS && names.failed) result = RAR_MEMORY_ERROR;
+    if (result != RAR_SUCCESS) {
+        free(names.data);
+        return result;
+    }
+
+    res->names = names.data;
+    res->names_len = names.len;
+    res->entry_count = names.count;
+    return RAR_SUCCESS;
+}
+
+static int run_extract_job(
+    const batch_ctx* ctx,
+    batch_worker_state* w,
+    const rar_job* job,
+    rar_job_result* res
+) {
+    if (!job->dest_path) return RAR_UNKNOWN_ERROR;
+
+    if (!w->disk.ext) {
+        if (disk_output_init(&w->disk, &ctx->options) != 0) return RAR_MEMORY_ERROR;
+        w->out.target = disk_sink;
+        w->out.target_ctx = &w->disk;
+    }
+    if (coalesce_reserve(&w->out, resolve_write_buffer_size(&ctx->options, job->rar_path, job->dest_path)) != 0) {
+        return RAR_MEMORY_ERROR;
+    }
+
+    progress_tracker tracker;
+    progress_init(&tracker, &ctx->options, -1, -1);
+    int result = extract_with_writer(job->rar_path, job->dest_path, job->password, &ctx->options,
+                                     &tracker, &w->disk, &w->out, NULL);
+    res->entry_count = rar_atomic_load(&tracker.entries_done);
+    progress_destroy(&tracker);
+
+    // A failed write can leave the writer unusable; start the next job fresh
+    if (result != RAR_SUCCESS) disk_output_free(&w->disk);
+    return result;
+}
+
+// Helper: Claim and run jobs until none are left
+static void batch_run_jobs(batch_ctx* ctx) {
+    batch_worker_state w;
+    memset(&w, 0, sizeof(w));
+
+    for (;;) {
+        int64_t i = rar_atomic_fetch_add(&ctx->next_job, 1);
+        if (i >= (int64_t)ctx->count) break;
+
+        const rar_job* job = &ctx->jobs[i];
+        rar_job_result* res = &ctx->results[i];
+        memset(res, 0, sizeof(*res));
+
+        if (rar_is_cancelled(ctx->options.cancel_token)) {
+            res->code = RAR_CANCELLED;
+        } else if (!job->rar_path) {
+            res->code = RAR_FILE_NOT_FOUND;
+        } else if (job->type == RAR_JOB_LIST) {
+            res->code = run_list_job(ctx, job, res);
+        } else if (job->type == RAR_JOB_EXTRACT) {
+            res->code = run_extract_job(ctx, &w, job, res);
+        } else {
+            res->code = RAR_UNKNOWN_ERROR;
+        }
+    }
+
+    disk_output_free(&w.disk);
+    coalesce_free(&w.out);
+}
+
+// Helper: Report an asynchronous batch and release it
+static void batch_finish(batch_ctx* ctx) {
+    size_t failed = 0;
+    for (size_t i = 0; i < ctx->count; i++) {
+        if (ctx->results[i].code != RAR_SUCCESS) failed++;
+    }
+    ctx->done_cb(ctx->count, failed, ctx->user_data);
+    free(ctx);
+}
+
+// Helper: Drop one participant of an asynchronous batch; the last one out
+// reports completion
+static void batch_leave(batch_ctx* ctx) {
+    if (rar_atomic_fetch_add(&ctx->running, -1) == 1) batch_finish(ctx);
+}
+
+static RAR_THREAD_RETURN batch_worker(void* arg) {
+    batch_ctx* ctx = (batch_ctx*)arg;
+    batch_run_jobs(ctx);
+    if (ctx->done_cb) batch_leave(ctx);
+    return 0;
+}
+
+// Run list/extract jobs on a thread pool
+RAR_EXPORT int rar_batch_submit(
+    const rar_job* jobs,
+    size_t count,
+    int num_threads,
+    const rar_options* options,
+    rar_job_result* results,
+    rar_batch_callback done_cb,
+    void* user_data
+) {
+    if ((!jobs || !results) && count > 0) return RAR_UNKNOWN_ERROR;
+
+    batch_ctx* ctx = calloc(1, sizeof(batch_ctx));
+    if (!ctx) return RAR_MEMORY_ERROR;
+    ctx->jobs = jobs;
+    ctx->results = results;
+    ctx->count = count;
+    ctx->options = *options_or_default(options);
+    ctx->options.progress_cb = NULL;
+    ctx->done_cb = done_cb;
+    ctx->user_data = user_data;
+
+    if (num_threads <= 0) num_threads = rar_cpu_count();
+    if (num_threads > MAX_EXTRACT_THREADS) num_threads = MAX_EXTRACT_THREADS;
+    if ((size_t)num_threads > count) num_threads = count > 0 ? (int)count : 1;
+
+    // The submitting thread counts as a participant until every worker is
+    // started, so the batch cannot finish (and be freed) underneath it
+    ctx->running = 1;
+
+    rar_thread_t threads[MAX_EXTRACT_THREADS];
+    int started = 0;
+    for (; started < num_threads; started++) {
+        if (done_cb) rar_atomic_fetch_add(&ctx->running, 1);
+        if (rar_thread_create(&threads[started], batch_worker, ctx) != 0) {
+            if (done_cb) rar_atomic_fetch_add(&ctx->running, -1);
+            break;
+        }
+        if (done_cb) rar_thread_detach(threads[started]);
+    }
+
+    // Without threads the jobs run here
+    if (started == 0) batch_run_jobs(ctx);
+
+    if (done_cb) {
+        batch_leave(ctx);
+        return RAR_SUCCESS;
+    }
+
+    for (int i = 0; i < started; i++) {
+        rar_thread_join(threads[i]);
+    }
+    free(ctx);
+    return RAR_SUCCESS;
+}
+
+RAR_EXPORT void rar_batch_results_free(rar_job_result* results, size_t count) {
+    if (!results) return;
+    for (size_t i = 0; i < count; i++) {
+        free(results[i].names);
+        results[i].names = NULL;
+        results[i].names_len = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Archive handle with a cached entry index
+// ---------------------------------------------------------------------------
+
+// One entry of the in-memory index
+typedef struct {
+    size_t name_offset;     // Offset of the name in the handle's name arena
+    uint64_t size;
+    uint64_t packed_size;
+    int64_t mtime;
+    int64_t header_offset;
+    int64_t data_offset;
+    uint32_t crc32;
+    uint32_t mode;
+    uint32_t flags;
+} index_entry;
+
+// Decoders parked on a handle by rar_read_at and the entry cache
+#define READ_CURSOR_COUNT 4
+
+// A decoder left inside an entry after a rar_read_at, so a later read at or
+// past `from` resumes from there instead of decompressing from the start.
+// With `between` set it is a solid checkpoint instead: the data of entry
+// `index` has been read and the next header has not.
+typedef struct {
+    struct archive* a;          // NULL when the slot is empty
+    int64_t index;
+    const void* block;          // Last block returned, NULL once consumed
+    int64_t block_off;
+    size_t block_len;
+    int64_t from;               // First entry offset the decoder can still serve
+    int between;
+    uint64_t used;              // Last-use tick, the least recent is evicted
+} read_cursor;
+
+// One decompressed entry held by the entry cache
+typedef struct entry_cache_item {
+    int64_t index;
+    unsigned char* data;        // Exactly the entry's size
+    size_t len;
+    struct entry_cache_item* prev;  // Towards the most recently used
+    struct entry_cache_item* next;
+} entry_cache_item;
+
+struct rar_archive {
+    char* path;
+    char* password;
+    rar_options options;
+    int version;            // 4 or 5, 0 if the signature was not recognised
+    int solid;              // 1 solid, 0 non-solid, -1 unknown
+
+    index_entry* entries;
+    size_t count;
+    size_t capacity;
+
+    char* names;            // Packed NUL-terminated names
+    size_t names_len;
+    size_t names_cap;
+
+    int64_t* buckets;       // Open-addressed name -> index table (-1 = empty)
+    size_t bucket_count;    // Power of two
+
+    // rar_read_at state, created on first use and guarded by read_lock
+    rar_mutex_t read_lock;
+    volume_set volumes;     // Empty until the first stored read
+    rar_file* read_files;   // One per volume, opened on first use
+    unsigned char* read_open;
+    read_cursor cursors[READ_CURSOR_COUNT];
+    uint64_t read_tick;
+
+    // Entry cache (rar_options.entry_cache_bytes), also guarded by read_lock
+    entry_cache_item** cached;  // Per entry, NULL if not cached; allocated on first use
+    entry_cache_item* lru_first;    // Most recently used
+    entry_cache_item* lru_last;
+    uint64_t cache_bytes;
+    int64_t cache_hits;
+    int64_t cache_misses;
+
+    // Prefetch thread (rar_options.prefetch_entries), also guarded by read_lock
+    rar_cond_t prefetch_cond;   // Wakes the thread, and readers waiting on it
+    rar_thread_t prefetch_thread;
+    int prefetch_running;
+    int prefetch_stop;
+    int64_t prefetch_next;      // Entry after the last one read, -1 before any read
+    int64_t prefetch_busy;      // Entry being decompressed ahead, -1 if none
+    int64_t prefetch_failed;    // Last entry the thread could not decompress
+    int64_t last_read_ns;       // When the last entry read started
+    int64_t read_interval_ns;   // Average time between sequential reads, 0 if unknown
+    int64_t decode_ns;          // Average time the thread takes per entry, 0 if unknown
+};
+
+// Helper: FNV-1a hash of a NUL-terminated string
+static uint64_t hash_string(const char* s) {
+    uint64_t h = 14695981039346656037ULL;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Helper: Append one entry (and its name) to the index
+static int index_append(rar_archive_t* h, const char* name, const index_entry* e) {
+    if (h->count == h->capacity) {
+        size_t cap = h->capacity ? h->capacity * 2 : 64;
+        index_entry* entries = realloc(h->entries, cap * sizeof(index_entry));
+        if (!entries) return -1;
+        h->entries = entries;
+        h->capacity = cap;
+    }
+
+    size_t name_len = strlen(name) + 1;
+    if (h->names_len + name_len > h->names_cap) {
+        size_t cap = h->names_cap ? h->names_cap : 4096;
+        while (h->names_len + name_len > cap) cap *= 2;
+        char* names = realloc(h->names, cap);
+        if (!names) return -1;
+        h->names = names;
+        h->names_cap = cap;
+    }
+
+    h->entries[h->count] = *e;
+    h->entries[h->count].name_offset = h->names_len;
+    memcpy(h->names + h->names_len, name, name_len);
+    h->names_len += name_len;
+    h->count++;
+    return 0;
+}
+
+// Helper: Build the name lookup table once all entries are known
+static int index_build_lookup(rar_archive_t* h) {
+    size_t n = 16;
+    while (n < h->count * 2) n *= 2;
+
+    h->buckets = malloc(n * sizeof(int64_t));
+    if (!h->buckets) return -1;
+    for (size_t i = 0; i < n; i++) h->buckets[i] = -1;
+    h->bucket_count = n;
+
+    for (size_t i = 0; i < h->count; i++) {
+        size_t slot = (size_t)hash_string(h->names + h->entries[i].name_offset) & (n - 1);
+        while (h->buckets[slot] != -1) slot = (slot + 1) & (n - 1);
+        h->buckets[slot] = (int64_t)i;
+    }
+    return 0;
+}
+
+// Helper: Duplicate an optional string
+static char* dup_optional(const char* s) {
+    return (s && *s) ? strdup(s) : NULL;
+}
+
+// Helper: Open a reader that starts directly at entry `index`, if possible.
+// libarchive sees a short archive whose first entry is the one we want, which
+// is only valid for non-solid archives.
+static struct archive* open_spliced_reader(const rar_archive_t* h, int64_t index, const rar_options* options) {
+    const index_entry* first = &h->entries[0];
+    const index_entry* target = &h->entries[index];
+
+    if (h->solid != 0 || first->header_offset <= 0 ||
+        target->header_offset <= first->header_offset ||
+        (target->flags & RAR_ENTRY_SPLIT_BEFORE)) {
+        return NULL;
+    }
+
+    struct archive* a = create_archive_reader(h->password);
+    if (!a) return NULL;
+
+    // Serve the signature and main header, then continue at the target entry
+    if (open_archive_source(a, h->path, first->header_offset, target->header_offset,
+                            options) != ARCHIVE_OK) {
+        archive_read_free(a);
+        return NULL;
+    }
+    return a;
+}
+
+// Helper: Return a reader positioned at the data of entry `index`.
+// Jumps directly to the header on non-solid archives and falls back to a
+// sequential scan otherwise.
+static int open_at_entry(
+    const rar_archive_t* h,
+    int64_t index,
+    const rar_options* options,
+    struct archive** out_a,
+    struct archive_entry** out_entry,
+    rar_error_callback error_cb
+) {
+    struct archive* a;
+    struct archive_entry* entry;
+    int r;
+
+    if (index < 0 || (size_t)index >= h->count) {
+        if (error_cb) error_cb("Entry not found in archive");
+        return RAR_ENTRY_NOT_FOUND;
+    }
+
+    const char* name = h->names + h->entries[index].name_offset;
+
+    if (index > 0 && (a = open_spliced_reader(h, index, options)) != NULL) {
+        if (read_next_header(a, &entry, options) == ARCHIVE_OK) {
+            const char* pathname = archive_entry_pathname(entry);
+            if (pathname && strcmp(pathname, name) == 0) {
+                *out_a = a;
+                *out_entry = entry;
+                return RAR_SUCCESS;
+            }
+        }
+        // Unexpected layout; retry with a full scan
+        archive_read_free(a);
+    }
+
+    a = create_archive_reader(h->password);
+    if (!a) {
+        if (error_cb) error_cb("Failed to create archive reader");
+        return RAR_MEMORY_ERROR;
+    }
+
+    r = open_archive_file(a, h->path, options);
+    if (r != ARCHIVE_OK) {
+        int result = map_archive_error(a, error_cb);
+        archive_read_free(a);
+        return result;
+    }
+
+    int64_t i = 0;
+    while ((r = read_next_header(a, &entry, options)) == ARCHIVE_OK) {
+        if (i == index) {
+            *out_a = a;
+            *out_entry = entry;
+            return RAR_SUCCESS;
+        }
+        archive_read_data_skip(a);
+        i++;
+    }
+
+    int result = r == ARCHIVE_EOF ? RAR_ENTRY_NOT_FOUND : map_archive_error(a, error_cb);
+    if (r == ARCHIVE_EOF && error_cb) error_cb("Entry not found in archive");
+    archive_read_free(a);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Persistent index cache: entry tables saved between opens
+// ---------------------------------------------------------------------------
+
+// One file per archive path, named after the hash of the path:
+//   index_cache_header, the path, `count` index_entry structs, the names.
+// Entries are stored in their in-memory layout, so loading is three reads
+// straight into the handle's arrays; `layout` rejects files written by a
+// build with a different layout.
+#define INDEX_CACHE_MAGIC "RARIDX1"
+#define INDEX_CACHE_SUFFIX ".rix"
+#define INDEX_CACHE_HASH_BYTES 4096
+
+// What an index was built from; any change means the archive changed
+typedef struct {
+    int64_t size;           // Bytes in all volumes
+    int64_t mtime_ns;       // Latest modification time of any volume
+    uint64_t head_hash;     // Hash of the first INDEX_CACHE_HASH_BYTES
+    uint64_t volumes;
+} index_cache_key;
+
+typedef struct {
+    char magic[8];
+    uint32_t layout;        // sizeof(index_entry)
+    uint32_t path_len;      // Bytes of archive path following the header
+    index_cache_key key;
+    uint64_t count;
+    uint64_t names_len;
+} index_cache_header;
+
+struct rar_index_cache {
+    char* dir;
+    int64_t max_bytes;      // 0 = unlimited (atomic)
+    int64_t next_temp;      // Counter for temporary file names (atomic)
+    rar_mutex_t trim_lock;  // One trim at a time within the process
+};
+
+// Index file found in the cache directory
+typedef struct {
+    char* path;
+    int64_t size;
+    int64_t mtime_ns;
+} index_cache_file;
+
+// Helper: FNV-1a hash of `len` bytes
+static uint64_t hash_bytes(const void* data, size_t len) {
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Helper: Size and modification time (ns, platform epoch) of a file.
+// Returns 0, or -1 if it cannot be read.
+static int file_stamp(const char* path, int64_t* size, int64_t* mtime_ns) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    wchar_t* wpath = utf8_to_wide(path);
+    if (!wpath) return -1;
+    BOOL ok = GetFileAttributesExW(wpath, GetFileExInfoStandard, &data);
+    free(wpath);
+    if (!ok) return -1;
+    *size = ((int64_t)data.nFileSizeHigh << 32) | (int64_t)data.nFileSizeLow;
+    *mtime_ns = (((int64_t)data.ftLastWriteTime.dwHighDateTime << 32) |
+                 (int64_t)data.ftLastWriteTime.dwLowDateTime) * 100;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+    *size = (int64_t)st.st_size;
+#if defined(__APPLE__)
+    *mtime_ns = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    *mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+    return 0;
+}
+
+static void remove_file(const char* path) {
+#ifdef _WIN32
+    wchar_t* wpath = utf8_to_wide(path);
+    if (wpath) DeleteFileW(wpath);
+    free(wpath);
+#else
+    unlink(path);
+#endif
+}
+
+// Helper: Replace `to` with `from` in one step. Returns 0 or -1.
+static int replace_file(const char* from, const char* to) {
+#ifdef _WIN32
+    wchar_t* wfrom = utf8_to_wide(from);
+    wchar_t* wto = utf8_to_wide(to);
+    BOOL ok = wfrom && wto && MoveFileExW(wfrom, wto, MOVEFILE_REPLACE_EXISTING);
+    free(wfrom);
+    free(wto);
+    return ok ? 0 : -1;
+#else
+    return rename(from, to);
+#endif
+}
+
+// Helper: Set a file's modification time to now, marking it recently used
+static void touch_file(const char* path) {
+#ifdef _WIN32
+    wchar_t* wpath = utf8_to_wide(path);
+    if (!wpath) return;
+    HANDLE file = CreateFileW(wpath, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    free(wpath);
+    if (file == INVALID_HANDLE_VALUE) return;
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    SetFileTime(file, NULL, NULL, &now);
+    CloseHandle(file);
+#else
+    utimensat(AT_FDCWD, path, NULL, 0);
+#endif
+}
+
+// Helper: Write `count` blocks to a new file at `path`. Returns 0 or -1;
+// a partly written file is removed.
+static int write_new_file(const char* path, const void* const* blocks, const size_t* sizes, size_t count) {
+    int failed = 0;
+#ifdef _WIN32
+    wchar_t* wpath = utf8_to_wide(path);
+    if (!wpath) return -1;
+    HANDLE file = CreateFileW(wpath, GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+    free(wpath);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    for (size_t i = 0; i < count && !failed; i++) {
+        const unsigned char* p = (const unsigned char*)blocks[i];
+        size_t left = sizes[i];
+        while (left > 0) {
+            DWORD chunk = left > 0x40000000 ? 0x40000000 : (DWORD)left;
+            DWORD n = 0;
+            if (!WriteFile(file, p, chunk, &n, NULL) || n == 0) {
+                failed = 1;
+                break;
+            }
+            p += n;
+            left -= n;
+        }
+    }
+    if (!CloseHandle(file)) failed = 1;
+#else
+    int fd;
+    do {
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) return -1;
+    for (size_t i = 0; i < count && !failed; i++) {
+        const unsigned char* p = (const unsigned char*)blocks[i];
+        size_t left = sizes[i];
+        while (left > 0) {
+            ssize_t n = write(fd, p, left);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                failed = 1;
+                break;
+            }
+            p += n;
+            left -= (size_t)n;
+        }
+    }
+    if (close(fd) != 0) failed = 1;
+#endif
+    if (failed) remove_file(path);
+    return failed ? -1 : 0;
+}
+
+// Helper: Read exactly `len` bytes at `offset`. Returns 0 or -1.
+static int read_exact(const rar_file* f, int64_t offset, void* buf, size_t len) {
+    unsigned char* p = (unsigned char*)buf;
+    while (len > 0) {
+        int64_t n = rar_file_read(f, offset, p, len);
+        if (n <= 0) return -1;
+        p += n;
+        offset += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Helper: Path of a file in the cache directory
+static char* index_cache_join(const rar_index_cache_t* cache, const char* name) {
+    size_t dir_len = strlen(cache->dir);
+    size_t name_len = strlen(name);
+    char* path = malloc(dir_len + name_len + 2);
+    if (!path) return NULL;
+    memcpy(path, cache->dir, dir_len);
+    path[dir_len] = PATH_SEP;
+    memcpy(path + dir_len + 1, name, name_len + 1);
+    return path;
+}
+
+// Helper: Path of the index file of `rar_path`
+static char* index_cache_path(const rar_index_cache_t* cache, const char* rar_path) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx" INDEX_CACHE_SUFFIX,
+             (unsigned long long)hash_bytes(rar_path, strlen(rar_path)));
+    return index_cache_join(cache, name);
+}
+
+// Helper: Identify the volumes a cursor reads. Returns 0 or -1.
+static int index_cache_key_of(volume_cursor* c, index_cache_key* key) {
+    const volume_set* set = c->set;
+    unsigned char head[INDEX_CACHE_HASH_BYTES];
+
+    memset(key, 0, sizeof(*key));
+    key->size = set->size;
+    key->volumes = set->count;
+    for (size_t i = 0; i < set->count; i++) {
+        int64_t size, mtime_ns;
+        if (file_stamp(set->items[i].path, &size, &mtime_ns) != 0 || size != set->items[i].size) return -1;
+        if (mtime_ns > key->mtime_ns) key->mtime_ns = mtime_ns;
+    }
+    if (volume_cursor_select(c, 0) != 0) return -1;
+    key->head_hash = hash_bytes(head, read_at(&c->file, 0, head, sizeof(head)));
+    return 0;
+}
+
+// Helper: Fill an empty handle's index from the cache. Returns 0 on a hit,
+// -1 if there is no usable entry for this key (the handle stays empty).
+static int index_cache_load(rar_index_cache_t* cache, const char* rar_path, const index_cache_key* key, rar_archive_t* h) {
+    char* path = index_cache_path(cache, rar_path);
+    if (!path) return -1;
+
+    rar_file f;
+    if (rar_file_open(&f, path, RAR_IO_READ) != 0) {
+        free(path);
+        return -1;
+    }
+
+    index_cache_header hdr;
+    size_t path_len = strlen(rar_path);
+    char* stored_path = NULL;
+    int ok = read_exact(&f, 0, &hdr, sizeof(hdr)) == 0 &&
+             memcmp(hdr.magic, INDEX_CACHE_MAGIC, sizeof(hdr.magic)) == 0 &&
+             hdr.layout == sizeof(index_entry) && hdr.path_len == path_len &&
+             memcmp(&hdr.key, key, sizeof(*key)) == 0 &&
+             hdr.count <= (uint64_t)f.size / sizeof(index_entry) && hdr.names_len <= (uint64_t)f.size &&
+             (uint64_t)f.size == sizeof(hdr) + path_len + hdr.count * sizeof(index_entry) + hdr.names_len &&
+             (hdr.count == 0 || hdr.names_len > 0);
+
+    // The name is only a hash of the path, so the path itself must match
+    if (ok) {
+        stored_path = malloc(path_len + 1);
+        ok = stored_path && read_exact(&f, sizeof(hdr), stored_path, path_len) == 0 &&
+             memcmp(stored_path, rar_path, path_len) == 0;
+        free(stored_path);
+    }
+    if (ok && hdr.count > 0) {
+        int64_t at = (int64_t)(sizeof(hdr) + path_len);
+        h->entries = malloc((size_t)hdr.count * sizeof(index_entry));
+        h->names = malloc((size_t)hdr.names_len);
+        ok = h->entries && h->names &&
+             read_exact(&f, at, h->entries, (size_t)hdr.count * sizeof(index_entry)) == 0 &&
+             read_exact(&f, at + (int64_t)(hdr.count * sizeof(index_entry)), h->names, (size_t)hdr.names_len) == 0 &&
+             h->names[hdr.names_len - 1] == '\0';
+        for (uint64_t i = 0; ok && i < hdr.count; i++) {
+            ok = h->entries[i].name_offset < hdr.names_len;
+        }
+    }
+    rar_file_close(&f);
+
+    if (ok) {
+        h->count = h->capacity = (size_t)hdr.count;
+        h->names_len = h->names_cap = (size_t)hdr.names_len;
+        ok = index_build_lookup(h) == 0;
+    }
+    if (ok) touch_file(path);
+    free(path);
+
+    if (!ok) {
+        free(h->entries);
+        free(h->names);
+        free(h->buckets);
+        h->entries = NULL;
+        h->names = NULL;
+        h->buckets = NULL;
+        h->count = h->capacity = h->names_len = h->names_cap = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static int compare_file_age(const void* a, const void* b) {
+    const index_cache_file* x = (const index_cache_file*)a;
+    const index_cache_file* y = (const index_cache_file*)b;
+    return x->mtime_ns < y->mtime_ns ? -1 : x->mtime_ns > y->mtime_ns;
+}
+
+static int has_suffix(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n > m && strcmp(s + n - m, suffix) == 0;
+}
+
+static void index_cache_files_free(index_cache_file* files, int count) {
+    for (int i = 0; i < count; i++) free(files[i].path);
+    free(files);
+}
+
+// Helper: Record one directory entry if it is an index file
+static int index_cache_files_add(const rar_index_cache_t* cache, const char* name, index_cache_file** files, int* count, int* capacity) {
+    if (!has_suffix(name, INDEX_CACHE_SUFFIX)) return 0;
+    if (*count == *capacity) {
+        int cap = *capacity ? *capacity * 2 : 64;
+        index_cache_file* grown = realloc(*files, (size_t)cap * sizeof(index_cache_file));
+        if (!grown) return -1;
+        *files = grown;
+        *capacity = cap;
+    }
+    index_cache_file* file = &(*files)[*count];
+    file->path = index_cache_join(cache, name);
+    if (!file->path) return -1;
+    if (file_stamp(file->path, &file->size, &file->mtime_ns) != 0) {
+        free(file->path);
+        return 0;   // Removed meanwhile
+    }
+    (*count)++;
+    return 0;
+}
+
+// Helper: List the index files in the cache directory, oldest first. A
+// directory that cannot be read has none. Returns the number found, or -1
+// if memory ran out.
+static int index_cache_list(const rar_index_cache_t* cache, index_cache_file** out) {
+    index_cache_file* files = NULL;
+    int count = 0, capacity = 0, failed = 0;
+
+#ifdef _WIN32
+    char* pattern = index_cache_join(cache, "*" INDEX_CACHE_SUFFIX);
+    wchar_t* wpattern = pattern ? utf8_to_wide(pattern) : NULL;
+    free(pattern);
+    if (!wpattern) return -1;
+    WIN32_FIND_DATAW found;
+    HANDLE find = FindFirstFileW(wpattern, &found);
+    free(wpattern);
+    *out = NULL;
+    if (find == INVALID_HANDLE_VALUE) return 0;
+    do {
+        char name[MAX_PATH * 4];
+        if (WideCharToMultiByte(CP_UTF8, 0, found.cFileName, -1, name, sizeof(name), NULL, NULL) <= 0) continue;
+        failed = index_cache_files_add(cache, name, &files, &count, &capacity) != 0;
+    } while (!failed && FindNextFileW(find, &found));
+    FindClose(find);
+#else
+    *out = NULL;
+    DIR* dir = opendir(cache->dir);
+    if (!dir) return 0;
+    struct dirent* de;
+    while (!failed && (de = readdir(dir)) != NULL) {
+        failed = index_cache_files_add(cache, de->d_name, &files, &count, &capacity) != 0;
+    }
+    closedir(dir);
+#endif
+
+    if (failed) {
+        index_cache_files_free(files, count);
+        *out = NULL;
+        return -1;
+    }
+    if (count > 1) qsort(files, (size_t)count, sizeof(index_cache_file), compare_file_age);
+    *out = files;
+    return count;
+}
+
+// Helper: Remove the least recently used index files until the directory
+// is within the size limit
+static void index_cache_trim(rar_index_cache_t* cache) {
+    int64_t limit = rar_atomic_load(&cache->max_bytes);
+    if (limit <= 0) return;
+
+    rar_mutex_lock(&cache->trim_lock);
+    index_cache_file* files;
+    int count = index_cache_list(cache, &files);
+    int64_t total = 0;
+    for (int i = 0; i < count; i++) total += files[i].size;
+    for (int i = 0; i < count && total > limit; i++) {
+        remove_file(files[i].path);
+        total -= files[i].size;
+    }
+    index_cache_files_free(files, count > 0 ? count : 0);
+    rar_mutex_unlock(&cache->trim_lock);
+}
+
+// Helper: Save a handle's index. Written to a temporary file and renamed,
+// so readers in other threads or processes never see a partial file.
+// Failures only mean the next open parses the headers again.
+static void index_cache_store(rar_index_cache_t* cache, const char* rar_path, const index_cache_key* key, const rar_archive_t* h) {
+    index_cache_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, INDEX_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.layout = sizeof(index_entry);
+    hdr.path_len = (uint32_t)strlen(rar_path);
+    hdr.key = *key;
+    hdr.count = h->count;
+    hdr.names_len = h->names_len;
+
+    char* path = index_cache_path(cache, rar_path);
+    if (!path) return;
+
+    char temp_name[64];
+#ifdef _WIN32
+    unsigned long pid = (unsigned long)GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    snprintf(temp_name, sizeof(temp_name), "%016llx-%lu-%lld.tmp",
+             (unsigned long long)hash_bytes(rar_path, hdr.path_len), pid,
+             (long long)rar_atomic_fetch_add(&cache->next_temp, 1));
+    char* temp = index_cache_join(cache, temp_name);
+
+    const void* blocks[] = {&hdr, rar_path, h->entries, h->names};
+    size_t sizes[] = {sizeof(hdr), hdr.path_len, h->count * sizeof(index_entry), h->names_len};
+    if (temp && write_new_file(temp, blocks, sizes, 4) == 0) {
+        if (replace_file(temp, path) == 0) {
+            index_cache_trim(cache);
+        } else {
+            remove_file(temp);
+        }
+    }
+    free(temp);
+    free(path);
+}
+
+// Open a cache directory
+RAR_EXPORT int rar_index_cache_open(const char* dir, uint64_t max_bytes, rar_index_cache_t** out_cache) {
+    if (!out_cache) return RAR_UNKNOWN_ERROR;
+    *out_cache = NULL;
+    if (!dir || !*dir) return RAR_CREATE_ERROR;
+    if (create_directory_recursive(dir) != 0) return RAR_CREATE_ERROR;
+
+    rar_index_cache_t* cache = calloc(1, sizeof(rar_index_cache_t));
+    if (!cache) return RAR_MEMORY_ERROR;
+    cache->dir = strdup(dir);
+    if (!cache->dir) {
+        free(cache);
+        return RAR_MEMORY_ERROR;
+    }
+    // Trailing separators would double up in joined paths
+    size_t len = strlen(cache->dir);
+    while (len > 1 && (cache->dir[len - 1] == '/' || cache->dir[len - 1] == PATH_SEP)) cache->dir[--len] = '\0';
+
+    cache->max_bytes = max_bytes > (uint64_t)INT64_MAX ? INT64_MAX : (int64_t)max_bytes;
+    rar_mutex_init(&cache->trim_lock);
+    index_cache_trim(cache);
+    *out_cache = cache;
+    return RAR_SUCCESS;
+}
+
+// Change the size limit
+RAR_EXPORT void rar_index_cache_set_limit(rar_index_cache_t* cache, uint64_t max_bytes) {
+    if (!cache) return;
+    rar_atomic_store(&cache->max_bytes, max_bytes > (uint64_t)INT64_MAX ? INT64_MAX : (int64_t)max_bytes);
+    index_cache_trim(cache);
+}
+
+// Forget one archive, or all of them
+RAR_EXPORT int rar_index_cache_invalidate(rar_index_cache_t* cache, const char* rar_path) {
+    if (!cache) return RAR_SUCCESS;
+
+    if (rar_path) {
+        char* path = index_cache_path(cache, rar_path);
+        if (!path) return RAR_MEMORY_ERROR;
+        remove_file(path);
+        free(path);
+        return RAR_SUCCESS;
+    }
+
+    rar_mutex_lock(&cache->trim_lock);
+    index_cache_file* files;
+    int count = index_cache_list(cache, &files);
+    for (int i = 0; i < count; i++) remove_file(files[i].path);
+    index_cache_files_free(files, count > 0 ? count : 0);
+    rar_mutex_unlock(&cache->trim_lock);
+    return count < 0 ? RAR_MEMORY_ERROR : RAR_SUCCESS;
+}
+
+// Release a cache handle
+RAR_EXPORT void rar_index_cache_close(rar_index_cache_t* cache) {
+    if (!cache) return;
+    rar_mutex_destroy(&cache->trim_lock);
+    free(cache->dir);
+    free(cache);
+}
+
+// Open archive and build the index
+RAR_EXPORT int rar_open(
+    const char* rar_path,
+    const char* password,
+    rar_archive_t** out_archive,
+    rar_error_callback error_cb
+) {
+    return rar_open_ex(rar_path, password, NULL, out_archive, error_cb);
+}
+
+// Open archive with explicit options and build the index
+RAR_EXPORT int rar_open_ex(
+    const char* rar_path,
+    const char* password,
+    const rar_options* options,
+    rar_archive_t** out_archive,
+    rar_error_callback error_cb
+) {
+    struct archive* a = NULL;
+    struct archive_entry* entry;
+    int r;
+    int result = RAR_SUCCESS;
+
+    if (!out_archive) return RAR_UNKNOWN_ERROR;
+    *out_archive = NULL;
+    options = options_or_default(options);
+
+    // Raw header reader over every volume, also used as the existence check
+    volume_set set;
+    volume_cursor cursor;
+    if (volume_set_open(&set, &cursor, rar_path, options->io_mode) != 0) {
+        if (error_cb) error_cb("RAR file not found");
+        return RAR_FILE_NOT_FOUND;
+    }
+
+    rar_archive_t* h = calloc(1, sizeof(rar_archive_t));
+    if (!h) {
+        volume_set_close(&set, &cursor);
+        if (error_cb) error_cb("Memory allocation failed");
+        return RAR_MEMORY_ERROR;
+    }
+    rar_mutex_init(&h->read_lock);
+    rar_cond_init(&h->prefetch_cond);
+    h->prefetch_next = -1;
+    h->prefetch_busy = -1;
+    h->prefetch_failed = -1;
+    h->path = strdup(rar_path);
+    h->password = dup_optional(password);
+    h->options = *options;
+    h->options.cancel_token = NULL;  // Only covers the open itself
+    h->options.index_cache = NULL;
+    h->options.stats = NULL;
+    h->options.filter = NULL;  // Per extraction call
+    rar_probe_info probe;
+    int probed = RAR_FILE_NOT_FOUND;
+    memset(&probe, 0, sizeof(probe));
+    if (volume_cursor_select(&cursor, 0) == 0) probed = probe_file(&cursor.file, &probe);
+    h->version = probe.version;
+    h->solid = probe_solid(probed, &probe);
+    if (!h->path || (password && *password && !h->password)) {
+        volume_set_close(&set, &cursor);
+        rar_close(h);
+        if (error_cb) error_cb("Memory allocation failed");
+        return RAR_MEMORY_ERROR;
+    }
+
+    // A saved index replaces the header scan while the archive is unchanged.
+    // Never for encrypted headers: the saved names would skip the password.
+    index_cache_key key;
+    int cacheable = options->index_cache && probed == RAR_SUCCESS &&
+                    !(probe.flags & RAR_ARCHIVE_ENCRYPTED_HEADERS) &&
+                    index_cache_key_of(&cursor, &key) == 0;
+    if (cacheable && index_cache_load(options->index_cache, rar_path, &key, h) == 0) {
+        volume_set_close(&set, &cursor);
+        *out_archive = h;
+        return RAR_SUCCESS;
+    }
+
+    a = create_archive_reader(password);
+    if (!a) {
+        volume_set_close(&set, &cursor);
+        rar_close(h);
+        if (error_cb) error_cb("Failed to create archive reader");
+        return RAR_MEMORY_ERROR;
+    }
+
+    r = open_archive_file(a, rar_path, options);
+    if (r != ARCHIVE_OK) {
+        result = map_archive_error(a, error_cb);
+        archive_read_free(a);
+        volume_set_close(&set, &cursor);
+        rar_close(h);
+        return result;
+    }
+
+    while ((r = read_next_header(a, &entry, options)) == ARCHIVE_OK) {
+        const char* pathname = archive_entry_pathname(entry);
+        index_entry e;
+        raw_file_header raw;
+
+        memset(&e, 0, sizeof(e));
+        e.size = (uint64_t)archive_entry_size(entry);
+        e.mtime = (int64_t)archive_entry_mtime(entry);
+        e.mode = (uint32_t)archive_entry_mode(entry);
+        e.header_offset = -1;
+        e.data_offset = -1;
+        if (archive_entry_filetype(entry) == AE_IFDIR) e.flags |= RAR_ENTRY_DIRECTORY;
+        if (archive_entry_is_encrypted(entry)) e.flags |= RAR_ENTRY_ENCRYPTED;
+
+        // libarchive reports where this header starts (0 for the first one),
+        // counting across volumes
+        int64_t pos = h->count == 0 ? 0 : archive_read_header_position(a);
+        if (h->version && parse_set_header(&cursor, h->version, pos, &raw) == 0) {
+            e.header_offset = raw.header_offset;
+            e.data_offset = raw.data_offset;
+            e.packed_size = raw.packed_size;
+            e.crc32 = raw.crc32;
+            e.flags |= raw.flags;
+        }
+
+        if (index_append(h, pathname ? pathname : "", &e) != 0) {
+            result = RAR_MEMORY_ERROR;
+            if (error_cb) error_cb("Memory allocation failed");
+            break;
+        }
+
+        archive_read_data_skip(a);
+    }
+
+    if (r != ARCHIVE_EOF && result == RAR_SUCCESS) {
+        result = map_archive_error(a, error_cb);
+    }
+    if (result == RAR_SUCCESS && index_build_lookup(h) != 0) {
+        result = RAR_MEMORY_ERROR;
+        if (error_cb) error_cb("Memory allocation failed");
+    }
+
+    archive_read_close(a);
+    archive_read_free(a);
+    volume_set_close(&set, &cursor);
+
+    if (result != RAR_SUCCESS) {
+        rar_close(h);
+        return result;
+    }
+    if (cacheable) index_cache_store(options->index_cache, rar_path, &key, h);
+
+    *out_archive = h;
+    return RAR_SUCCESS;
+}
+
+// Close archive handle
+RAR_EXPORT void rar_close(rar_archive_t* archive) {
+    if (!archive) return;
+    if (archive->prefetch_running) {
+        // Lets the entry being decompressed finish
+        rar_mutex_lock(&archive->read_lock);
+        archive->prefetch_stop = 1;
+        rar_cond_broadcast(&archive->prefetch_cond);
+        rar_mutex_unlock(&archive->read_lock);
+        rar_thread_join(archive->prefetch_thread);
+    }
+    for (size_t i = 0; i < READ_CURSOR_COUNT; i++) {
+        if (archive->cursors[i].a) archive_read_free(archive->cursors[i].a);
+    }
+    for (size_t i = 0; i < archive->volumes.count; i++) {
+        if (archive->read_open[i]) rar_file_close(&archive->read_files[i]);
+    }
+    free(archive->read_files);
+    free(archive->read_open);
+    volume_set_free(&archive->volumes);
+    for (entry_cache_item* item = archive->lru_first; item;) {
+        entry_cache_item* next = item->next;
+        free(item->data);
+        free(item);
+        item = next;
+    }
+    free(archive->cached);
+    rar_cond_destroy(&archive->prefetch_cond);
+    rar_mutex_destroy(&archive->read_lock);
+    free(archive->path);
+    free(archive->password);
+    free(archive->entries);
+    free(archive->names);
+    free(archive->buckets);
+    free(archive);
+}
+
+// Counters kept by the handle
+RAR_EXPORT void rar_archive_stats(const rar_archive_t* archive, rar_stats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!archive) return;
+
+    rar_archive_t* h = (rar_archive_t*)archive;
+    rar_mutex_lock(&h->read_lock);
+    stats->cache_hits = h->cache_hits;
+    stats->cache_misses = h->cache_misses;
+    rar_mutex_unlock(&h->read_lock);
+}
+
+// Number of indexed entries
+RAR_EXPORT int64_t rar_entry_count(const rar_archive_t* archive) {
+    return archive ? (int64_t)archive->count : 0;
+}
+
+// Helper: Fill the public struct from an index entry
+static void fill_entry_info(const rar_archive_t* archive, const index_entry* e, rar_entry_info* info) {
+    info->name = archive->names + e->name_offset;
+    info->size = e->size;
+    info->packed_size = e->packed_size;
+    info->mtime = e->mtime;
+    info->header_offset = e->header_offset;
+    info->data_offset = e->data_offset;
+    info->crc32 = e->crc32;
+    info->mode = e->mode;
+    info->flags = e->flags;
+}
+
+// Entry metadata
+RAR_EXPORT int rar_stat(
+    const rar_archive_t* archive,
+    int64_t index,
+    rar_entry_info* info
+) {
+    if (!archive || !info || index < 0 || (size_t)index >= archive->count) {
+        return RAR_ENTRY_NOT_FOUND;
+    }
+
+    fill_entry_info(archive, &archive->entries[index], info);
+    return RAR_SUCCESS;
+}
+
+// Page of entry metadata
+RAR_EXPORT int rar_list_batch(
+    const rar_archive_t* archive,
+    int64_t start,
+    rar_entry_info* out,
+    size_t max_entries,
+    size_t* out_count
+) {
+    if (!archive || !out_count || (!out && max_entries > 0) || start < 0) {
+        return RAR_UNKNOWN_ERROR;
+    }
+
+    size_t n = 0;
+    for (size_t i = (size_t)start; i < archive->count && n < max_entries; i++, n++) {
+        fill_entry_info(archive, &archive->entries[i], &out[n]);
+    }
+
+    *out_count = n;
+    return RAR_SUCCESS;
+}
+
+// Name lookup
+RAR_EXPORT int64_t rar_find_entry(const rar_archive_t* archive, const char* name) {
+    if (!archive || !name || !archive->buckets) return -1;
+
+    size_t mask = archive->bucket_count - 1;
+    size_t slot = (size_t)hash_string(name) & mask;
+    while (archive->buckets[slot] != -1) {
+        int64_t i = archive->buckets[slot];
+        if (strcmp(archive->names + archive->entries[i].name_offset, name) == 0) return i;
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+// List from the index
+RAR_EXPORT int rar_list_entries(
+    const rar_archive_t* archive,
+    rar_list_callback list_cb
+) {
+    if (!archive || !list_cb) return RAR_SUCCESS;
+    for (size_t i = 0; i < archive->count; i++) {
+        list_cb(archive->names + archive->entries[i].name_offset);
+    }
+    return RAR_SUCCESS;
+}
+
+// Packed names of the whole index
+RAR_EXPORT int rar_entry_names(
+    const rar_archive_t* archive,
+    const char** out_names,
+    size_t* out_len
+) {
+    if (!archive || !out_names || !out_len) return RAR_UNKNOWN_ERROR;
+    *out_names = archive->names;
+    *out_len = archive->count > 0 ? archive->names_len : 0;
+    return RAR_SUCCESS;
+}
+
+// Extract everything from an opened archive
+RAR_EXPORT int rar_extract_all(
+    const rar_archive_t* archive,
+    const char* dest_path,
+    rar_error_callback error_cb
+) {
+    return rar_extract_all_ex(archive, dest_path, NULL, error_cb);
+}
+
+// Extract everything from an opened archive with per-call options
+RAR_EXPORT int rar_extract_all_ex(
+    const rar_archive_t* archive,
+    const char* dest_path,
+    const rar_options* options,
+    rar_error_callback error_cb
+) {
+    if (!archive) return RAR_UNKNOWN_ERROR;
+    if (!options) options = &archive->options;
+
+    // The index provides the totals, of the entries the filter passes
+    int64_t entries_total = 0;
+    int64_t bytes_total = 0;
+    for (size_t i = 0; i < archive->count; i++) {
+        const index_entry* e = &archive->entries[i];
+        if (!filter_matches(options->filter, archive->names + e->name_offset, e->size,
+                            (e->flags & RAR_ENTRY_DIRECTORY) != 0)) continue;
+        entries_total++;
+        bytes_total += (int64_t)e->size;
+    }
+
+    progress_tracker tracker;
+    progress_init(&tracker, options, entries_total, bytes_total);
+
+    int result;
+    if (archive->solid == 0) {
+        int threads = options->extract_threads > MAX_EXTRACT_THREADS ? MAX_EXTRACT_THREADS : (int)options->extract_threads;
+        result = extract_parallel(archive->path, dest_path, archive->password, threads, options, &tracker, error_cb);
+    } else {
+        result = extract_sequential(archive->path, dest_path, archive->password, options, &tracker, error_cb);
+    }
+
+    progress_report(&tracker, 1, -1, NULL);
+    progress_destroy(&tracker);
+    return result;
+}
+
+// Extract one entry from an opened archive
+RAR_EXPORT int rar_extract_entry(
+    const rar_archive_t* archive,
+    int64_t index,
+    const char* dest_path,
+    rar_error_callback error_cb
+) {
+    return rar_extract_entry_ex(archive, index, dest_path, NULL, error_cb);
+}
+
+// Extract one entry from an opened archive with per-call options
+RAR_EXPORT int rar_extract_entry_ex(
+    const rar_archive_t* archive,
+    int64_t index,
+    const char* dest_path,
+    const rar_options* options,
+    rar_error_callback error_cb
+) {
+    struct archive* a = NULL;
+    struct archive_entry* entry;
+    disk_output disk;
+    write_stage stage;
+    int result;
+
+    if (!archive) return RAR_UNKNOWN_ERROR;
+    if (!options) options = &archive->options;
+    if (index < 0 || (size_t)index >= archive->count) {
+        if (error_cb) error_cb("Entry not found in archive");
+        return RAR_ENTRY_NOT_FOUND;
+    }
+
+    // No need for a write buffer larger than the entry itself
+    size_t buffer_size = resolve_write_buffer_size(options, archive->path, dest_path);
+    if (archive->entries[index].size < buffer_size) buffer_size = (size_t)archive->entries[index].size;
+
+    if (create_directory_recursive(dest_path) != 0) {
+        if (error_cb) error_cb("Failed to create destination directory");
+        return RAR_CREATE_ERROR;
+    }
+
+    if (disk_output_init(&disk, options) != 0) {
+        if (error_cb) error_cb("Failed to create disk writer");
+        return RAR_MEMORY_ERROR;
+    }
+    if (disk_output_begin(&disk, dest_path) != 0 || write_stage_init(&stage, &disk, options, buffer_size) != 0) {
+        disk_output_free(&disk);
+        if (error_cb) error_cb("Memory allocation failed");
+        return RAR_MEMORY_ERROR;
+    }
+
+    progress_tracker tracker;
+    progress_sink_ctx progress;
+    progress_init(&tracker, options, 1, (int64_t)archive->entries[index].size);
+
+    result = open_at_entry(archive, index, options, &a, &entry, error_cb);
+    if (result == RAR_SUCCESS) {
+        progress_sink_init(&progress, &tracker, a);
+        result = extract_entry(a, &disk, &stage.out, &progress, options->cancel_token, index, entry, error_cb);
+        archive_read_close(a);
+        archive_read_free(a);
+    }
+
+    write_stage_free(&stage);
+    disk_output_free(&disk);
+    progress_report(&tracker, 1, -1, NULL);
+    progress_destroy(&tracker);
+
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// CRC32 (the IEEE polynomial used by RAR and zlib)
+// ---------------------------------------------------------------------------
+
+// Lookup tables for slicing by 8 bytes, and the hardware path if the CPU has one
+static uint32_t crc32_tables[8][256];
+static int crc32_hardware;
+static rar_once_t crc32_once = RAR_ONCE_INIT;
+
+static void crc32_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc32_tables[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) {
+            uint32_t c = crc32_tables[t - 1][i];
+            crc32_tables[t][i] = crc32_tables[0][c & 0xFF] ^ (c >> 8);
+        }
+    }
+
+#if defined(RAR_CRC32_PCLMUL)
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 1);
+    crc32_hardware = (regs[2] & (1 << 1)) && (regs[2] & (1 << 19));  // PCLMULQDQ, SSE4.1
+#else
+    __builtin_cpu_init();
+    crc32_hardware = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+#elif defined(RAR_CRC32_ARM)
+#if defined(__APPLE__)
+    crc32_hardware = 1;
+#elif defined(_WIN32)
+    crc32_hardware = IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__linux__)
+    crc32_hardware = (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif
+#endif
+}
+
+// Helper: Table-driven CRC of `len` bytes; `crc` is the inverted running value
+static uint32_t crc32_slice8(uint32_t crc, const unsigned char* p, size_t len) {
+    while (len >= 8) {
+        uint32_t lo = crc ^ read_le32(p);
+        uint32_t hi = read_le32(p + 4);
+        crc = crc32_tables[7][lo & 0xFF] ^ crc32_tables[6][(lo >> 8) & 0xFF] ^
+              crc32_tables[5][(lo >> 16) & 0xFF] ^ crc32_tables[4][lo >> 24] ^
+              crc32_tables[3][hi & 0xFF] ^ crc32_tables[2][(hi >> 8) & 0xFF] ^
+              crc32_tables[1][(hi >> 16) & 0xFF] ^ crc32_tables[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len--) crc = crc32_tables[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#if defined(RAR_CRC32_PCLMUL)
+// Helper: Fold 16-byte lanes with carry-less multiplies and reduce them with
+// Barrett's method (Intel, "Fast CRC Computation for Generic Polynomials
+// Using PCLMULQDQ"). `len` is at least 64 and a multiple of 16; `crc` is the
+// inverted running value.
+#if !defined(_MSC_VER)
+__attribute__((target("pclmul,sse4.1")))
+#endif
+static uint32_t crc32_pclmul(uint32_t crc, const unsigned char* p, size_t len) {
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const __m128i k5 = _mm_set_epi64x(0, 0x0163cd6124);
+    const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+    __m128i x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+    __m128i x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    p += 64;
+    len -= 64;
+
+    // Four lanes of 16 bytes at a time
+    while (len >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p + 0x30)));
+        p += 64;
+        len -= 64;
+    }
+
+    // Fold the four lanes into one, then any remaining 16-byte blocks
+    __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x4), x5);
+    while (len >= 16) {
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)p)), x5);
+        p += 16;
+        len -= 16;
+    }
+
+    // 128 bits to 64
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, low32);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5, 0x00), x2);
+
+    // Barrett reduction to 32 bits
+    x2 = _mm_and_si128(x1, low32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, low32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+#endif
+
+#if defined(RAR_CRC32_ARM)
+// Helper: CRC with the ARMv8 CRC32 instructions; `crc` is the inverted
+// running value
+#if defined(__clang__) && !defined(__ARM_FEATURE_CRC32)
+__attribute__((target("crc")))
+#elif defined(__GNUC__) && !defined(__ARM_FEATURE_CRC32)
+__attribute__((target("+crc")))
+#endif
+static uint32_t crc32_arm(uint32_t crc, const unsigned char* p, size_t len) {
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        crc = __crc32d(crc, v);
+        p += 8;
+        len -= 8;
+    }
+    while (len--) crc = __crc32b(crc, *p++);
+    return crc;
+}
+#endif
+
+// Helper: Continue `crc` (0 to start) over `len` bytes
+static uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
+    const unsigned char* p = (const unsigned char*)data;
+    rar_once(&crc32_once, crc32_init);
+    crc = ~crc;
+#if defined(RAR_CRC32_PCLMUL)
+    if (crc32_hardware && len >= 64) {
+        size_t chunk = len & ~(size_t)15;
+        crc = crc32_pclmul(crc, p, chunk);
+        p += chunk;
+        len -= chunk;
+    }
+#elif defined(RAR_CRC32_ARM)
+    if (crc32_hardware) return ~crc32_arm(crc, p, len);
+#endif
+    return ~crc32_slice8(crc, p, len);
+}
+
+// ---------------------------------------------------------------------------
+// Archive test: decompress every entry without writing it
+// ---------------------------------------------------------------------------
+
+// Shared state for one rar_test call
+typedef struct {
+    const rar_archive_t* archive;
+    const rar_options* options;
+    progress_tracker* tracker;
+    int stop_on_damage;   // Solid: no reading on past data that failed to decode
+    int64_t next_entry;   // Next unclaimed entry index (atomic)
+    int64_t failed;       // Set once testing has to stop (atomic)
+    int64_t tested;       // Entries decompressed (atomic)
+    int result;           // First archive-level error, guarded by lock
+    char error_message[256];  // Its message, guarded by lock
+    rar_test_failure* failures;  // Damaged entries, guarded by lock
+    size_t failure_count;
+    size_t failure_cap;
+    rar_mutex_t lock;
+} test_ctx;
+
+static int discard_sink(void* ctx, const void* buff, size_t size, int64_t offset) {
+    (void)ctx;
+    (void)buff;
+    (void)size;
+    (void)offset;
+    return ARCHIVE_OK;
+}
+
+// Sink that only checksums what it is given. Holes (blocks that skip ahead)
+// read as zeros, as they would on disk.
+typedef struct {
+    uint32_t crc;
+    int64_t pos;
+} crc_sink_ctx;
+
+static int crc_sink(void* ctx, const void* buff, size_t size, int64_t offset) {
+    static const unsigned char zeros[4096];
+    crc_sink_ctx* c = (crc_sink_ctx*)ctx;
+    while (offset > c->pos) {
+        int64_t gap = offset - c->pos;
+        size_t n = gap < (int64_t)sizeof(zeros) ? (size_t)gap : sizeof(zeros);
+        c->crc = crc32_update(c->crc, zeros, n);
+        c->pos += (int64_t)n;
+    }
+    c->crc = crc32_update(c->crc, buff, size);
+    c->pos += (int64_t)size;
+    return ARCHIVE_OK;
+}
+
+// Helper: Record an error that stops the whole test; only the first one is
+// kept, and reported to error_cb by rar_test after the workers have joined
+static void test_fail(test_ctx* ctx, struct archive* a, int code) {
+    const char* message;
+    code = worker_error(a, code, &message);
+    rar_mutex_lock(&ctx->lock);
+    if (ctx->result == RAR_SUCCESS) {
+        ctx->result = code;
+        snprintf(ctx->error_message, sizeof(ctx->error_message), "%s", message ? message : "");
+    }
+    rar_mutex_unlock(&ctx->lock);
+    rar_atomic_store(&ctx->failed, 1);
+}
+
+// Helper: Add a damaged entry to the report
+static void test_add_failure(test_ctx* ctx, int64_t index, int code, const char* message) {
+    const char* name = ctx->archive->names + ctx->archive->entries[index].name_offset;
+    int ok = 1;
+
+    rar_mutex_lock(&ctx->lock);
+    if (ctx->failure_count == ctx->failure_cap) {
+        size_t cap = ctx->failure_cap ? ctx->failure_cap * 2 : 16;
+        rar_test_failure* failures = realloc(ctx->failures, cap * sizeof(*failures));
+        if (failures) {
+            ctx->failures = failures;
+            ctx->failure_cap = cap;
+        } else {
+            ok = 0;
+        }
+    }
+    char* name_copy = ok ? strdup(name) : NULL;
+    char* message_copy = ok && message ? strdup(message) : NULL;
+    if (!name_copy || (message && !message_copy)) {
+        free(name_copy);
+        free(message_copy);
+        ok = 0;
+    }
+    if (ok) {
+        rar_test_failure* f = &ctx->failures[ctx->failure_count++];
+        f->index = index;
+        f->code = code;
+        f->name = name_copy;
+        f->message = message_copy;
+    }
+    rar_mutex_unlock(&ctx->lock);
+
+    if (!ok) test_fail(ctx, NULL, RAR_MEMORY_ERROR);
+}
+
+// Helper: Decompress the current entry of `a`, entry `index` of the index,
+// and compare its CRC. libarchive checks the data it decompresses but not
+// stored data, so every entry with a CRC is checked here as well, except
+// split entries (their headers hold the CRC of one part) and encrypted ones
+// (RAR5 turns their CRC into a keyed hash). Returns RAR_SUCCESS, the damage
+// found (RAR_BAD_DATA, RAR_BAD_PASSWORD) with `*reader_ok` telling whether
+// `a` can read on, or an error that stops the test.
+static int test_entry(test_ctx* ctx, struct archive* a, struct archive_entry* entry, int64_t index, progress_sink_ctx* progress, int* reader_ok) {
+    const index_entry* e = &ctx->archive->entries[index];
+    *reader_ok = 1;
+    if (archive_entry_size_is_set(entry) && archive_entry_size(entry) <= 0 && e->size == 0) return RAR_SUCCESS;
+
+    crc_sink_ctx crc = {0, 0};
+    int check = (e->flags & RAR_ENTRY_HAS_CRC) &&
+                !(e->flags & (RAR_ENTRY_ENCRYPTED | RAR_ENTRY_SPLIT_BEFORE | RAR_ENTRY_SPLIT_AFTER));
+    data_sink sink = check ? crc_sink : discard_sink;
+
+    progress_begin_entry(progress, index, ctx->archive->names + e->name_offset);
+    int r;
+    if (progress->tracker->cb) {
+        progress->next = sink;
+        progress->next_ctx = &crc;
+        r = copy_data_to(a, progress_sink, progress, ctx->options->cancel_token, STATS_OF(ctx->options));
+    } else {
+        r = copy_data_to(a, sink, &crc, ctx->options->cancel_token, STATS_OF(ctx->options));
+    }
+
+    if (r != ARCHIVE_OK) {
+        // Anything else wrong with the data is damage: a corrupt stream, or
+        // a checksum libarchive found to be wrong
+        *reader_ok = 0;
+        int code = map_archive_error(a, NULL);
+        if (code == RAR_CANCELLED || code == RAR_MEMORY_ERROR || code == RAR_BAD_PASSWORD) return code;
+        return RAR_BAD_DATA;
+    }
+    progress_end_entry(progress);
+    if (check && (crc.crc != e->crc32 || (uint64_t)crc.pos != e->size)) return RAR_BAD_DATA;
+    return RAR_SUCCESS;
+}
+
+// Worker: claim entries like parallel_extract_worker, skipping past the
+// others. Data that libarchive fails to decode leaves its reader unusable,
+// so the worker then opens a new one and scans on to its next claim.
+static RAR_THREAD_RETURN test_worker(void* arg) {
+    test_ctx* ctx = (test_ctx*)arg;
+    const rar_archive_t* h = ctx->archive;
+    struct archive_entry* entry;
+    progress_sink_ctx progress;
+    int64_t claimed = rar_atomic_fetch_add(&ctx->next_entry, 1);
+
+    while (!rar_atomic_load(&ctx->failed) && claimed < (int64_t)h->count) {
+        struct archive* a = create_archive_reader(h->password);
+        if (!a) {
+            test_fail(ctx, NULL, RAR_MEMORY_ERROR);
+            break;
+        }
+        if (open_archive_file(a, h->path, ctx->options) != ARCHIVE_OK) {
+            test_fail(ctx, a, RAR_OPEN_ERROR);
+            archive_read_free(a);
+            break;
+        }
+        progress_sink_init(&progress, ctx->tracker, a);
+
+        int reader_ok = 1;
+        int r = ARCHIVE_OK;
+        for (int64_t index = 0; reader_ok && claimed < (int64_t)h->count && !rar_atomic_load(&ctx->failed) &&
+                                (r = read_next_header(a, &entry, ctx->options)) == ARCHIVE_OK; index++) {
+            if (index != claimed) {
+                archive_read_data_skip(a);
+                continue;
+            }
+
+            int code = test_entry(ctx, a, entry, index, &progress, &reader_ok);
+            rar_atomic_fetch_add(&ctx->tested, 1);
+            if (code == RAR_BAD_DATA || code == RAR_BAD_PASSWORD) {
+                test_add_failure(ctx, index, code, reader_ok ? "CRC mismatch" : archive_error_string(a));
+                if (ctx->stop_on_damage && !reader_ok) rar_atomic_store(&ctx->failed, 1);
+            } else if (code != RAR_SUCCESS) {
+                test_fail(ctx, NULL, code);
+                break;
+            }
+            claimed = rar_atomic_fetch_add(&ctx->next_entry, 1);
+        }
+
+        if (reader_ok && r != ARCHIVE_EOF && r != ARCHIVE_OK) {
+            test_fail(ctx, a, RAR_UNKNOWN_ERROR);
+        }
+
+        archive_read_close(a);
+        archive_read_free(a);
+        if (reader_ok) break;
+    }
+    return 0;
+}
+
+static int compare_failure_index(const void* a, const void* b) {
+    int64_t x = ((const rar_test_failure*)a)->index;
+    int64_t y = ((const rar_test_failure*)b)->index;
+    return x < y ? -1 : x > y;
+}
+
+// Test archive contents without writing them
+RAR_EXPORT int rar_test(
+    const char* rar_path,
+    const char* password,
+    int num_threads,
+    const rar_options* options,
+    rar_test_report* report,
+    rar_error_callback error_cb
+) {
+    rar_archive_t* h = NULL;
+
+    if (!report) return RAR_UNKNOWN_ERROR;
+    memset(report, 0, sizeof(*report));
+    options = options_or_default(options);
+
+    // The index supplies the CRCs, the totals for progress and the layout
+    int result = rar_open_ex(rar_path, password, options, &h, error_cb);
+    if (result != RAR_SUCCESS) return result;
+
+    test_ctx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.archive = h;
+    ctx.options = options;
+    ctx.result = RAR_SUCCESS;
+
+    // Solid archives must be decompressed in order; unknown layouts too
+    if (num_threads <= 0) num_threads = rar_cpu_count();
+    if (num_threads > MAX_EXTRACT_THREADS) num_threads = MAX_EXTRACT_THREADS;
+    if ((size_t)num_threads > h->count) num_threads = h->count > 0 ? (int)h->count : 1;
+    if (h->solid != 0) {
+        ctx.stop_on_damage = 1;
+        num_threads = 1;
+    }
+
+    int64_t bytes_total = 0;
+    for (size_t i = 0; i < h->count; i++) bytes_total += (int64_t)h->entries[i].size;
+    progress_tracker tracker;
+    progress_init(&tracker, options, (int64_t)h->count, bytes_total);
+    ctx.tracker = &tracker;
+    rar_mutex_init(&ctx.lock);
+
+    rar_thread_t threads[MAX_EXTRACT_THREADS];
+    int started = 0;
+    if (num_threads > 1) {
+        for (; started < num_threads; started++) {
+            if (rar_thread_create(&threads[started], test_worker, &ctx) != 0) break;
+        }
+    }
+    if (started == 0) test_worker(&ctx);
+    for (int i = 0; i < started; i++) {
+        rar_thread_join(threads[i]);
+    }
+
+    progress_report(&tracker, 1, -1, NULL);
+    progress_destroy(&tracker);
+    rar_mutex_destroy(&ctx.lock);
+    rar_close(h);
+
+    if (ctx.failure_count > 1) qsort(ctx.failures, ctx.failure_count, sizeof(*ctx.failures), compare_failure_index);
+    report->entries_tested = rar_atomic_load(&ctx.tested);
+    report->failure_count = ctx.failure_count;
+    report->failures = ctx.failures;
+
+    if (ctx.result != RAR_SUCCESS) {
+        if (error_cb && ctx.error_message[0]) error_cb(ctx.error_message);
+        return ctx.result;
+    }
+    if (ctx.failure_count > 0) {
+        if (error_cb) error_cb("Damaged entries found");
+        return RAR_BAD_DATA;
+    }
+    return RAR_SUCCESS;
+}
+
+// Free a test report
+RAR_EXPORT void rar_test_report_free(rar_test_report* report) {
+    if (!report) return;
+    for (size_t i = 0; i < report->failure_count; i++) {
+        free(report->failures[i].name);
+        free(report->failures[i].message);
+    }
+    free(report->failures);
+    memset(report, 0, sizeof(*report));
+}
+
+// Memory destination for decompressed entries
+typedef struct {
+    unsigned char* data;
+    size_t len;
+    size_t capacity;
+    int growable;           // 0 for caller-supplied buffers
+    int error;              // RAR_* code when the sink stops the copy
+} memory_sink_ctx;
+
+static int memory_sink(void* ctx, const void* buff, size_t size, int64_t offset) {
+    memory_sink_ctx* m = (memory_sink_ctx*)ctx;
+    if (offset < 0) offset = (int64_t)m->len;
+
+    size_t end = (size_t)offset + size;
+    if (end > m->capacity) {
+        if (!m->growable) {
+            m->error = RAR_BUFFER_TOO_SMALL;
+            return ARCHIVE_FATAL;
+        }
+        size_t cap = m->capacity ? m->capacity : BUFFER_SIZE;
+        while (cap < end) cap *= 2;
+        unsigned char* data = realloc(m->data, cap);
+        if (!data) {
+            m->error = RAR_MEMORY_ERROR;
+            return ARCHIVE_FATAL;
+        }
+        m->data = data;
+        m->capacity = cap;
+    }
+
+    // Zero-fill holes left by sparse blocks
+    if ((size_t)offset > m->len) memset(m->data + m->len, 0, (size_t)offset - m->len);
+    memcpy(m->data + offset, buff, size);
+    if (end > m->len) m->len = end;
+    return ARCHIVE_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Entry cache: decompressed entries and solid checkpoints kept by a handle
+// ---------------------------------------------------------------------------
+
+// Helper: Take the parked decoder for entry `index` that is furthest along
+// without having passed `offset`. Returns 0 and fills *out, or -1 if none.
+static int read_cursor_take(rar_archive_t* h, int64_t index, uint64_t offset, read_cursor* out) {
+    read_cursor* best = NULL;
+
+    rar_mutex_lock(&h->read_lock);
+    for (size_t i = 0; i < READ_CURSOR_COUNT; i++) {
+        read_cursor* c = &h->cursors[i];
+        if (!c->a || c->between || c->index != index || (uint64_t)c->from > offset) continue;
+        if (!best || c->from > best->from) best = c;
+    }
+    if (best) {
+        *out = *best;
+        memset(best, 0, sizeof(*best));
+    }
+    rar_mutex_unlock(&h->read_lock);
+    return best ? 0 : -1;
+}
+
+// Helper: Park a decoder or checkpoint, evicting the least recently used
+// one when every slot is taken
+static void read_cursor_park(rar_archive_t* h, read_cursor* c) {
+    struct archive* evicted = NULL;
+
+    rar_mutex_lock(&h->read_lock);
+    read_cursor* slot = &h->cursors[0];
+    for (size_t i = 0; i < READ_CURSOR_COUNT; i++) {
+        if (!h->cursors[i].a) {
+            slot = &h->cursors[i];
+            break;
+        }
+        if (h->cursors[i].used < slot->used) slot = &h->cursors[i];
+    }
+    evicted = slot->a;
+    *slot = *c;
+    slot->used = ++h->read_tick;
+    rar_mutex_unlock(&h->read_lock);
+
+    if (evicted) archive_read_free(evicted);
+}
+
+// Helper: Take the checkpoint closest before entry `index`. Returns 0 and
+// fills *out, or -1 if none.
+static int checkpoint_take(rar_archive_t* h, int64_t index, read_cursor* out) {
+    read_cursor* best = NULL;
+
+    rar_mutex_lock(&h->read_lock);
+    for (size_t i = 0; i < READ_CURSOR_COUNT; i++) {
+        read_cursor* c = &h->cursors[i];
+        if (!c->a || !c->between || c->index >= index) continue;
+        if (!best || c->index > best->index) best = c;
+    }
+    if (best) {
+        *out = *best;
+        memset(best, 0, sizeof(*best));
+    }
+    rar_mutex_unlock(&h->read_lock);
+    return best ? 0 : -1;
+}
+
+// Helper: Unlink a cached entry from the LRU list
+static void entry_cache_unlink(rar_archive_t* h, entry_cache_item* item) {
+    if (item->prev) item->prev->next = item->next; else h->lru_first = item->next;
+    if (item->next) item->next->prev = item->prev; else h->lru_last = item->prev;
+    item->prev = item->next = NULL;
+}
+
+// Helper: Copy up to `len` bytes at `offset` of cached entry `index` into
+// buf. Returns the item, or NULL if the entry is not cached. Call with
+// read_lock held.
+static entry_cache_item* entry_cache_copy_locked(rar_archive_t* h, int64_t index, uint64_t offset, void* buf, size_t len,
+                                                 size_t* out_read) {
+    entry_cache_item* item = h->cached ? h->cached[index] : NULL;
+    if (item) {
+        size_t n = 0;
+        if (offset < item->len) {
+            n = item->len - (size_t)offset < len ? item->len - (size_t)offset : len;
+            memcpy(buf, item->data + offset, n);
+        }
+        *out_read = n;
+    }
+    return item;
+}
+
+// Helper: entry_cache_read without counting a hit or refreshing the entry,
+// for the later parts of one read
+static int entry_cache_read_more(rar_archive_t* h, int64_t index, uint64_t offset, void* buf, size_t len, size_t* out_read) {
+    rar_mutex_lock(&h->read_lock);
+    int hit = entry_cache_copy_locked(h, index, offset, buf, len, out_read) != NULL;
+    rar_mutex_unlock(&h->read_lock);
+    return hit;
+}
+
+// Helper: Copy up to `len` bytes at `offset` of cached entry `index` into
+// buf and count a hit, or count a miss. Returns 1 on a hit, 0 on a miss.
+static int entry_cache_read(rar_archive_t* h, int64_t index, uint64_t offset, void* buf, size_t len, size_t* out_read) {
+    int hit = 0;
+
+    rar_mutex_lock(&h->read_lock);
+    entry_cache_item* item = entry_cache_copy_locked(h, index, offset, buf, len, out_read);
+    if (item) {
+        entry_cache_unlink(h, item);
+        item->next = h->lru_first;
+        if (h->lru_first) h->lru_first->prev = item;
+        h->lru_first = item;
+        if (!h->lru_last) h->lru_last = item;
+        h->cache_hits++;
+        hit = 1;
+    } else {
+        h->cache_misses++;
+    }
+    rar_mutex_unlock(&h->read_lock);
+    return hit;
+}
+
+// Helper: 1 if entry `index` is cached
+static int entry_cache_has(rar_archive_t* h, int64_t index) {
+    rar_mutex_lock(&h->read_lock);
+    int has = h->cached && h->cached[index];
+    rar_mutex_unlock(&h->read_lock);
+    return has;
+}
+
+// Helper: Add the decompressed data of entry `index` to the cache, taking
+// ownership of `data` (malloc'd, `len` bytes), and evict the least recently
+// used entries over the limit. Entries larger than the limit are not kept.
+static void entry_cache_put(rar_archive_t* h, int64_t index, unsigned char* data, size_t len) {
+    entry_cache_item* evicted = NULL;
+    uint64_t limit = h->options.entry_cache_bytes;
+
+    entry_cache_item* item = len <= limit ? malloc(sizeof(entry_cache_item)) : NULL;
+    if (!item) {
+        free(data);
+        return;
+    }
+    item->index = index;
+    item->data = data;
+    item->len = len;
+    item->prev = NULL;
+
+    rar_mutex_lock(&h->read_lock);
+    if (!h->cached) h->cached = calloc(h->count, sizeof(entry_cache_item*));
+    if (!h->cached || h->cached[index]) {
+        // No room for the table, or another thread cached it first
+        rar_mutex_unlock(&h->read_lock);
+        free(data);
+        free(item);
+        return;
+    }
+    while (h->lru_last && h->cache_bytes + len > limit) {
+        entry_cache_item* last = h->lru_last;
+        entry_cache_unlink(h, last);
+        h->cached[last->index] = NULL;
+        h->cache_bytes -= last->len;
+        last->next = evicted;
+        evicted = last;
+    }
+    item->next = h->lru_first;
+    if (h->lru_first) h->lru_first->prev = item;
+    h->lru_first = item;
+    if (!h->lru_last) h->lru_last = item;
+    h->cached[index] = item;
+    h->cache_bytes += len;
+    rar_mutex_unlock(&h->read_lock);
+
+    while (evicted) {
+        entry_cache_item* next = evicted->next;
+        free(evicted->data);
+        free(evicted);
+        evicted = next;
+    }
+}
+
+// Helper: Decompress the rest of the current entry of `a` into a new buffer
+// of the entry's exact size and add it to the cache. Returns RAR_SUCCESS or
+// the error that stopped the decoder.
+static int entry_cache_fill(rar_archive_t* h, struct archive* a, int64_t index) {
+    memory_sink_ctx m;
+    memset(&m, 0, sizeof(m));
+    m.capacity = (size_t)h->entries[index].size;
+    m.data = malloc(m.capacity ? m.capacity : 1);
+    if (!m.data) return archive_read_data_skip(a) == ARCHIVE_OK ? RAR_SUCCESS : map_archive_error(a, NULL);
+
+    if (copy_data_to(a, memory_sink, &m, NULL, NULL) != ARCHIVE_OK) {
+        free(m.data);
+        return m.error == RAR_BUFFER_TOO_SMALL ? RAR_BAD_DATA : m.error ? m.error : map_archive_error(a, NULL);
+    }
+    if (m.len == m.capacity) {
+        entry_cache_put(h, index, m.data, m.len);
+    } else {
+        free(m.data);
+    }
+    return RAR_SUCCESS;
+}
+
+// Helper: Read headers from entry `next` up to the one of entry `index`.
+// The entries passed on the way in the last quarter of the cache limit
+// before `index` are decompressed into the cache: in a solid archive
+// skipping them decompresses them anyway.
+static int solid_walk(rar_archive_t* h, struct archive* a, int64_t next, int64_t index, struct archive_entry** out_entry) {
+    uint64_t window = h->options.entry_cache_bytes / 4;
+    uint64_t kept = 0;
+    int64_t keep_from = index;
+    while (keep_from > next && kept + h->entries[keep_from - 1].size <= window) {
+        kept += h->entries[--keep_from].size;
+    }
+
+    for (int64_t i = next;; i++) {
+        struct archive_entry* entry;
+        int r = read_next_header(a, &entry, &h->options);
+        if (r != ARCHIVE_OK) return r == ARCHIVE_EOF ? RAR_ENTRY_NOT_FOUND : map_archive_error(a, NULL);
+        if (i == index) {
+            *out_entry = entry;
+            return RAR_SUCCESS;
+        }
+
+        if (i >= keep_from && h->entries[i].size > 0 && !entry_cache_has(h, i)) {
+            int result = entry_cache_fill(h, a, i);
+            if (result != RAR_SUCCESS) return result;
+        } else if (archive_read_data_skip(a) != ARCHIVE_OK) {
+            return map_archive_error(a, NULL);
+        }
+    }
+}
+
+// Helper: Position a new decoder in `c` at the data of entry `index`. With
+// the entry cache on, solid archives resume from the nearest checkpoint
+// before the entry instead of decompressing from the first one.
+static int open_at_entry_cached(rar_archive_t* h, int64_t index, read_cursor* c, struct archive_entry** out_entry) {
+    memset(c, 0, sizeof(*c));
+    c->index = index;
+    if (!h->options.entry_cache_bytes || h->solid == 0) {
+        return open_at_entry(h, index, &h->options, &c->a, out_entry, NULL);
+    }
+
+    if (checkpoint_take(h, index, c) == 0) {
+        int64_t next = c->index + 1;
+        c->index = index;
+        c->between = 0;
+        if (solid_walk(h, c->a, next, index, out_entry) == RAR_SUCCESS) {
+            const char* pathname = archive_entry_pathname(*out_entry);
+            if (pathname && strcmp(pathname, h->names + h->entries[index].name_offset) == 0) return RAR_SUCCESS;
+        }
+        // Unexpected layout; start over
+        archive_read_free(c->a);
+        c->a = NULL;
+    }
+
+    c->a = create_archive_reader(h->password);
+    if (!c->a) return RAR_MEMORY_ERROR;
+    int result = RAR_SUCCESS;
+    if (open_archive_file(c->a, h->path, &h->options) != ARCHIVE_OK) {
+        result = map_archive_error(c->a, NULL);
+    } else {
+        result = solid_walk(h, c->a, 0, index, out_entry);
+    }
+    if (result != RAR_SUCCESS) {
+        archive_read_free(c->a);
+        c->a = NULL;
+    }
+    return result;
+}
+
+// Helper: Keep a decoder that has read all of entry `c->index` as a
+// checkpoint if it can save later reads work, free it otherwise
+static void checkpoint_park(rar_archive_t* h, read_cursor* c) {
+    if (h->options.entry_cache_bytes && h->solid != 0 && (size_t)c->index + 1 < h->count) {
+        c->between = 1;
+        c->block = NULL;
+        read_cursor_park(h, c);
+    } else {
+        archive_read_free(c->a);
+    }
+}
+
+// Helper: Entry the prefetch thread should decompress next, or -1 if it is
+// far enough ahead. Called with read_lock held.
+static int64_t prefetch_pick(rar_archive_t* h) {
+    if (h->prefetch_next < 0) return -1;
+
+    // Enough entries ahead to cover one decompression at the reading pace
+    int64_t depth = 2;
+    if (h->read_interval_ns > 0 && h->decode_ns > 0) {
+        depth = h->decode_ns / h->read_interval_ns + 2;
+    }
+    if (depth > (int64_t)h->options.prefetch_entries) depth = (int64_t)h->options.prefetch_entries;
+
+    // Never let read-ahead take more than half the cache
+    uint64_t budget = h->options.entry_cache_bytes / 2;
+    uint64_t ahead = 0;
+    int64_t end = h->prefetch_next + depth;
+    if (end > (int64_t)h->count) end = (int64_t)h->count;
+    for (int64_t i = h->prefetch_next; i < end; i++) {
+        uint64_t size = h->entries[i].size;
+        if (ahead + size > budget) break;
+        ahead += size;
+        if (size == 0 || i == h->prefetch_failed || (h->cached && h->cached[i])) continue;
+        return i;
+    }
+    return -1;
+}
+
+static RAR_THREAD_RETURN prefetch_thread_main(void* arg) {
+    rar_archive_t* h = (rar_archive_t*)arg;
+
+    rar_mutex_lock(&h->read_lock);
+    while (!h->prefetch_stop) {
+        int64_t index = prefetch_pick(h);
+        if (index < 0) {
+            rar_cond_wait(&h->prefetch_cond, &h->read_lock);
+            continue;
+        }
+        h->prefetch_busy = index;
+        rar_mutex_unlock(&h->read_lock);
+
+        int64_t start = rar_monotonic_ns();
+        struct archive_entry* entry;
+        read_cursor c;
+        int result = open_at_entry_cached(h, index, &c, &entry);
+        if (result == RAR_SUCCESS) {
+            result = entry_cache_fill(h, c.a, index);
+            if (result == RAR_SUCCESS) {
+                checkpoint_park(h, &c);
+            } else {
+                archive_read_free(c.a);
+            }
+        }
+        int64_t took = rar_monotonic_ns() - start;
+
+        rar_mutex_lock(&h->read_lock);
+        h->prefetch_busy = -1;
+        if (result == RAR_SUCCESS) {
+            h->decode_ns = h->decode_ns ? (h->decode_ns * 3 + took) / 4 : took;
+        } else {
+            h->prefetch_failed = index;
+        }
+        rar_cond_broadcast(&h->prefetch_cond);
+    }
+    rar_mutex_unlock(&h->read_lock);
+    return 0;
+}
+
+// Helper: Record a read of entry `index` for the prefetch thread, starting
+// it on the first read, and wait if the thread is decompressing the entry
+static void prefetch_note_read(rar_archive_t* h, int64_t index) {
+    if (!h->options.prefetch_entries || !h->options.entry_cache_bytes) return;
+
+    int64_t now = rar_monotonic_ns();
+    rar_mutex_lock(&h->read_lock);
+    if (index == h->prefetch_next) {
+        int64_t interval = now - h->last_read_ns;
+        h->read_interval_ns = h->read_interval_ns ? (h->read_interval_ns * 3 + interval) / 4 : interval;
+    } else {
+        h->read_interval_ns = 0;  // Not sequential; start measuring again
+    }
+    h->last_read_ns = now;
+    h->prefetch_next = index + 1;
+
+    if (!h->prefetch_running && !h->prefetch_stop) {
+        if (rar_thread_create(&h->prefetch_thread, prefetch_thread_main, h) == 0) {
+            h->prefetch_running = 1;
+        } else {
+            h->prefetch_stop = 1;  // No thread; reads just decompress themselves
+        }
+    }
+    rar_cond_broadcast(&h->prefetch_cond);
+
+    while (h->prefetch_busy == index) rar_cond_wait(&h->prefetch_cond, &h->read_lock);
+    rar_mutex_unlock(&h->read_lock);
+}
+
+// Helper: Decompress entry `index` into a memory sink
+// (m->data holds at least the entry's size), through the entry cache
+static int extract_entry_to_sink(const rar_archive_t* archive, int64_t index, memory_sink_ctx* m) {
+    struct archive_entry* entry;
+    read_cursor c;
+
+    // Only the cache state changes; the index itself is unchanged
+    rar_archive_t* h = (rar_archive_t*)archive;
+    uint64_t limit = h->options.entry_cache_bytes;
+    size_t size = (size_t)h->entries[index].size;
+    prefetch_note_read(h, index);
+    if (limit && entry_cache_read(h, index, 0, m->data, size, &m->len)) return RAR_SUCCESS;
+
+    int result = open_at_entry_cached(h, index, &c, &entry);
+    if (result != RAR_SUCCESS) return result;
+
+    if (archive_entry_size(entry) > 0 || !archive_entry_size_is_set(entry)) {
+        int r = copy_data_to(c.a, memory_sink, m, NULL, NULL);
+        if (r != ARCHIVE_OK) {
+            result = m->error ? m->error : map_archive_error(c.a, NULL);
+        }
+    }
+
+    if (result == RAR_SUCCESS && size > 0 && size <= limit && m->len == size) {
+        unsigned char* copy = malloc(size);
+        if (copy) {
+            memcpy(copy, m->data, size);
+            entry_cache_put(h, index, copy, size);
+        }
+    }
+
+    if (result == RAR_SUCCESS) {
+        checkpoint_park(h, &c);
+    } else {
+        archive_read_free(c.a);
+    }
+    return result;
+}
+
+// Extract one entry into a new buffer
+RAR_EXPORT int rar_extract_entry_to_buffer(
+    const rar_archive_t* archive,
+    int64_t index,
+    void** out_data,
+    size_t* out_len
+) {
+    if (!archive || !out_data || !out_len) return RAR_UNKNOWN_ERROR;
+    *out_data = NULL;
+    *out_len = 0;
+    if (index < 0 || (size_t)index >= archive->count) return RAR_ENTRY_NOT_FOUND;
+
+    memory_sink_ctx m;
+    memset(&m, 0, sizeof(m));
+    m.growable = 1;
+    m.capacity = (size_t)archive->entries[index].size;
+    m.data = malloc(m.capacity ? m.capacity : 1);
+    if (!m.data) return RAR_MEMORY_ERROR;
+
+    int result = extract_entry_to_sink(archive, index, &m);
+    if (result != RAR_SUCCESS) {
+        free(m.data);
+        return result;
+    }
+
+    *out_data = m.data;
+    *out_len = m.len;
+    return RAR_SUCCESS;
+}
+
+// Extract one entry into a caller-supplied buffer
+RAR_EXPORT int rar_extract_entry_to_memory(
+    const rar_archive_t* archive,
+    int64_t index,
+    void* buffer,
+    size_t capacity,
+    size_t* out_len
+) {
+    if (!archive || !out_len || (!buffer && capacity > 0)) return RAR_UNKNOWN_ERROR;
+    *out_len = 0;
+    if (index < 0 || (size_t)index >= archive->count) return RAR_ENTRY_NOT_FOUND;
+
+    uint64_t size = archive->entries[index].size;
+    if (size > capacity) {
+        *out_len = (size_t)size;
+        return RAR_BUFFER_TOO_SMALL;
+    }
+
+    memory_sink_ctx m;
+    memset(&m, 0, sizeof(m));
+    m.data = (unsigned char*)buffer;
+    m.capacity = capacity;
+
+    int result = extract_entry_to_sink(archive, index, &m);
+    *out_len = result == RAR_SUCCESS ? m.len : 0;
+    return result;
+}
+
+// Adapter from data_sink to the public rar_data_callback
+typedef struct {
+    rar_data_callback cb;
+    void* user_data;
+    int stopped;            // Set once cb asked to stop
+    int64_t skip;           // Data before this offset was already passed on
+} callback_sink_ctx;
+
+static int callback_sink(void* ctx, const void* buff, size_t size, int64_t offset) {
+    callback_sink_ctx* c = (callback_sink_ctx*)ctx;
+    if (offset < c->skip) {
+        if (offset + (int64_t)size <= c->skip) return ARCHIVE_OK;
+        buff = (const unsigned char*)buff + (c->skip - offset);
+        size -= (size_t)(c->skip - offset);
+        offset = c->skip;
+    }
+    if (c->cb(buff, size, offset, c->user_data) != 0) {
+        c->stopped = 1;
+        return ARCHIVE_FATAL;
+    }
+    return ARCHIVE_OK;
+}
+
+// Stream one entry to a callback
+RAR_EXPORT int rar_stream_entry(
+    const rar_archive_t* archive,
+    int64_t index,
+    rar_data_callback data_cb,
+    void* user_data,
+    size_t chunk_hint
+) {
+    struct archive* a;
+    struct archive_entry* entry;
+
+    if (!archive || !data_cb) return RAR_UNKNOWN_ERROR;
+
+    callback_sink_ctx target = {data_cb, user_data, 0, 0};
+
+    // A cached entry is served from the cache in chunks of chunk_hint bytes
+    // (BUFFER_SIZE for raw blocks), copied out through one scratch buffer
+    rar_archive_t* h = (rar_archive_t*)archive;
+    if (index >= 0 && (size_t)index < h->count && h->entries[index].size > 0 &&
+        h->entries[index].size <= h->options.entry_cache_bytes) {
+        uint64_t size = h->entries[index].size;
+        size_t chunk = chunk_hint > 0 ? chunk_hint : BUFFER_SIZE;
+        if (chunk > size) chunk = (size_t)size;
+        unsigned char* scratch = malloc(chunk);
+        size_t n = 0;
+        prefetch_note_read(h, index);
+        if (scratch && entry_cache_read(h, index, 0, scratch, chunk, &n)) {
+            uint64_t offset = 0;
+            while (n > 0) {
+                if (callback_sink(&target, scratch, n, (int64_t)offset) != ARCHIVE_OK) break;
+                offset += n;
+                // Evicted between chunks: the decoder below passes on the rest
+                if (offset >= size || !entry_cache_read_more(h, index, offset, scratch, chunk, &n)) break;
+            }
+            free(scratch);
+            if (target.stopped) return RAR_CANCELLED;
+            if (offset >= size) return RAR_SUCCESS;
+            target.skip = (int64_t)offset;
+        } else {
+            free(scratch);
+        }
+    }
+
+    coalesce_ctx s;
+    if (coalesce_init(&s, callback_sink, &target, chunk_hint) != 0) return RAR_MEMORY_ERROR;
+
+    int result = open_at_entry(archive, index, &archive->options, &a, &entry, NULL);
+    if (result == RAR_SUCCESS) {
+        // rar_open_ex's token only covers the open; data_cb is the way to stop
+        int r = copy_data_to(a, coalesce_sink, &s, NULL, NULL);
+        if (r == ARCHIVE_OK) r = coalesce_flush(&s);
+        if (target.stopped) {
+            result = RAR_CANCELLED;
+        } else if (r != ARCHIVE_OK) {
+            result = map_archive_error(a, NULL);
+        }
+        archive_read_close(a);
+        archive_read_free(a);
+    }
+
+    coalesce_free(&s);
+    return result;
+}
+
+struct rar_flow {
+    int64_t credits;
+    int closed;
+    rar_mutex_t lock;
+    rar_cond_t changed;
+};
+
+RAR_EXPORT rar_flow_t* rar_flow_new(int64_t credits) {
+    rar_flow_t* flow = calloc(1, sizeof(rar_flow_t));
+    if (!flow) return NULL;
+    flow->credits = credits;
+    rar_mutex_init(&flow->lock);
+    rar_cond_init(&flow->changed);
+    return flow;
+}
+
+RAR_EXPORT int rar_flow_acquire(rar_flow_t* flow) {
+    if (!flow) return -1;
+    rar_mutex_lock(&flow->lock);
+    while (!flow->closed && flow->credits <= 0) rar_cond_wait(&flow->changed, &flow->lock);
+    int result = flow->closed ? -1 : 0;
+    if (result == 0) flow->credits--;
+    rar_mutex_unlock(&flow->lock);
+    return result;
+}
+
+RAR_EXPORT void rar_flow_release(rar_flow_t* flow, int64_t credits) {
+    if (!flow || credits <= 0) return;
+    rar_mutex_lock(&flow->lock);
+    flow->credits += credits;
+    rar_cond_broadcast(&flow->changed);
+    rar_mutex_unlock(&flow->lock);
+}
+
+RAR_EXPORT void rar_flow_close(rar_flow_t* flow) {
+    if (!flow) return;
+    rar_mutex_lock(&flow->lock);
+    flow->closed = 1;
+    rar_cond_broadcast(&flow->changed);
+    rar_mutex_unlock(&flow->lock);
+}
+
+RAR_EXPORT void rar_flow_free(rar_flow_t* flow) {
+    if (!flow) return;
+    rar_cond_destroy(&flow->changed);
+    rar_mutex_destroy(&flow->lock);
+    free(flow);
+}
+
+// Helper: Copy the stored data of entry `e` straight from its volume.
+// Returns RAR_SUCCESS, or RAR_UNKNOWN_FORMAT when the data is not laid out
+// as one plain run so the caller falls back to the decoder.
+static int read_stored_at(rar_archive_t* h, const index_entry* e, uint64_t offset, void* buf, size_t len, size_t* out_read) {
+    rar_mutex_lock(&h->read_lock);
+    if (h->volumes.count == 0) {
+        volume_cursor cursor;
+        if (volume_set_open(&h->volumes, &cursor, h->path, h->options.io_mode) != 0) {
+            rar_mutex_unlock(&h->read_lock);
+            return RAR_FILE_NOT_FOUND;
+        }
+        volume_cursor_close(&cursor);
+        h->read_files = calloc(h->volumes.count, sizeof(rar_file));
+        h->read_open = calloc(h->volumes.count, 1);
+        if (!h->read_files || !h->read_open) {
+            free(h->read_files);
+            free(h->read_open);
+            h->read_files = NULL;
+            h->read_open = NULL;
+            volume_set_free(&h->volumes);
+            rar_mutex_unlock(&h->read_lock);
+            return RAR_MEMORY_ERROR;
+        }
+    }
+
+    size_t v = volume_find(&h->volumes, e->data_offset);
+    const rar_volume* volume = &h->volumes.items[v];
+    int64_t local = e->data_offset - volume->begin;
+    if (local < 0 || (uint64_t)(volume->size - local) < e->size) {
+        rar_mutex_unlock(&h->read_lock);
+        return RAR_UNKNOWN_FORMAT;
+    }
+    if (!h->read_open[v]) {
+        if (rar_file_open(&h->read_files[v], volume->path, h->options.io_mode) != 0) {
+            rar_mutex_unlock(&h->read_lock);
+            return RAR_OPEN_ERROR;
+        }
+        h->read_open[v] = 1;
+    }
+    // Opened files stay until rar_close, and positioned reads share them
+    const rar_file* rf = &h->read_files[v];
+    rar_mutex_unlock(&h->read_lock);
+
+    size_t done = 0;
+    while (done < len) {
+        int64_t n = rar_file_read(rf, local + (int64_t)offset + (int64_t)done, (unsigned char*)buf + done, len - done);
+        if (n < 0) return RAR_OPEN_ERROR;
+        if (n == 0) return RAR_BAD_ARCHIVE;  // Volume shorter than its headers say
+        done += (size_t)n;
+    }
+    *out_read = done;
+    return RAR_SUCCESS;
+}
+
+// Helper: Decode entry data into buf through cursor `c`, which must not be
+// past `offset`. Holes in sparse entries read as zeros. Returns RAR_SUCCESS
+// and sets *at_end once the decoder has nothing more to give.
+static int read_decoded_at(read_cursor* c, uint64_t offset, unsigned char* buf, size_t len, size_t* out_read, int* at_end) {
+    uint64_t pos = offset;
+    uint64_t end = offset + len;
+
+    *at_end = 0;
+    for (;;) {
+        if (c->block) {
+            uint64_t block_off = (uint64_t)c->block_off;
+            uint64_t block_end = block_off + c->block_len;
+            if (block_off > pos) {
+                uint64_t stop = block_off < end ? block_off : end;
+                memset(buf + (pos - offset), 0, (size_t)(stop - pos));
+                pos = stop;
+            }
+            if (pos < end && block_end > pos) {
+                uint64_t stop = block_end < end ? block_end : end;
+                memcpy(buf + (pos - offset), (const unsigned char*)c->block + (pos - block_off), (size_t)(stop - pos));
+                pos = stop;
+            }
+            // Keep a block that may still hold data for the next read;
+            // `from` stays at the end of the one before it
+            if (pos >= end) break;
+            c->from = (int64_t)block_end;
+            c->block = NULL;
+        }
+
+        int r = archive_read_data_block(c->a, &c->block, &c->block_len, &c->block_off);
+        if (r == ARCHIVE_EOF) {
+            c->block = NULL;
+            *at_end = 1;
+            break;
+        }
+        if (r < ARCHIVE_WARN) {
+            c->block = NULL;
+            return map_archive_error(c->a, NULL);
+        }
+    }
+
+    *out_read = (size_t)(pos - offset);
+    return RAR_SUCCESS;
+}
+
+// Read part of an entry without extracting the rest of it
+RAR_EXPORT int rar_read_at(
+    const rar_archive_t* archive,
+    int64_t index,
+    uint64_t offset,
+    void* buffer,
+    size_t len,
+    size_t* out_read
+) {
+    if (!archive || !out_read || (len > 0 && !buffer)) return RAR_UNKNOWN_ERROR;
+    *out_read = 0;
+    if (index < 0 || (size_t)index >= archive->count) return RAR_ENTRY_NOT_FOUND;
+
+    // The read state is internal to the handle; the index itself is unchanged
+    rar_archive_t* h = (rar_archive_t*)archive;
+    const index_entry* e = &h->entries[index];
+
+    if (offset >= e->size || len == 0) return RAR_SUCCESS;
+    if (e->size - offset < (uint64_t)len) len = (size_t)(e->size - offset);
+
+    uint32_t direct = RAR_ENTRY_ENCRYPTED | RAR_ENTRY_SPLIT_BEFORE | RAR_ENTRY_SPLIT_AFTER;
+    if ((e->flags & RAR_ENTRY_STORED) && !(e->flags & direct) &&
+        e->data_offset >= 0 && e->packed_size == e->size) {
+        int result = read_stored_at(h, e, offset, buffer, len, out_read);
+        if (result != RAR_UNKNOWN_FORMAT) return result;
+    }
+
+    if (offset == 0) prefetch_note_read(h, index);
+    if (h->options.entry_cache_bytes && entry_cache_read(h, index, offset, buffer, len, out_read)) {
+        return RAR_SUCCESS;
+    }
+
+    read_cursor c;
+    if (read_cursor_take(h, index, offset, &c) != 0) {
+        struct archive_entry* entry;
+        int result = open_at_entry_cached(h, index, &c, &entry);
+        if (result != RAR_SUCCESS) return result;
+    }
+
+    int at_end = 0;
+    int result = read_decoded_at(&c, offset, buffer, len, out_read, &at_end);
+
+    // A sparse entry may end in a hole the decoder never reports
+    if (result == RAR_SUCCESS && at_end && *out_read < len) {
+        memset((unsigned char*)buffer + *out_read, 0, len - *out_read);
+        *out_read = len;
+    }
+
+    if (result == RAR_SUCCESS && !at_end) {
+        read_cursor_park(h, &c);
+    } else if (result == RAR_SUCCESS) {
+        checkpoint_park(h, &c);
+    } else {
+        archive_read_free(c.a);
+    }
+    return result;
+}
+
+// Free a buffer allocated by this library
+RAR_EXPORT void rar_buffer_free(void* data) {
+    free(data);
+}
@@ -14,6 +14,7 @@
 #ifndef RAR_NATIVE_H
 #define RAR_NATIVE_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef _WIN32
@@ -41,11 +42,322 @@ extern "C" {
 #define RAR_BAD_PASSWORD     7
 #define RAR_BAD_DATA         8
 #define RAR_UNKNOWN_ERROR    9
+#define RAR_ENTRY_NOT_FOUND  10
+#define RAR_BUFFER_TOO_SMALL 11
+#define RAR_CANCELLED        12
+
+// Entry flags reported in rar_entry_info.flags
+#define RAR_ENTRY_DIRECTORY     0x0001
+#define RAR_ENTRY_ENCRYPTED     0x0002
+#define RAR_ENTRY_SOLID         0x0004
+#define RAR_ENTRY_STORED        0x0008
+#define RAR_ENTRY_SPLIT_BEFORE  0x0010
+#define RAR_ENTRY_SPLIT_AFTER   0x0020
+#define RAR_ENTRY_HAS_CRC       0x0040
+
+// Archive flags reported in rar_probe_info.flags
+#define RAR_ARCHIVE_SOLID             0x0001
+#define RAR_ARCHIVE_VOLUME            0x0002   // Part of a multi-volume set
+#define RAR_ARCHIVE_ENCRYPTED_HEADERS 0x0004   // Names need the password
+#define RAR_ARCHIVE_RECOVERY_RECORD   0x0008
+#define RAR_ARCHIVE_LOCKED            0x0010
+
+// Job types for rar_batch_submit
+#define RAR_JOB_LIST     0
+#define RAR_JOB_EXTRACT  1
+
+// I/O modes reported in rar_options.io_mode
+#define RAR_IO_AUTO  0   // Memory-map the archive when possible, read otherwise
+#define RAR_IO_READ  1   // Always read through a buffer of read_block_size bytes
+
+// How extracted files are written, see rar_options.write_mode
+#define RAR_WRITE_FAITHFUL  0   // Restore times, permissions, ACLs, file flags and owners
+#define RAR_WRITE_FAST      1   // Times and permissions only; files written directly
 
 // Callback types
 typedef void (*rar_list_callback)(const char* filename);
 typedef void (*rar_error_callback)(const char* error);
 
+// Receives decompressed entry data. `data` is only valid during the call.
+// Return 0 to continue, anything else to stop (RAR_CANCELLED is returned).
+typedef int (*rar_data_callback)(
+    const void* data,
+    size_t size,
+    int64_t offset,
+    void* user_data
+);
+
+// Reports extraction progress. Counters are cumulative for the operation;
+// totals are -1 when unknown (one-shot extraction does not pre-scan the
+// archive). `entry_name` is only valid during the call, so callbacks that
+// are delivered asynchronously should rely on `entry_index` instead.
+typedef void (*rar_progress_callback)(
+    int64_t entries_done,
+    int64_t entries_total,
+    int64_t bytes_in,         // Packed bytes consumed
+    int64_t bytes_out,        // Unpacked bytes written
+    int64_t bytes_total,      // Unpacked bytes expected
+    int64_t entry_index,      // Entry being extracted, -1 for the final report
+    const char* entry_name,   // Its path inside the archive, NULL if none
+    void* user_data
+);
+
+// Opaque handle to an opened archive and its parsed entry index
+typedef struct rar_archive rar_archive_t;
+
+// Opaque cancellation flag shared between a caller and running operations
+typedef struct rar_cancel_token rar_cancel_token_t;
+
+// Opaque on-disk cache of parsed entry indexes, see rar_index_cache_open
+typedef struct rar_index_cache rar_index_cache_t;
+
+// Multi-volume archives: every function taking a `rar_path` accepts any
+// volume of a set named name.part1.rar, name.part2.rar, ... or name.rar,
+// name.r00, name.r01, .... The other volumes are found by name and opened
+// only when reading reaches them; offsets then count from the start of the
+// first volume, as if the volumes were one file.
+
+// Metadata for one archive entry. Offsets are -1 when the raw header could
+// not be parsed (for example when headers are encrypted).
+typedef struct {
+    const char* name;         // UTF-8 path inside the archive, owned by the handle
+    uint64_t size;            // Unpacked size in bytes
+    uint64_t packed_size;     // Packed size in bytes (this volume)
+    int64_t mtime;            // Modification time, seconds since the epoch
+    int64_t header_offset;    // Offset of the entry's file header block (across volumes)
+    int64_t data_offset;      // Offset of the entry's packed data (across volumes)
+    uint32_t crc32;           // CRC32 of the unpacked data (if RAR_ENTRY_HAS_CRC)
+    uint32_t mode;            // POSIX file type and permission bits
+    uint32_t flags;           // RAR_ENTRY_* flags
+} rar_entry_info;
+
+// Archive properties read from its first few KB by rar_probe. With
+// RAR5 encrypted headers only the version and that flag are known.
+typedef struct {
+    int version;              // 4 or 5, 0 if the file is not a RAR archive
+    uint32_t flags;           // RAR_ARCHIVE_* flags
+    int64_t volume_index;     // 0 for the first (or only) volume, -1 if unknown
+    int64_t entry_count;      // Files and directories, -1 if not cheaply known
+    int64_t file_size;        // Size of the file in bytes
+} rar_probe_info;
+
+// Where the time of list and extract calls went, see rar_options.stats.
+// Times are nanoseconds summed over every thread taking part, so parallel
+// and pipelined extraction can report more than the elapsed time. CRC
+// checks happen inside libarchive's reads and count towards read_ns.
+typedef struct {
+    int64_t header_ns;        // archive_read_next_header, including skipping unread data
+    int64_t read_ns;          // archive_read_data_block: decompression and CRC checks
+    int64_t create_ns;        // archive_write_header, or creating the file in RAR_WRITE_FAST
+    int64_t write_ns;         // archive_write_data_block, or writes in RAR_WRITE_FAST
+    int64_t finish_ns;        // archive_write_finish_entry: times, permissions, metadata
+    int64_t mkdir_ns;         // Creating the parent directories of entries
+    int64_t headers;          // Headers read; parallel readers each read their own
+    int64_t entries_written;  // Entries extracted
+    int64_t bytes_decoded;    // Unpacked bytes returned by the reader
+    int64_t bytes_written;    // Bytes written to extracted files
+    int64_t cache_hits;       // Entry reads served by a handle's entry cache
+    int64_t cache_misses;     // Entry reads the entry cache had to decompress
+} rar_stats;
+
+// Which entries extraction to disk writes, see rar_options.filter. Paths
+// are matched as stored in the archive, without the destination. Glob
+// patterns: `*` and `?` stay within one path component, `**` spans any
+// number of them ("**/" also matches none), `[a-z]` and `[!a-z]` are sets
+// and `\` quotes the next character. A pattern without a '/' matches the
+// last component ("*.jpg" matches "photos/a.jpg"), any other the whole
+// path. An entry is written when it is below `prefix`, has a size in the
+// range (directories always do), matches an include pattern (or there are
+// none) and matches no exclude pattern.
+typedef struct {
+    const char* const* include;   // NULL if include_count is 0
+    size_t include_count;
+    const char* const* exclude;   // NULL if exclude_count is 0
+    size_t exclude_count;
+    const char* prefix;           // "photos" covers "photos/..." but not "photos2"; NULL = any
+    uint64_t min_size;            // Unpacked bytes
+    uint64_t max_size;            // 0 = no upper limit
+} rar_filter;
+
+// Tuning knobs for reading archives and writing extracted files. Initialise
+// with rar_options_init; a NULL options pointer means the defaults.
+typedef struct {
+    int io_mode;              // RAR_IO_*
+    size_t read_block_size;   // Bytes per archive read, 0 = pick automatically
+    size_t write_buffer_size; // Bytes buffered per output write, 0 = automatic
+
+    // Extraction progress, reported at most once per interval plus a final
+    // report when the operation ends. Callbacks may come from worker threads.
+    rar_progress_callback progress_cb;
+    void* progress_user_data;
+    uint32_t progress_interval_ms;  // 0 = 100 ms
+
+    // Checked before every header and every data block; NULL = not cancellable
+    rar_cancel_token_t* cancel_token;
+
+    // Blocks of write_buffer_size bytes in flight between decompression and
+    // a separate writer thread, 0 = decompress and write on one thread.
+    // Applies to sequential and single-entry extraction; parallel
+    // extraction already overlaps the two across its workers.
+    uint32_t pipeline_blocks;
+
+    // RAR_WRITE_FAST skips ACLs, file flags and owner lookups, and writes
+    // regular files through its own descriptors, preallocated to the entry
+    // size. Directories, links and special files are written as usual.
+    int write_mode;
+
+    // Entry indexes saved by earlier opens of the same unchanged archive;
+    // used by rar_open_ex, rar_list_ex and list jobs. NULL = always parse
+    // the headers.
+    rar_index_cache_t* index_cache;
+
+    // Counters added to by the call (zero them first), from any of its
+    // threads; must stay valid until the call, or an asynchronous batch,
+    // completes. Handles only use the stats passed to each call. NULL = not
+    // measured; builds with RAR_NO_STATS never touch them.
+    rar_stats* stats;
+
+    // Decompressed entries a handle opened with these options keeps in
+    // memory for rar_extract_entry_to_buffer, rar_extract_entry_to_memory
+    // and rar_read_at, least recently used dropped first. In solid archives
+    // the handle also keeps decoders that stopped after an entry as
+    // checkpoints (four at most, shared with rar_read_at), so a later entry
+    // resumes from the nearest one. 0 = no cache.
+    uint64_t entry_cache_bytes;
+
+    // Entries a background thread of the handle decompresses into the entry
+    // cache ahead of the last one read, at most; it goes as deep as needed
+    // to keep up with the reading pace and uses at most half the cache.
+    // Reads of an entry it is decompressing wait for it. rar_stream_entry
+    // also serves entries from the cache. Needs entry_cache_bytes; 0 = off.
+    uint32_t prefetch_entries;
+
+    // Entries every extraction to disk skips, before anything is created
+    // for them; skipped data is seeked over outside solid archives. Progress
+    // totals of handle extraction count only the entries that pass. Handles
+    // do not keep it from rar_open_ex; pass it to each call. NULL = every
+    // entry.
+    const rar_filter* filter;
+
+    // Workers rar_extract_all_ex starts for non-solid archives, each with its
+    // own reader; 1 extracts on the calling thread as rar_extract does. Set
+    // it when several extractions run at once, so that the threads stay
+    // bounded. 0 = one per CPU core.
+    uint32_t extract_threads;
+} rar_options;
+
+/**
+ * Fill `options` with the defaults: automatic I/O mode and sizes, and no
+ * progress callback.
+ *
+ * Automatic sizes scale with the archive size (roughly 1/64th of it, between
+ * 16 KB and 4 MB) and are never smaller than the file system's preferred
+ * block size (st_blksize) of the archive or destination directory.
+ */
+RAR_EXPORT void rar_options_init(rar_options* options);
+
+/**
+ * 1 if rar_options.stats is filled in, 0 if the library was built with
+ * RAR_NO_STATS.
+ */
+RAR_EXPORT int rar_stats_enabled(void);
+
+// One archive to process in a batch. Strings are UTF-8 and must stay valid
+// until the batch completes.
+typedef struct {
+    int type;                 // RAR_JOB_*
+    const char* rar_path;
+    const char* dest_path;    // RAR_JOB_EXTRACT only
+    const char* password;     // NULL if none
+} rar_job;
+
+// Outcome of one batch job, written when the job finishes
+typedef struct {
+    int code;                 // RAR_* result of the job
+    int64_t entry_count;      // Entries listed or extracted
+    char* names;              // RAR_JOB_LIST: entry names, each NUL-terminated,
+                              // back to back; free with rar_batch_results_free
+    size_t names_len;         // Bytes in `names`, including the terminators
+} rar_job_result;
+
+// Called once when every job of a batch has finished
+typedef void (*rar_batch_callback)(
+    size_t job_count,
+    size_t failed_count,      // Jobs whose code is not RAR_SUCCESS
+    void* user_data
+);
+
+/**
+ * Create a cancellation token for use in rar_options.cancel_token.
+ *
+ * @return A new token, or NULL if allocation failed. Free with
+ *         rar_cancel_token_free once no operation is using it.
+ */
+RAR_EXPORT rar_cancel_token_t* rar_cancel_token_new(void);
+
+/**
+ * Ask every operation using `token` to stop. Safe to call from any thread,
+ * any number of times.
+ *
+ * Cancelled operations return RAR_CANCELLED. The file being written when
+ * the cancellation is noticed is removed; entries that were already
+ * complete are left in place.
+ */
+RAR_EXPORT void rar_cancel(rar_cancel_token_t* token);
+
+/**
+ * @return 1 if rar_cancel has been called on `token`, 0 otherwise
+ */
+RAR_EXPORT int rar_is_cancelled(const rar_cancel_token_t* token);
+
+/**
+ * Free a token created by rar_cancel_token_new. NULL is ignored.
+ */
+RAR_EXPORT void rar_cancel_token_free(rar_cancel_token_t* token);
+
+/**
+ * Open (creating it if needed) a directory of saved entry indexes for use in
+ * rar_options.index_cache.
+ *
+ * Each archive path has one file in the directory holding its parsed entry
+ * table. It is used instead of the headers as long as the archive's size,
+ * modification time and first 4 KB are unchanged (for multi-volume sets:
+ * the total size, the latest time of any volume and the first volume's
+ * first 4 KB); otherwise it is rebuilt on the next open. Archives with
+ * encrypted headers are never cached. Paths are compared as given, so an
+ * archive reached through different paths is cached once per path.
+ *
+ * The cache may be shared by any number of threads and operations, and by
+ * several processes, but must outlive every operation using it.
+ *
+ * @param dir Cache directory (UTF-8 encoded)
+ * @param max_bytes Size limit of the directory's index files, 0 for none;
+ *                  the least recently used files are removed beyond it
+ * @param out_cache Receives the cache (release with rar_index_cache_close)
+ * @return RAR_SUCCESS, RAR_CREATE_ERROR if the directory cannot be created,
+ *         or RAR_MEMORY_ERROR
+ */
+RAR_EXPORT int rar_index_cache_open(const char* dir, uint64_t max_bytes, rar_index_cache_t** out_cache);
+
+/**
+ * Change the size limit of a cache (0 for none), removing the least
+ * recently used index files until the directory fits.
+ */
+RAR_EXPORT void rar_index_cache_set_limit(rar_index_cache_t* cache, uint64_t max_bytes);
+
+/**
+ * Remove the saved index of `rar_path`, or of every archive if `rar_path`
+ * is NULL. Missing entries are not an error.
+ *
+ * @return RAR_SUCCESS, or RAR_MEMORY_ERROR
+ */
+RAR_EXPORT int rar_index_cache_invalidate(rar_index_cache_t* cache, const char* rar_path);
+
+/**
+ * Release a cache handle; the directory and its files stay. Accepts NULL.
+ */
+RAR_EXPORT void rar_index_cache_close(rar_index_cache_t* cache);
+
 /**
  * Extract all files from a RAR archive to a destination directory.
  *
@@ -62,6 +374,116 @@ RAR_EXPORT int rar_extract(
     rar_error_callback error_cb
 );
 
+/**
+ * Same as rar_extract, with explicit I/O options (NULL for the defaults).
+ */
+RAR_EXPORT int rar_extract_ex(
+    const char* rar_path,
+    const char* dest_path,
+    const char* password,
+    const rar_options* options,
+    rar_error_callback error_cb
+);
+
+/**
+ * Extract all files from a RAR archive using several worker threads.
+ *
+ * Each worker opens its own reader and disk writer; entries are handed out
+ * dynamically so that idle workers pick up the next unstarted entry. Solid
+ * archives (and archives whose layout cannot be determined) are extracted
+ * sequentially, exactly as rar_extract does.
+ *
+ * Multi-volume archives are handed out a volume at a time instead: a worker
+ * extracts the entries whose first header lies in its volume, reading from
+ * the first of them, and entries are numbered for progress in the order
+ * they are started.
+ *
+ * @param rar_path Path to the RAR archive file (UTF-8 encoded)
+ * @param dest_path Path to the destination directory (UTF-8 encoded)
+ * @param password Optional password for encrypted archives (UTF-8, NULL if none)
+ * @param num_threads Number of workers (<= 0 uses the number of CPU cores)
+ * @param error_cb Callback for error messages (can be NULL); called at most
+ *        once, on the calling thread after the workers have finished
+ * @return RAR_SUCCESS on success, error code of the first failure otherwise
+ */
+RAR_EXPORT int rar_extract_parallel(
+    const char* rar_path,
+    const char* dest_path,
+    const char* password,
+    int num_threads,
+    rar_error_callback error_cb
+);
+
+// One damaged entry found by rar_test
+typedef struct {
+    int64_t index;            // Position of the entry in the archive
+    int code;                 // RAR_BAD_DATA, or RAR_BAD_PASSWORD if it could not be decrypted
+    char* name;               // UTF-8 path inside the archive, owned by the report
+    char* message;            // libarchive's description, owned by the report (may be NULL)
+} rar_test_failure;
+
+// Outcome of rar_test; release with rar_test_report_free
+typedef struct {
+    int64_t entries_tested;   // Entries decompressed, damaged ones included
+    size_t failure_count;
+    rar_test_failure* failures;  // Sorted by index
+} rar_test_report;
+
+/**
+ * Decompress every entry of an archive and check it against its stored
+ * CRC32 without writing anything. Split and encrypted entries, and RAR5
+ * entries hashed with BLAKE2sp instead, rely on libarchive's own checks,
+ * which cover compressed data only. The CRC32 is computed with PCLMULQDQ or
+ * the ARMv8 CRC instructions where the CPU has them.
+ *
+ * Non-solid archives are tested by several workers, each with its own
+ * reader, claiming entries as rar_extract_parallel does; a worker that meets
+ * a damaged entry reopens its reader and carries on with the next one.
+ * Solid archives are tested in order, and testing stops at the first entry
+ * that cannot be decoded, since every later entry depends on it.
+ *
+ * Progress counts decompressed bytes as written; cancellation and stats
+ * work as for extraction.
+ *
+ * @param rar_path Path to the RAR archive file (UTF-8 encoded)
+ * @param password Optional password for encrypted archives (UTF-8, NULL if none)
+ * @param num_threads Number of workers (<= 0 uses the number of CPU cores)
+ * @param options I/O options (NULL for the defaults)
+ * @param report Receives the damaged entries; filled in whatever the result
+ * @param error_cb Callback for error messages (can be NULL); called at most
+ *        once, on the calling thread after the workers have finished
+ * @return RAR_SUCCESS if every entry is intact, RAR_BAD_DATA if `report`
+ *         lists damaged entries, another error code if the archive itself
+ *         could not be read
+ */
+RAR_EXPORT int rar_test(
+    const char* rar_path,
+    const char* password,
+    int num_threads,
+    const rar_options* options,
+    rar_test_report* report,
+    rar_error_callback error_cb
+);
+
+/**
+ * Free the failures held by a rar_test report (not the report itself).
+ */
+RAR_EXPORT void rar_test_report_free(rar_test_report* report);
+
+/**
+ * Read an archive's signature and main header without opening it for
+ * extraction. Reads at most a few KB, so it suits filtering large numbers of
+ * files. The entry count is only filled in when every header fits in the
+ * bytes read (small archives with unencrypted headers).
+ *
+ * @param rar_path Path to the archive file (UTF-8 encoded)
+ * @param info Receives what could be determined, even on failure
+ * @return RAR_SUCCESS, RAR_FILE_NOT_FOUND if the file cannot be opened,
+ *         RAR_UNKNOWN_FORMAT without a RAR signature, or RAR_BAD_ARCHIVE if
+ *         the main header is damaged
+ */
+RAR_EXPORT int rar_probe(const char* rar_path, rar_probe_info* info);
+
 /**
  * List all files in a RAR archive.
  *
@@ -78,6 +500,356 @@ RAR_EXPORT int rar_list(
     rar_error_callback error_cb
 );
 
+/**
+ * Same as rar_list, with explicit I/O options (NULL for the defaults).
+ */
+RAR_EXPORT int rar_list_ex(
+    const char* rar_path,
+    const char* password,
+    const rar_options* options,
+    rar_list_callback list_cb,
+    rar_error_callback error_cb
+);
+
+/**
+ * Run many list/extract jobs on a pool of native threads.
+ *
+ * Each worker thread claims jobs in order and keeps its disk writer and
+ * write buffer across the jobs it runs. The result of jobs[i] is stored in
+ * results[i]. Progress callbacks in `options` are ignored; the cancel token
+ * and I/O settings apply to every job.
+ *
+ * With a NULL `done_cb` the call blocks until all jobs are done. Otherwise
+ * it returns once the jobs are queued and `done_cb` runs on a worker thread
+ * (or the calling thread) after the last one finishes; `jobs`, their
+ * strings and `results` must stay valid until then.
+ *
+ * @param jobs Jobs to run
+ * @param count Number of jobs
+ * @param num_threads Number of worker threads (0 = number of CPUs)
+ * @param options I/O options and cancel token (NULL for the defaults)
+ * @param results Array of `count` results, filled in as jobs finish
+ * @param done_cb Completion callback, or NULL to wait for the batch
+ * @param user_data Passed to done_cb
+ * @return RAR_SUCCESS once the batch has run (blocking) or started; the
+ *         outcome of each job is in `results`
+ */
+RAR_EXPORT int rar_batch_submit(
+    const rar_job* jobs,
+    size_t count,
+    int num_threads,
+    const rar_options* options,
+    rar_job_result* results,
+    rar_batch_callback done_cb,
+    void* user_data
+);
+
+/**
+ * Free the name lists of `count` batch results (not the array itself).
+ */
+RAR_EXPORT void rar_batch_results_free(rar_job_result* results, size_t count);
+
+/**
+ * Open a RAR archive and parse all entry headers into an in-memory index.
+ *
+ * The returned handle keeps the index for its whole lifetime, so listing and
+ * stat calls never touch the archive again. The handle is safe to use from
+ * several threads at once.
+ *
+ * @param rar_path Path to the RAR archive file (UTF-8 encoded)
+ * @param password Optional password for encrypted archives (UTF-8, NULL if none)
+ * @param out_archive Receives the handle on success (release with rar_close)
+ * @param error_cb Callback for error messages (can be NULL)
+ * @return RAR_SUCCESS on success, error code on failure
+ */
+RAR_EXPORT int rar_open(
+    const char* rar_path,
+    const char* password,
+    rar_archive_t** out_archive,
+    rar_error_callback error_cb
+);
+
+/**
+ * Same as rar_open, with explicit I/O options (NULL for the defaults). The
+ * options are copied into the handle and apply to every later call on it.
+ */
+RAR_EXPORT int rar_open_ex(
+    const char* rar_path,
+    const char* password,
+    const rar_options* options,
+    rar_archive_t** out_archive,
+    rar_error_callback error_cb
+);
+
+/**
+ * Close an archive handle and free its index. Accepts NULL.
+ */
+RAR_EXPORT void rar_close(rar_archive_t* archive);
+
+/**
+ * Fill `stats` with the counters a handle keeps across calls: the entry
+ * cache hits and misses (see rar_options.entry_cache_bytes). The other
+ * fields are zero.
+ */
+RAR_EXPORT void rar_archive_stats(const rar_archive_t* archive, rar_stats* stats);
+
+/**
+ * Number of entries in the archive index.
+ */
+RAR_EXPORT int64_t rar_entry_count(const rar_archive_t* archive);
+
+/**
+ * Fill metadata for the entry at `index`.
+ *
+ * @return RAR_SUCCESS, or RAR_ENTRY_NOT_FOUND if index is out of range
+ */
+RAR_EXPORT int rar_stat(
+    const rar_archive_t* archive,
+    int64_t index,
+    rar_entry_info* info
+);
+
+/**
+ * Look up an entry by its exact path inside the archive.
+ *
+ * @return The entry index, or -1 if no entry has that name
+ */
+RAR_EXPORT int64_t rar_find_entry(const rar_archive_t* archive, const char* name);
+
+/**
+ * Copy metadata for a page of entries into a caller-supplied array.
+ *
+ * Entries are written as contiguous fixed-layout structs; their `name`
+ * pointers reference one packed string arena owned by the handle, so no
+ * per-entry allocation or callback is involved. Call repeatedly with an
+ * increasing `start` to page through large archives.
+ *
+ * @param archive Handle returned by rar_open
+ * @param start Index of the first entry to copy
+ * @param out Destination array with room for max_entries structs
+ * @param max_entries Page size
+ * @param out_count Receives the number of entries written (0 at the end)
+ * @return RAR_SUCCESS on success, error code on failure
+ */
+RAR_EXPORT int rar_list_batch(
+    const rar_archive_t* archive,
+    int64_t start,
+    rar_entry_info* out,
+    size_t max_entries,
+    size_t* out_count
+);
+
+/**
+ * Report every entry name from the index (no archive I/O).
+ *
+ * @return RAR_SUCCESS
+ */
+RAR_EXPORT int rar_list_entries(
+    const rar_archive_t* archive,
+    rar_list_callback list_cb
+);
+
+/**
+ * Expose the handle's name arena: the name of every entry in index order,
+ * each NUL-terminated, back to back. Nothing is copied; the bytes stay
+ * owned by the handle and valid until rar_close.
+ *
+ * @param archive Handle returned by rar_open
+ * @param out_names Receives the first name (NULL for an empty archive)
+ * @param out_len Receives the number of bytes, including the terminators
+ * @return RAR_SUCCESS, or RAR_UNKNOWN_ERROR if an argument is NULL
+ */
+RAR_EXPORT int rar_entry_names(
+    const rar_archive_t* archive,
+    const char** out_names,
+    size_t* out_len
+);
+
+/**
+ * Extract all entries of an opened archive to a destination directory.
+ *
+ * @return RAR_SUCCESS on success, error code on failure
+ */
+RAR_EXPORT int rar_extract_all(
+    const rar_archive_t* archive,
+    const char* dest_path,
+    rar_error_callback error_cb
+);
+
+/**
+ * Same as rar_extract_all, with options for this call only (NULL uses the
+ * options the handle was opened with).
+ */
+RAR_EXPORT int rar_extract_all_ex(
+    const rar_archive_t* archive,
+    const char* dest_path,
+    const rar_options* options,
+    rar_error_callback error_cb
+);
+
+/**
+ * Extract a single entry of an opened archive to a destination directory.
+ * Reading stops as soon as the entry has been written.
+ *
+ * @return RAR_SUCCESS on success, error code on failure
+ */
+RAR_EXPORT int rar_extract_entry(
+    const rar_archive_t* archive,
+    int64_t index,
+    const char* dest_path,
+    rar_error_callback error_cb
+);
+
+/**
+ * Same as rar_extract_entry, with options for this call only (NULL uses the
+ * options the handle was opened with).
+ */
+RAR_EXPORT int rar_extract_entry_ex(
+    const rar_archive_t* archive,
+    int64_t index,
+    const char* dest_path,
+    const rar_options* options,
+    rar_error_callback error_cb
+);
+
+/**
+ * Decompress a single entry into a newly allocated buffer.
+ *
+ * No files are written. On non-solid archives the reader jumps straight to
+ * the entry's header instead of scanning the entries before it.
+ *
+ * @param archive Handle returned by rar_open
+ * @param index Entry index (see rar_find_entry to look up by name)
+ * @param out_data Receives the buffer; release it with rar_buffer_free
+ * @param out_len Receives the number of bytes in the buffer
+ * @return RAR_SUCCESS on success, error code on failure
+ */
+RAR_EXPORT int rar_extract_entry_to_buffer(
+    const rar_archive_t* archive,
+    int64_t index,
+    void** out_data,
+    size_t* out_len
+);
+
+/**
+ * Decompress a single entry into a caller-supplied buffer.
+ *
+ * @param archive Handle returned by rar_open
+ * @param index Entry index
+ * @param buffer Destination buffer
+ * @param capacity Size of the destination buffer in bytes
+ * @param out_len Receives the entry size; on RAR_BUFFER_TOO_SMALL it holds
+ *                the capacity required and nothing is decompressed
+ * @return RAR_SUCCESS on success, error code on failure
+ */
+RAR_EXPORT int rar_extract_entry_to_memory(
+    const rar_archive_t* archive,
+    int64_t index,
+    void* buffer,
+    size_t capacity,
+    size_t* out_len
+);
+
+/**
+ * Stream the decompressed data of a single entry to a callback.
+ *
+ * With chunk_hint == 0 every block produced by the decompressor is passed
+ * straight through without copying. With a non-zero hint, blocks smaller
+ * than the hint are coalesced so the callback sees chunks of at least
+ * chunk_hint bytes (except the last one); larger blocks still pass through
+ * uncopied.
+ *
+ * @param archive Handle returned by rar_open
+ * @param index Entry index
+ * @param data_cb Callback receiving (data, size, offset, user_data)
+ * @param user_data Opaque pointer passed to data_cb
+ * @param chunk_hint Minimum chunk size in bytes, or 0 for raw blocks
+ * @return RAR_SUCCESS on success, RAR_CANCELLED if data_cb stopped it,
+ *         another error code on failure
+ *
+ * data_cb stops the stream by returning non-zero. To bound the chunks a
+ * slow consumer on another thread has not taken yet, data_cb can wait on a
+ * rar_flow_t before handing each one over.
+ */
+RAR_EXPORT int rar_stream_entry(
+    const rar_archive_t* archive,
+    int64_t index,
+    rar_data_callback data_cb,
+    void* user_data,
+    size_t chunk_hint
+);
+
+// Credits between a producer and a consumer on different threads, such as
+// rar_stream_entry's data_cb and the thread that takes its chunks
+typedef struct rar_flow rar_flow_t;
+
+/**
+ * Create a flow holding `credits` credits (the chunks allowed in flight).
+ *
+ * @return A new flow, or NULL if allocation failed. Free with rar_flow_free
+ *         once neither side uses it.
+ */
+RAR_EXPORT rar_flow_t* rar_flow_new(int64_t credits);
+
+/**
+ * Take one credit, waiting while there are none.
+ *
+ * @return 0 once a credit was taken, -1 if the flow is closed
+ */
+RAR_EXPORT int rar_flow_acquire(rar_flow_t* flow);
+
+/**
+ * Return `credits` credits, waking a waiting rar_flow_acquire. Safe to call
+ * from any thread.
+ */
+RAR_EXPORT void rar_flow_release(rar_flow_t* flow, int64_t credits);
+
+/**
+ * Close the flow: rar_flow_acquire fails from now on, also when waiting.
+ * Safe to call from any thread, any number of times.
+ */
+RAR_EXPORT void rar_flow_close(rar_flow_t* flow);
+
+/**
+ * Free a flow created by rar_flow_new. NULL is ignored.
+ */
+RAR_EXPORT void rar_flow_free(rar_flow_t* flow);
+
+/**
+ * Read part of a single entry's decompressed data.
+ *
+ * Stored entries that are neither encrypted nor split across volumes are
+ * read straight from the archive file, so any offset costs the same.
+ * Other entries are decompressed from the start up to `offset`; the
+ * decoder is then kept on the handle (up to four at a time, least recently
+ * used dropped first) so a later read at or past where this one stopped
+ * resumes instead of starting over. Reading backwards starts over.
+ *
+ * Safe to call from several threads on the same handle.
+ *
+ * @param archive Handle returned by rar_open
+ * @param index Entry index
+ * @param offset Offset into the entry's data
+ * @param buffer Destination buffer
+ * @param len Number of bytes to read
+ * @param out_read Receives the number of bytes read: `len`, fewer at the end
+ *                 of the entry, 0 at or past it
+ * @return RAR_SUCCESS on success, error code on failure
+ */
+RAR_EXPORT int rar_read_at(
+    const rar_archive_t* archive,
+    int64_t index,
+    uint64_t offset,
+    void* buffer,
+    size_t len,
+    size_t* out_read
+);
+
+/**
+ * Free a buffer returned by rar_extract_entry_to_buffer. Accepts NULL.
+ */
+RAR_EXPORT void rar_buffer_free(void* data);
+
 /**
  * Get a human-readable error message for an error code.
  *
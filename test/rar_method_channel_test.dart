@@ -0,0 +1,131 @@
+// test/rar_method_channel_test.dart
+//
+// Unit tests for the job API of the method channel implementation, against
+// mocked method and event channels as the desktop plugins use them.
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:rar/src/rar_method_channel.dart';
+
+const _channel = MethodChannel('com.lkrjangid.rar');
+const _eventsName = 'com.lkrjangid.rar/events';
+const _codec = StandardMethodCodec();
+
+TestDefaultBinaryMessenger get _messenger =>
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+
+// Sends `event` on the event channel as the plugin would
+Future<void> _sendEvent(Map<String, dynamic> event) {
+  return _messenger.handlePlatformMessage(
+    _eventsName,
+    _codec.encodeSuccessEnvelope(event),
+    (_) {},
+  );
+}
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  final calls = <MethodCall>[];
+  var listening = false;
+
+  setUp(() {
+    calls.clear();
+    listening = false;
+    _messenger.setMockMessageHandler(_eventsName, (message) async {
+      final call = _codec.decodeMethodCall(message);
+      listening = call.method == 'listen';
+      return _codec.encodeSuccessEnvelope(null);
+    });
+  });
+
+  tearDown(() {
+    _messenger.setMockMethodCallHandler(_channel, null);
+    _messenger.setMockMessageHandler(_eventsName, null);
+  });
+
+  test('startListRarContents routes events by job and closes on done',
+      () async {
+    _messenger.setMockMethodCallHandler(_channel, (call) async {
+      calls.add(call);
+      final job = (call.arguments as Map)['job'] as int;
+      // Another job's events are not delivered to this one
+      await _sendEvent({'job': job + 100, 'type': 'entries', 'entries': []});
+      await _sendEvent({
+        'job': job,
+        'type': 'entries',
+        'entries': [
+          {'name': 'a.txt', 'size': 3, 'isDirectory': false},
+        ],
+      });
+      await _sendEvent({
+        'job': job,
+        'type': 'done',
+        'success': true,
+        'code': 0,
+        'message': 'Successfully listed RAR contents',
+      });
+      return {
+        'success': true,
+        'message': 'Successfully listed RAR contents',
+        'files': ['a.txt'],
+      };
+    });
+
+    final job = RarMethodChannel().startListRarContents(
+      rarFilePath: '/nonexistent/archive.rar',
+    );
+    final events = job.events.toList();
+    final result = await job.result;
+
+    expect(calls.single.method, 'listRarContents');
+    expect((calls.single.arguments as Map)['job'], job.id);
+    expect(result['success'], true);
+    expect(result['files'], ['a.txt']);
+
+    final received = await events;
+    expect(received.map((e) => e['type']), ['entries', 'done']);
+    expect(received.every((e) => e['job'] == job.id), isTrue);
+    // The last unfinished job stops listening
+    expect(listening, isFalse);
+  });
+
+  test('startExtractRarFile ends its events without a done event', () async {
+    _messenger.setMockMethodCallHandler(_channel, (call) async {
+      return {
+        'success': false,
+        'message': 'rarFilePath and destinationPath are required',
+      };
+    });
+
+    final job = RarMethodChannel().startExtractRarFile(
+      rarFilePath: '',
+      destinationPath: '',
+    );
+    final events = job.events.toList();
+
+    expect(await job.result, {
+      'success': false,
+      'message': 'rarFilePath and destinationPath are required',
+    });
+    expect(await events, isEmpty);
+  });
+
+  test('cancel sends cancelJob with the job id', () async {
+    _messenger.setMockMethodCallHandler(_channel, (call) async {
+      calls.add(call);
+      if (call.method == 'cancelJob') return true;
+      return {'success': false, 'message': 'Operation cancelled'};
+    });
+
+    final job = RarMethodChannel().startExtractRarFile(
+      rarFilePath: '/a.rar',
+      destinationPath: '/out',
+    );
+    expect(await job.cancel(), isTrue);
+    await job.result;
+
+    final cancel = calls.firstWhere((call) => call.method == 'cancelJob');
+    expect(cancel.arguments, {'job': job.id});
+  });
+}
@@ -81,6 +81,55 @@ class MockRarPlatform extends RarPlatform with MockPlatformInterfaceMixin {
     }
   }
 
+  @override
+  Future<Map<String, dynamic>> probeRar({required String rarFilePath}) async {
+    lastRarFilePath = rarFilePath;
+
+    if (shouldSucceed) {
+      return {
+        'success': true,
+        'message': 'Successfully probed RAR file',
+        'rarVersion': 'RAR5',
+        'solid': true,
+        'multiVolume': false,
+        'entryCount': mockFiles.length,
+      };
+    } else {
+      return {
+        'success': false,
+        'message': errorMessage,
+        'rarVersion': 'Unknown',
+      };
+    }
+  }
+
+  @override
+  Future<Map<String, dynamic>> testRar({
+    required String rarFilePath,
+    String? password,
+  }) async {
+    lastRarFilePath = rarFilePath;
+    lastPassword = password;
+
+    if (shouldSucceed) {
+      return {
+        'success': true,
+        'message': 'All entries are intact',
+        'entriesTested': mockFiles.length,
+        'failures': <Map<String, dynamic>>[],
+      };
+    } else {
+      return {
+        'success': false,
+        'message': errorMessage,
+        'entriesTested': mockFiles.length,
+        'failures': [
+          {'index': 1, 'name': mockFiles[1], 'code': 8, 'message': 'CRC'},
+        ],
+      };
+    }
+  }
+
   @override
   Future<Map<String, dynamic>> createRarArchive({
     required String outputPath,
@@ -196,6 +245,55 @@ void main() {
     });
   });
 
+  group('Rar.extractMany', () {
+    test('extracts every archive to its destination', () async {
+      final results = await Rar.extractMany(
+        rarFilePaths: ['/a.rar', '/b.rar'],
+        destinationPaths: ['/out/a', '/out/b'],
+        password: 'secret',
+      );
+
+      expect(results, hasLength(2));
+      expect(results.every((r) => r['success'] == true), true);
+      expect(mockPlatform.lastRarFilePath, '/b.rar');
+      expect(mockPlatform.lastDestinationPath, '/out/b');
+      expect(mockPlatform.lastPassword, 'secret');
+    });
+
+    test('rejects mismatched destinations', () async {
+      expect(
+        () => Rar.extractMany(
+          rarFilePaths: ['/a.rar', '/b.rar'],
+          destinationPaths: ['/out/a'],
+        ),
+        throwsArgumentError,
+      );
+    });
+  });
+
+  group('Rar.listMany', () {
+    test('returns one listing per archive', () async {
+      final results = await Rar.listMany(rarFilePaths: ['/a.rar', '/b.rar']);
+
+      expect(results, hasLength(2));
+      expect(results[0]['files'], ['file1.txt', 'file2.txt']);
+      expect(mockPlatform.lastRarFilePath, '/b.rar');
+    });
+
+    test('reports failures per archive', () async {
+      mockPlatform.shouldSucceed = false;
+
+      final results = await Rar.listMany(rarFilePaths: ['/a.rar']);
+
+      expect(results.single['success'], false);
+      expect(results.single['files'], isEmpty);
+    });
+
+    test('handles an empty list', () async {
+      expect(await Rar.listMany(rarFilePaths: []), isEmpty);
+    });
+  });
+
   group('Rar.createRarArchive', () {
     test('always returns unsupported', () async {
       final result = await Rar.createRarArchive(
@@ -234,4 +332,53 @@ void main() {
       expect(result['message'], contains('Corrupt'));
     });
   });
+
+  group('Rar.probeRar', () {
+    test('returns archive properties', () async {
+      final result = await Rar.probeRar(rarFilePath: '/a.rar');
+
+      expect(mockPlatform.lastRarFilePath, '/a.rar');
+      expect(result['success'], true);
+      expect(result['rarVersion'], 'RAR5');
+      expect(result['solid'], true);
+      expect(result['entryCount'], 2);
+    });
+
+    test('reports failure', () async {
+      mockPlatform.shouldSucceed = false;
+
+      final result = await Rar.probeRar(rarFilePath: '/not-rar.bin');
+
+      expect(result['success'], false);
+      expect(result['message'], 'Test error');
+      expect(result['rarVersion'], 'Unknown');
+    });
+  });
+
+  group('Rar.testRar', () {
+    test('passes path and password through', () async {
+      final result = await Rar.testRar(
+        rarFilePath: '/a.rar',
+        password: 'secret',
+      );
+
+      expect(mockPlatform.lastRarFilePath, '/a.rar');
+      expect(mockPlatform.lastPassword, 'secret');
+      expect(result['success'], true);
+      expect(result['entriesTested'], 2);
+      expect(result['failures'], isEmpty);
+    });
+
+    test('reports damaged entries', () async {
+      mockPlatform.shouldSucceed = false;
+
+      final result = await Rar.testRar(rarFilePath: '/bad.rar');
+
+      expect(result['success'], false);
+      final failures = result['failures'] as List<Map<String, dynamic>>;
+      expect(failures, hasLength(1));
+      expect(failures.first['name'], 'file2.txt');
+      expect(failures.first['code'], 8);
+    });
+  });
 }
@@ -0,0 +1,95 @@
+// test/rar_worker_pool_test.dart
+//
+// Unit tests for the worker-isolate pool used by the FFI layer.
+// These tests only run Dart closures, so they need no native library.
+
+import 'dart:isolate';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:rar/src/rar_worker_pool.dart';
+
+int _square(int value) => value * value;
+
+// Tasks are built at top level so they capture nothing but `value`; a
+// closure created inside a test would also capture the pool.
+int Function() _squareTask(int value) => () => _square(value);
+
+Never _fail() => throw ArgumentError('bad');
+
+int _one() => 1;
+
+String _isolateName() => Isolate.current.debugName ?? '';
+
+// Hands `ready` a port and completes once something is sent to it
+Future<int> Function() _waitTask(SendPort ready) => () async {
+  final release = ReceivePort();
+  ready.send(release.sendPort);
+  await release.first;
+  return 1;
+};
+
+void main() {
+  group('RarWorkerPool', () {
+    late RarWorkerPool pool;
+
+    setUp(() {
+      pool = RarWorkerPool(size: 2);
+    });
+
+    tearDown(() {
+      pool.close();
+    });
+
+    test('returns task results', () async {
+      expect(await pool.run(_squareTask(7)), 49);
+    });
+
+    test('runs tasks on a worker isolate', () async {
+      expect(await pool.run(_isolateName), 'rar worker');
+    });
+
+    test('propagates task errors', () async {
+      await expectLater(
+        pool.run<void>(_fail),
+        // Errors that cannot be sent back arrive as a RemoteError
+        throwsA(anyOf(isA<ArgumentError>(), isA<RemoteError>())),
+      );
+    });
+
+    test('reuses idle workers', () async {
+      for (var i = 0; i < 5; i++) {
+        await pool.run(_squareTask(i));
+      }
+      expect(pool.workerCount, 1);
+    });
+
+    test('starts at most size workers', () async {
+      final results = await Future.wait([
+        for (var i = 0; i < 8; i++) pool.run(_squareTask(i)),
+      ]);
+      expect(results, [0, 1, 4, 9, 16, 25, 36, 49]);
+      expect(pool.workerCount, lessThanOrEqualTo(2));
+    });
+
+    test('keeps an exclusive worker to its task', () async {
+      final single = RarWorkerPool(size: 1);
+      addTearDown(single.close);
+      final ready = ReceivePort();
+      final held = single.run(_waitTask(ready.sendPort), exclusive: true);
+      final release = await ready.first as SendPort;
+
+      // Goes to a second worker although the pool is at its size
+      expect(await single.run(_squareTask(3)), 9);
+      expect(single.workerCount, 2);
+
+      release.send(null);
+      expect(await held, 1);
+      expect(single.workerCount, 1);
+    });
+
+    test('rejects tasks after close', () async {
+      pool.close();
+      await expectLater(pool.run(_one), throwsStateError);
+    });
+  });
+}
@@ -14,6 +14,14 @@
 // - RarWeb.init() - Initialize the WASM library
 // - RarWeb.listFromBytes(Uint8Array, password) - List archive contents
 // - RarWeb.extractFromBytes(Uint8Array, password) - Extract archive contents
+// - RarWeb.openBlob(Blob, password) - Open a Blob/File for streaming access
+// - RarWeb.listEntries(session) - List entries without reading their data
+// - RarWeb.readEntry(session, path) - Extract one entry as an ArrayBuffer
+// - RarWeb.startExtract(session) - Start a single pass over every file
+// - RarWeb.nextEntry(session) - Take the next file of that pass
+// - RarWeb.stopExtract(session) - End the pass early
+// - RarWeb.closeArchive(session) - Release a streaming session
+// - RarWeb.configurePool(size) - Set how many workers run operations at once
 
 (function () {
   'use strict';
@@ -27,6 +35,32 @@
   let wasmModule = null;
   let isInitialized = false;
 
+  // libarchive.wasm compiled once by init() and posted to every worker, or
+  // null when it could not be compiled here (each worker then compiles it)
+  let compiledWasm = null;
+
+  // Workers for listFromBytes/extractFromBytes. Each keeps its libarchive
+  // instance between operations, so only the first use of a worker pays for
+  // instantiating the module. Workers are started on demand up to `size`;
+  // operations beyond that wait for the next idle one.
+  const pool = {
+    size: defaultPoolSize(),
+    count: 0,
+    idle: [],
+    waiting: []
+  };
+
+  // A worker that loaded an archive larger than this is terminated after the
+  // operation instead of being reused, since its WASM heap never shrinks.
+  const POOL_RETIRE_BYTES = 64 * 1024 * 1024;
+
+  // Streaming sessions opened by openBlob, keyed by session id, as
+  // { archive, walk }. Each one owns a libarchive.js worker that holds the
+  // archive; the page only ever holds the entry being read. `walk` is the
+  // pass started by startExtract, or null.
+  const sessions = new Map();
+  let nextSession = 1;
+
   // The RarWeb API exposed to Dart
   window.RarWeb = {
     // Check if library is initialized
@@ -67,17 +101,11 @@
       }
 
       try {
-        const archive = await openArchive(data, password);
-
-        const entries = await listArchiveEntries(archive);
+        const entries = await withPooledArchive(data, password, listArchiveEntries);
         const files = entries
           .map((entry) => entry && (entry.path || entry.name || entry.fileName || ''))
           .filter((p) => !!p);
 
-        if (typeof archive.close === 'function') {
-          archive.close();
-        }
-
         return {
           success: true,
           message: 'Successfully listed RAR contents',
@@ -107,13 +135,7 @@
       }
 
       try {
-        const archive = await openArchive(data, password);
-
-        const entries = await extractArchiveEntries(archive);
-
-        if (typeof archive.close === 'function') {
-          archive.close();
-        }
+        const entries = await withPooledArchive(data, password, extractArchiveEntries);
 
         return {
           success: true,
@@ -128,9 +150,315 @@
           entries: []
         };
       }
+    },
+
+    // Open a Blob or File for streaming access. Each session has a worker of
+    // its own outside the pool, for as long as it is open. The Blob is handed
+    // to the worker as is, so the archive bytes are never copied on this
+    // thread.
+    // The shipped libarchive.wasm only reads archives from its heap
+    // (archive_open takes a pointer and a length), so the worker loads the
+    // Blob there once and the archive must fit in the worker's WASM memory.
+    // blob: Blob|File - The RAR file
+    // password: String|null - Optional password for encrypted archives
+    // Returns: { success: boolean, message: string, session: number }
+    async openBlob(blob, password) {
+      if (!isInitialized) {
+        return {
+          success: false,
+          message: 'RAR library not initialized. Call init() first.',
+          session: 0
+        };
+      }
+
+      try {
+        const archive = await wasmModule.open(blob);
+        if (password) {
+          await archive.usePassword(password);
+        }
+        const session = nextSession++;
+        sessions.set(session, { archive, walk: null });
+        return {
+          success: true,
+          message: 'Archive opened',
+          session: session
+        };
+      } catch (error) {
+        err('openBlob failed', error);
+        return {
+          success: false,
+          message: getErrorMessage(error),
+          session: 0
+        };
+      }
+    },
+
+    // List the entries of a session in archive order. Headers are read in
+    // the worker and entry data is skipped.
+    // Returns: { success: boolean, message: string,
+    //            entries: [{name, size, isDirectory, lastModified (ms)}] }
+    async listEntries(session) {
+      const open = sessions.get(session);
+      if (!open) {
+        return { success: false, message: 'Archive is not open', entries: [] };
+      }
+      if (open.walk) {
+        return { success: false, message: 'Archive is being extracted', entries: [] };
+      }
+      const archive = open.archive;
+
+      try {
+        const files = await archive.client.listFiles();
+        const entries = files
+          .filter((f) => f && f.path)
+          .map((f) => ({
+            name: f.path,
+            size: f.size || 0,
+            isDirectory: f.type === 'DIR',
+            // libarchive.js reports nanoseconds
+            lastModified: Math.floor((f.lastModified || 0) / 1e6)
+          }));
+        return {
+          success: true,
+          message: 'Successfully listed RAR contents',
+          entries: entries
+        };
+      } catch (error) {
+        err('listEntries failed', error);
+        return { success: false, message: getErrorMessage(error), entries: [] };
+      }
+    },
+
+    // Extract the entry at `path`. The worker skips the entries before it,
+    // which is cheap in non-solid archives; in solid ones it decompresses
+    // them. The worker's copy of the data is released once it is sent.
+    // Returns: { success: boolean, message: string, name: string,
+    //            data: ArrayBuffer|null, size: number }
+    async readEntry(session, path) {
+      const open = sessions.get(session);
+      if (!open) {
+        return { success: false, message: 'Archive is not open', name: path, data: null, size: 0 };
+      }
+      if (open.walk) {
+        return { success: false, message: 'Archive is being extracted', name: path, data: null, size: 0 };
+      }
+      const archive = open.archive;
+
+      try {
+        const file = await archive.client.extractSingleFile(path);
+        if (!file || !file.fileData) {
+          return { success: false, message: `Entry not found: ${path}`, name: path, data: null, size: 0 };
+        }
+        const data = file.fileData;
+        const buffer = data.byteOffset === 0 && data.byteLength === data.buffer.byteLength
+          ? data.buffer
+          : data.slice().buffer;
+        return {
+          success: true,
+          message: 'Entry extracted',
+          name: path,
+          data: buffer,
+          size: buffer.byteLength
+        };
+      } catch (error) {
+        err('readEntry failed', error);
+        return { success: false, message: getErrorMessage(error), name: path, data: null, size: 0 };
+      }
+    },
+
+    // Start a single pass over the files of a session. The worker walks the
+    // archive once, decompressing each file a single time, and posts its data
+    // as a transferable ArrayBuffer; nextEntry takes the files in archive
+    // order. The worker runs at most one file ahead of nextEntry. listEntries
+    // and readEntry fail until the pass ends, since they use the same reader.
+    // Returns: { success: boolean, message: string }
+    startExtract(session) {
+      const open = sessions.get(session);
+      if (!open) {
+        return { success: false, message: 'Archive is not open' };
+      }
+      if (open.walk) {
+        return { success: false, message: 'Archive is already being extracted' };
+      }
+      const channel = new MessageChannel();
+      const walk = { port: channel.port1, received: [], waiting: null };
+      walk.port.onmessage = (event) => deliverWalkMessage(walk, event.data);
+      open.archive.worker.postMessage({ rarExtract: channel.port2 }, [channel.port2]);
+      open.walk = walk;
+      return { success: true, message: 'Extraction started' };
+    },
+
+    // Take the next file of the pass started by startExtract. The pass ends
+    // after a result with done or success false.
+    // Returns: { success: boolean, message: string, done: boolean,
+    //            name: string, data: ArrayBuffer|null, size: number,
+    //            lastModified (ms) }
+    async nextEntry(session) {
+      const open = sessions.get(session);
+      const walk = open && open.walk;
+      if (!walk) {
+        return walkResult({ error: 'Archive is not being extracted' });
+      }
+      walk.port.postMessage(1);
+      const message = walk.received.length > 0
+        ? walk.received.shift()
+        : await new Promise((resolve) => {
+          walk.waiting = resolve;
+        });
+      if ((message.done || message.error) && open.walk === walk) {
+        endWalk(open);
+      }
+      return walkResult(message);
+    },
+
+    // End the pass of a session early; a pending nextEntry reports done.
+    // Ignored when no pass is running.
+    stopExtract(session) {
+      const open = sessions.get(session);
+      if (open && open.walk) {
+        open.archive.worker.postMessage({ rarStop: true });
+        endWalk(open, { done: true });
+      }
+    },
+
+    // Release a session and terminate its worker. Unknown ids are ignored.
+    async closeArchive(session) {
+      const open = sessions.get(session);
+      sessions.delete(session);
+      if (!open) return;
+      if (open.walk) {
+        endWalk(open, { error: 'Archive was closed' });
+      }
+      if (typeof open.archive.close === 'function') {
+        await open.archive.close();
+      }
+    },
+
+    // Set the number of pooled workers (at least 1). Idle workers above the
+    // new size are terminated; busy ones finish their operation first.
+    // Returns the size in effect.
+    configurePool(size) {
+      pool.size = Math.max(1, Math.floor(Number(size)) || 1);
+      while (pool.count > pool.size && pool.idle.length > 0) {
+        retireWorker(pool.idle.pop());
+      }
+      return pool.size;
     }
   };
 
+  // Hand a message from the worker's pass to a waiting nextEntry, or keep it
+  // for the next one
+  function deliverWalkMessage(walk, message) {
+    if (walk.waiting) {
+      const resolve = walk.waiting;
+      walk.waiting = null;
+      resolve(message);
+    } else {
+      walk.received.push(message);
+    }
+  }
+
+  // Detach the pass of a session; `message` goes to a pending nextEntry
+  function endWalk(open, message) {
+    const walk = open.walk;
+    open.walk = null;
+    walk.port.onmessage = null;
+    walk.port.close();
+    if (message) {
+      deliverWalkMessage(walk, message);
+    }
+  }
+
+  // nextEntry's result for a message of the worker's pass
+  function walkResult(message) {
+    if (message.error) {
+      return { success: false, message: message.error, done: true, name: '', data: null, size: 0, lastModified: 0 };
+    }
+    if (message.done) {
+      return { success: true, message: 'Extraction completed', done: true, name: '', data: null, size: 0, lastModified: 0 };
+    }
+    return {
+      success: true,
+      message: 'Entry extracted',
+      done: false,
+      name: message.name,
+      data: message.data,
+      size: message.data.byteLength,
+      // libarchive.js reports nanoseconds
+      lastModified: Math.floor((message.lastModified || 0) / 1e6)
+    };
+  }
+
+  function defaultPoolSize() {
+    const cores = (typeof navigator !== 'undefined' && navigator.hardwareConcurrency) || 2;
+    // Leave a core for the page, and bound the WASM heaps held by idle workers
+    return Math.min(Math.max(cores - 1, 1), 8);
+  }
+
+  // Run fn(archive) on a pooled worker with `data` (a Uint8Array) opened.
+  // The worker's copy of the archive is freed before the worker goes back to
+  // the pool; a worker whose operation failed is terminated rather than
+  // reused, since its libarchive state is unknown.
+  async function withPooledArchive(data, password, fn) {
+    const file = new File([data], 'archive.rar');
+    const slot = await acquireWorker();
+    let reusable = false;
+    try {
+      if (slot.archive) {
+        slot.archive.file = file;
+        await slot.archive.open();
+      } else {
+        slot.archive = await wasmModule.open(file);
+      }
+      await slot.archive.usePassword(password || null);
+      const result = await fn(slot.archive);
+      // Only after fn has read the archive: closing one that was never read
+      // would hand libarchive a null archive
+      await slot.archive.client.close();
+      reusable = file.size <= POOL_RETIRE_BYTES;
+      return result;
+    } finally {
+      if (reusable) {
+        releaseWorker(slot);
+      } else {
+        retireWorker(slot);
+      }
+    }
+  }
+
+  function acquireWorker() {
+    if (pool.idle.length > 0) {
+      return Promise.resolve(pool.idle.pop());
+    }
+    if (pool.count < pool.size) {
+      pool.count++;
+      // The worker itself starts on first open
+      return Promise.resolve({ archive: null });
+    }
+    return new Promise((resolve) => pool.waiting.push(resolve));
+  }
+
+  function releaseWorker(slot) {
+    if (pool.count > pool.size) {
+      retireWorker(slot);
+    } else if (pool.waiting.length > 0) {
+      pool.waiting.shift()(slot);
+    } else {
+      pool.idle.push(slot);
+    }
+  }
+
+  function retireWorker(slot) {
+    if (slot.archive && typeof slot.archive.close === 'function') {
+      slot.archive.close();
+    }
+    pool.count--;
+    if (pool.waiting.length > 0 && pool.count < pool.size) {
+      pool.count++;
+      pool.waiting.shift()({ archive: null });
+    }
+  }
+
   // Load the archive WASM module (libarchive.js only, no fallbacks)
   async function loadArchiveModule() {
     const localBases = getLocalBaseUrls();
@@ -208,15 +536,8 @@
       }
     }
 
-    // Preferred: libarchive.js extractFiles (includes fileData)
-    if (typeof archive.extractFiles === 'function') {
-      const files = await archive.extractFiles();
-      const normalized = await normalizeFileResults(files);
-      if (normalized) {
-        return normalized;
-      }
-      warn('extractFiles returned unexpected shape; trying per-file extraction via entries');
-    }
+    // archive.extractFiles() is not used: it terminates the worker, which
+    // belongs to the pool
 
     // Attempt extraction via entries(false) generator (libarchive API)
     if (typeof archive.entries === 'function') {
@@ -261,7 +582,10 @@
         const buf = await f.arrayBuffer();
         data = new Uint8Array(buf);
       }
-      const uint8 = data ? new Uint8Array(data) : new Uint8Array();
+      // fileData arrives transferred from the worker, so keep it as is
+      const uint8 = data instanceof Uint8Array
+        ? data
+        : (data ? new Uint8Array(data) : new Uint8Array());
       result.push({
         name,
         data: uint8,
@@ -325,7 +649,7 @@
   async function tryLoadArchiveModuleFromBase(baseUrl) {
     const normalizedBase = baseUrl.endsWith('/') ? baseUrl : `${baseUrl}/`;
     const scriptUrl = `${normalizedBase}libarchive.js`;
-    const workerUrl = `${normalizedBase}worker-bundle.js`;
+    const workerUrl = `${normalizedBase}rar_worker.js`;
     const wasmUrl = `${normalizedBase}libarchive.wasm`;
 
     try {
@@ -334,6 +658,7 @@
       }
 
       if (typeof Archive !== 'undefined') {
+        compiledWasm = await compileWasm(wasmUrl);
         await initArchive({ workerUrl, base: normalizedBase, wasmUrl });
         return Archive;
       }
@@ -359,12 +684,41 @@
     const options = {
       workerUrl,
       locateFile,
-      wasmBinaryFile: wasmUrl
+      wasmBinaryFile: wasmUrl,
+      // Every worker gets the module compiled by compileWasm
+      getWorker: () => {
+        const worker = new Worker(workerUrl, { type: 'module' });
+        worker.postMessage({ rarWasmModule: compiledWasm });
+        return worker;
+      }
     };
 
     return Archive.init(options);
   }
 
+  // Compile libarchive.wasm once for all workers. Falls back to compiling
+  // from bytes when the server does not send application/wasm, and to null
+  // (workers compile their own) when neither works.
+  async function compileWasm(wasmUrl) {
+    try {
+      if (typeof WebAssembly.compileStreaming === 'function') {
+        try {
+          return await WebAssembly.compileStreaming(fetch(wasmUrl, { credentials: 'same-origin' }));
+        } catch (e) {
+          warn('compileStreaming failed, compiling from bytes', e);
+        }
+      }
+      const response = await fetch(wasmUrl, { credentials: 'same-origin' });
+      if (!response.ok) {
+        throw new Error(`HTTP ${response.status} for ${wasmUrl}`);
+      }
+      return await WebAssembly.compile(await response.arrayBuffer());
+    } catch (e) {
+      warn('Could not compile libarchive.wasm on the page', e);
+      return null;
+    }
+  }
+
   function ensureTrailingSlash(url) {
     if (!url) return '';
     return url.endsWith('/') ? url : `${url}/`;
@@ -394,18 +748,6 @@
     throw lastError || new Error('Failed to import Archive module');
   }
 
-  // Open an archive from Uint8Array data
-  async function openArchive(data, password) {
-    if (!wasmModule || !wasmModule.open) {
-      throw new Error('libarchive.js is not initialized');
-    }
-    const options = {};
-    if (password) {
-      options.passphrase = password;
-    }
-    return await wasmModule.open(new File([data], 'archive.rar'), options);
-  }
-
   // Get a user-friendly error message
   function getErrorMessage(error) {
     if (error.message) {
@@ -0,0 +1,128 @@
+// web/rar_worker.js
+//
+// Module worker used by rar_web.js in place of worker-bundle.js. It runs the
+// libarchive.js worker unchanged and adds two things around it:
+//
+// - The page compiles libarchive.wasm once and posts the WebAssembly.Module
+//   as this worker's first message ({ rarWasmModule }). The worker then
+//   instantiates that module instead of compiling its own copy. A null module
+//   falls back to the worker's own streaming compile.
+// - Extracted entry data (fileData) is transferred to the page instead of
+//   being copied. Each entry is a fresh slice of the WASM heap that the worker
+//   drops once it is sent.
+// - A { rarExtract: MessagePort } message starts a single pass over the open
+//   archive for RarWebArchive.extract(), see walkEntries.
+
+import './worker-bundle.js';
+
+let resolveModule;
+const compiledModule = new Promise((resolve) => {
+  resolveModule = resolve;
+});
+
+// libarchive.js keeps its reader (the object behind listFiles and
+// extractSingleFile) to itself. Its open() is the first to set _filePtr, so a
+// one-shot setter on Object.prototype hands the reader over and steps aside.
+let reader = null;
+Object.defineProperty(Object.prototype, '_filePtr', {
+  configurable: true,
+  set(value) {
+    delete Object.prototype._filePtr;
+    reader = this;
+    this._filePtr = value;
+  }
+});
+
+// The pass started by the last rarExtract message, while it runs
+let walk = null;
+
+// Comlink's listener sees these messages too and ignores them (they have no
+// type). rarStop comes this way rather than over the pass's port so that it
+// is handled before any Comlink call the page makes after it.
+self.addEventListener('message', (event) => {
+  const data = event.data;
+  if (!data) return;
+  if ('rarWasmModule' in data) {
+    resolveModule(data.rarWasmModule);
+  } else if ('rarExtract' in data) {
+    walkEntries(data.rarExtract);
+  } else if ('rarStop' in data && walk) {
+    walk.stopped = true;
+    walk.wake();
+  }
+});
+
+// Walk the open archive once with the reader's own entries() generator,
+// decompressing every file a single time, and post each one to `port` as
+// { name, lastModified, data } with its ArrayBuffer transferred. The page
+// posts a number of entries it is ready for (credits) over the port; the
+// walk waits when it has none, so it runs at most one entry ahead of the
+// page. It ends with { done: true }, { error } or, after rarStop, silently.
+async function walkEntries(port) {
+  const state = { credits: 0, stopped: false, wake: () => {} };
+  walk = state;
+  port.onmessage = (event) => {
+    state.credits += event.data;
+    state.wake();
+  };
+  const woken = () => new Promise((resolve) => {
+    state.wake = resolve;
+  });
+
+  try {
+    if (!reader) {
+      throw new Error('Archive is not open');
+    }
+    for (const entry of reader.entries(false)) {
+      if (entry.type !== 'FILE') continue;
+      while (state.credits === 0 && !state.stopped) {
+        await woken();
+      }
+      if (state.stopped) break;
+      state.credits--;
+      const data = entry.fileData.buffer;
+      port.postMessage({ name: entry.path, lastModified: entry.lastModified, data }, [data]);
+    }
+    if (!state.stopped) {
+      port.postMessage({ done: true });
+    }
+  } catch (error) {
+    port.postMessage({ error: (error && error.message) || String(error) });
+  } finally {
+    if (walk === state) walk = null;
+    port.close();
+  }
+}
+
+// worker-bundle.js calls instantiateStreaming once its fetch of
+// libarchive.wasm resolves, which is always after this module has run.
+const instantiateStreaming = WebAssembly.instantiateStreaming;
+WebAssembly.instantiateStreaming = async (source, imports) => {
+  const module = await compiledModule;
+  if (!module) {
+    return instantiateStreaming(source, imports);
+  }
+  // The response is cached by the page's compile; don't read it again
+  Promise.resolve(source)
+    .then((response) => response.body && response.body.cancel())
+    .catch(() => {});
+  const instance = await WebAssembly.instantiate(module, imports);
+  return { module, instance };
+};
+
+// Results go back through Comlink as { type: 'RAW', value } messages
+const postMessage = self.postMessage.bind(self);
+self.postMessage = (message, transfer) => {
+  const value = message && message.type === 'RAW' ? message.value : null;
+  const items = Array.isArray(value) ? value : [value];
+  const owned = [];
+  for (const item of items) {
+    const data = item && item.fileData;
+    if (data instanceof Uint8Array && data.byteOffset === 0 &&
+        data.byteLength === data.buffer.byteLength &&
+        data.buffer instanceof ArrayBuffer) {
+      owned.push(data.buffer);
+    }
+  }
+  return postMessage(message, owned.length ? (transfer || []).concat(owned) : transfer);
+};
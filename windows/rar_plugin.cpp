@@ -6,24 +6,129 @@
 // For getPlatformVersion; remove unless needed for your plugin implementation.
 #include <VersionHelpers.h>
 
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 
 #include <memory>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <variant>
 
 namespace rar {
 
+namespace {
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Posted to the plugin's message window when deliveries are waiting
+constexpr UINT kJobMessage = WM_APP;
+
+constexpr wchar_t kWindowClassName[] = L"RarPluginJobWindow";
+
+// Helper: the module this code lives in, which owns the window class
+HINSTANCE CurrentModule() {
+  HMODULE module = nullptr;
+  GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                         GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                     reinterpret_cast<LPCWSTR>(&CurrentModule), &module);
+  return module;
+}
+
+// Helper: string argument `key`, or "" when missing or not a string
+std::string StringArg(const EncodableMap *args, const char *key) {
+  if (args == nullptr) return "";
+  auto it = args->find(EncodableValue(key));
+  if (it == args->end()) return "";
+  const auto *value = std::get_if<std::string>(&it->second);
+  return value != nullptr ? *value : "";
+}
+
+// Helper: integer argument `key`, or 0 when missing or not an integer
+int64_t IntArg(const EncodableMap *args, const char *key) {
+  if (args == nullptr) return 0;
+  auto it = args->find(EncodableValue(key));
+  if (it == args->end()) return 0;
+  if (const auto *value = std::get_if<int32_t>(&it->second)) return *value;
+  if (const auto *value = std::get_if<int64_t>(&it->second)) return *value;
+  return 0;
+}
+
+// Helper: the event channel payload for `event`
+EncodableValue JobEventToValue(const JobEvent &event) {
+  EncodableMap value;
+  value[EncodableValue("job")] = EncodableValue(event.job);
+  switch (event.type) {
+    case JobEvent::kProgress:
+      value[EncodableValue("type")] = EncodableValue("progress");
+      value[EncodableValue("entriesDone")] = EncodableValue(event.entries_done);
+      value[EncodableValue("entriesTotal")] =
+          EncodableValue(event.entries_total);
+      value[EncodableValue("bytesOut")] = EncodableValue(event.bytes_out);
+      value[EncodableValue("bytesTotal")] = EncodableValue(event.bytes_total);
+      if (!event.entry_name.empty()) {
+        value[EncodableValue("entryName")] = EncodableValue(event.entry_name);
+      }
+      break;
+    case JobEvent::kEntries: {
+      EncodableList entries;
+      entries.reserve(event.entries.size());
+      for (const JobEvent::Entry &entry : event.entries) {
+        entries.push_back(EncodableValue(EncodableMap{
+            {EncodableValue("name"), EncodableValue(entry.name)},
+            {EncodableValue("size"),
+             EncodableValue(static_cast<int64_t>(entry.size))},
+            {EncodableValue("isDirectory"),
+             EncodableValue(entry.is_directory)},
+        }));
+      }
+      value[EncodableValue("type")] = EncodableValue("entries");
+      value[EncodableValue("entries")] = EncodableValue(std::move(entries));
+      break;
+    }
+    case JobEvent::kDone:
+      value[EncodableValue("type")] = EncodableValue("done");
+      value[EncodableValue("success")] =
+          EncodableValue(event.code == RAR_SUCCESS);
+      value[EncodableValue("code")] = EncodableValue(event.code);
+      value[EncodableValue("message")] = EncodableValue(event.message);
+      break;
+  }
+  return EncodableValue(std::move(value));
+}
+
+// Helper: the method call result for a finished job
+EncodableValue JobResultToValue(const JobEvent &event, bool list_job) {
+  EncodableMap value{
+      {EncodableValue("success"), EncodableValue(event.code == RAR_SUCCESS)},
+      {EncodableValue("message"), EncodableValue(event.message)},
+  };
+  if (list_job) {
+    EncodableList files;
+    files.reserve(event.files.size());
+    for (const std::string &name : event.files) {
+      files.push_back(EncodableValue(name));
+    }
+    value[EncodableValue("files")] = EncodableValue(std::move(files));
+  }
+  return EncodableValue(std::move(value));
+}
+
+}  // namespace
+
 // static
 void RarPlugin::RegisterWithRegistrar(
     flutter::PluginRegistrarWindows *registrar) {
   auto channel =
       std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
-          registrar->messenger(), "rar",
+          registrar->messenger(), "com.lkrjangid.rar",
           &flutter::StandardMethodCodec::GetInstance());
 
-  auto plugin = std::make_unique<RarPlugin>();
+  auto plugin = std::make_unique<RarPlugin>(registrar);
 
   channel->SetMethodCallHandler(
       [plugin_pointer = plugin.get()](const auto &call, auto result) {
@@ -33,14 +138,58 @@ void RarPlugin::RegisterWithRegistrar(
   registrar->AddPlugin(std::move(plugin));
 }
 
-RarPlugin::RarPlugin() {}
+RarPlugin::RarPlugin(flutter::PluginRegistrarWindows *registrar)
+    : registrar_(registrar), executor_(std::make_unique<Executor>()) {
+  // Registering an existing class fails harmlessly for later instances
+  HINSTANCE module = CurrentModule();
+  WNDCLASSW window_class = {};
+  window_class.lpfnWndProc = &RarPlugin::WindowProc;
+  window_class.hInstance = module;
+  window_class.lpszClassName = kWindowClassName;
+  RegisterClassW(&window_class);
+  window_ = CreateWindowExW(0, kWindowClassName, L"", 0, 0, 0, 0, 0,
+                            HWND_MESSAGE, nullptr, module, this);
 
-RarPlugin::~RarPlugin() {}
+  if (registrar_ == nullptr) return;
+
+  events_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar_->messenger(), "com.lkrjangid.rar/events",
+          &flutter::StandardMethodCodec::GetInstance());
+  events_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<>>(
+          [this](const EncodableValue *arguments,
+                 std::unique_ptr<flutter::EventSink<>> &&events)
+              -> std::unique_ptr<flutter::StreamHandlerError<>> {
+            events_ = std::move(events);
+            return nullptr;
+          },
+          [this](const EncodableValue *arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<>> {
+            events_.reset();
+            return nullptr;
+          }));
+}
+
+RarPlugin::~RarPlugin() {
+  // Finishes every job first; their last deliveries are dropped with the
+  // window's queued messages
+  executor_.reset();
+  if (window_ != nullptr) DestroyWindow(window_);
+}
 
 void RarPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-  if (method_call.method_name().compare("getPlatformVersion") == 0) {
+  const auto *args = std::get_if<EncodableMap>(method_call.arguments());
+
+  if (method_call.method_name().compare("listRarContents") == 0) {
+    StartJob(args, std::move(result), true);
+  } else if (method_call.method_name().compare("extractRarFile") == 0) {
+    StartJob(args, std::move(result), false);
+  } else if (method_call.method_name().compare("cancelJob") == 0) {
+    result->Success(EncodableValue(executor_->Cancel(IntArg(args, "job"))));
+  } else if (method_call.method_name().compare("getPlatformVersion") == 0) {
     std::ostringstream version_stream;
     version_stream << "Windows ";
     if (IsWindows10OrGreater()) {
@@ -56,4 +205,98 @@ void RarPlugin::HandleMethodCall(
   }
 }
 
+void RarPlugin::StartJob(const EncodableMap *args,
+                         std::unique_ptr<MethodResult> result,
+                         bool list_job) {
+  const std::string rar_path = StringArg(args, "rarFilePath");
+  const std::string dest_path = StringArg(args, "destinationPath");
+  const std::string password = StringArg(args, "password");
+  const int64_t job = IntArg(args, "job");
+
+  if (rar_path.empty() || (!list_job && dest_path.empty())) {
+    EncodableMap value{
+        {EncodableValue("success"), EncodableValue(false)},
+        {EncodableValue("message"),
+         EncodableValue(list_job
+                            ? "rarFilePath is required"
+                            : "rarFilePath and destinationPath are required")},
+    };
+    if (list_job) {
+      value[EncodableValue("files")] = EncodableValue(EncodableList());
+    }
+    result->Success(EncodableValue(std::move(value)));
+    return;
+  }
+  if (window_ == nullptr) {
+    result->Error("no_window", "Could not create the plugin's message window");
+    return;
+  }
+
+  // JobCallback must be copyable
+  std::shared_ptr<MethodResult> shared_result(std::move(result));
+  JobCallback on_event = [this, shared_result, list_job](JobEvent &&event) {
+    const bool done = event.type == JobEvent::kDone;
+    // Progress and pages of jobs without an id have no listener
+    if (!done && event.job == 0) return;
+    Delivery delivery;
+    if (done) delivery.result = shared_result;
+    delivery.list_job = list_job;
+    delivery.event = std::move(event);
+    Post(std::move(delivery));
+  };
+
+  if (list_job) {
+    executor_->List(job, rar_path, password, std::move(on_event));
+  } else {
+    executor_->Extract(job, rar_path, dest_path, password,
+                       std::move(on_event));
+  }
+}
+
+void RarPlugin::Post(Delivery delivery) {
+  bool wake;
+  {
+    std::lock_guard<std::mutex> lock(deliveries_mutex_);
+    // One message drains the whole queue
+    wake = deliveries_.empty();
+    deliveries_.push_back(std::move(delivery));
+  }
+  if (wake) PostMessage(window_, kJobMessage, 0, 0);
+}
+
+void RarPlugin::Deliver(Delivery &delivery) {
+  const JobEvent &event = delivery.event;
+  if (event.job != 0 && events_ != nullptr) {
+    events_->Success(JobEventToValue(event));
+  }
+  if (delivery.result != nullptr) {
+    delivery.result->Success(JobResultToValue(event, delivery.list_job));
+  }
+}
+
+void RarPlugin::DrainDeliveries() {
+  std::deque<Delivery> ready;
+  {
+    std::lock_guard<std::mutex> lock(deliveries_mutex_);
+    ready.swap(deliveries_);
+  }
+  for (Delivery &delivery : ready) Deliver(delivery);
+}
+
+// static
+LRESULT CALLBACK RarPlugin::WindowProc(HWND hwnd, UINT message, WPARAM wparam,
+                                       LPARAM lparam) {
+  if (message == WM_NCCREATE) {
+    auto *create = reinterpret_cast<CREATESTRUCTW *>(lparam);
+    SetWindowLongPtrW(hwnd, GWLP_USERDATA,
+                      reinterpret_cast<LONG_PTR>(create->lpCreateParams));
+  } else if (message == kJobMessage) {
+    auto *plugin =
+        reinterpret_cast<RarPlugin *>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    if (plugin != nullptr) plugin->DrainDeliveries();
+    return 0;
+  }
+  return DefWindowProcW(hwnd, message, wparam, lparam);
+}
+
 }  // namespace rar
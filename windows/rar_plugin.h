@@ -1,10 +1,17 @@
 #ifndef FLUTTER_PLUGIN_RAR_PLUGIN_H_
 #define FLUTTER_PLUGIN_RAR_PLUGIN_H_
 
+#include <flutter/event_channel.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 
+#include <windows.h>
+
+#include <deque>
 #include <memory>
+#include <mutex>
+
+#include "rar_executor.h"
 
 namespace rar {
 
@@ -12,7 +19,10 @@ class RarPlugin : public flutter::Plugin {
  public:
   static void RegisterWithRegistrar(flutter::PluginRegistrarWindows *registrar);
 
-  RarPlugin();
+  // Job results are delivered through a message-only window on the thread
+  // that created the plugin, which must pump messages. Without a registrar
+  // (unit tests) there is no event channel, only method results.
+  explicit RarPlugin(flutter::PluginRegistrarWindows *registrar = nullptr);
 
   virtual ~RarPlugin();
 
@@ -24,6 +34,48 @@ class RarPlugin : public flutter::Plugin {
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue> &method_call,
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+ private:
+  using MethodResult = flutter::MethodResult<flutter::EncodableValue>;
+
+  // A job event on its way from a worker thread to the platform thread
+  struct Delivery {
+    std::shared_ptr<MethodResult> result;  // Set for the kDone event only
+    bool list_job = false;
+    JobEvent event;
+  };
+
+  // Queues a list or extract job and answers `result` once it is done
+  void StartJob(const flutter::EncodableMap *args,
+                std::unique_ptr<MethodResult> result, bool list_job);
+
+  // Worker threads: queue `delivery` and wake the platform thread
+  void Post(Delivery delivery);
+
+  // Platform thread: deliver everything queued by Post
+  void DrainDeliveries();
+
+  // Platform thread: send the event and, for kDone, the method result
+  void Deliver(Delivery &delivery);
+
+  static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam,
+                                     LPARAM lparam);
+
+  flutter::PluginRegistrarWindows *registrar_ = nullptr;
+  // Message-only window owned by the plugin that receives the wake-up
+  // message on the platform thread
+  HWND window_ = nullptr;
+
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>>
+      events_channel_;
+  // Set while Dart listens to the event channel
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> events_;
+
+  std::mutex deliveries_mutex_;
+  std::deque<Delivery> deliveries_;
+
+  // Runs listRarContents and extractRarFile calls off the platform thread
+  std::unique_ptr<Executor> executor_;
 };
 
 }  // namespace rar
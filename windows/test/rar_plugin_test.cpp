@@ -5,6 +5,7 @@
 #include <windows.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <variant>
 
@@ -39,5 +40,39 @@ TEST(RarPlugin, GetPlatformVersion) {
   EXPECT_TRUE(result_string.rfind("Windows ", 0) == 0);
 }
 
+TEST(RarPlugin, ListReportsMissingArchive) {
+  RarPlugin plugin;
+  // The result is delivered through the plugin's message window, on this
+  // thread, once its messages are pumped.
+  std::optional<EncodableMap> result;
+  DWORD reply_thread = 0;
+  plugin.HandleMethodCall(
+      MethodCall("listRarContents",
+                 std::make_unique<EncodableValue>(EncodableMap{
+                     {EncodableValue("rarFilePath"),
+                      EncodableValue("C:\\nonexistent\\archive.rar")},
+                     {EncodableValue("job"), EncodableValue(1)},
+                 })),
+      std::make_unique<MethodResultFunctions<>>(
+          [&result, &reply_thread](const EncodableValue* value) {
+            result = std::get<EncodableMap>(*value);
+            reply_thread = GetCurrentThreadId();
+          },
+          nullptr, nullptr));
+
+  MSG message;
+  while (!result.has_value() && GetMessage(&message, nullptr, 0, 0) > 0) {
+    TranslateMessage(&message);
+    DispatchMessage(&message);
+  }
+
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(reply_thread, GetCurrentThreadId());
+  EXPECT_FALSE(std::get<bool>((*result)[EncodableValue("success")]));
+  EXPECT_TRUE(
+      std::get<flutter::EncodableList>((*result)[EncodableValue("files")])
+          .empty());
+}
+
 }  // namespace test
 }  // namespace rar